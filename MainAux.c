@@ -2,17 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include "game.h"
-
-#define R 3
-#define C 3
+#include "geometry.h"
 
 /* MainAux Module
  	 The auxiliary functions are placed inside this module. Those are functions that
 		do not belong to any of the other modules.
 	 support the following functions:
-		 usedInRow - check if number in row
-		 usedInCol - check if number in column
-		 usedInBox - check if number in box
+		 gameGeometry - the geometry of the board, kept in the game between calls
+		 instancesInUnit - count a number in a row, column or box (with instancesInRow, instancesInCol and instancesInBox)
 		 isSafe - check if we can put a number in cell
 		 setOptionalValues - set all the optinal values for a cell
 		 fixOpptions - Removes from the optional values array the element in index 'chosenIndex'
@@ -21,105 +18,88 @@
 
 */
 
-/* Returns 1 if an assigned entry in the specified row matches the given number
- * or 0 else */
-int instancesInRow(Game game, int row, int value){
-	int col, numOfInstances = 0;
-	int errorCells = (int*) calloc(game.n*game.m, sizeof(int));
-	/* go over all the columns of the row and count how many times value appears */
-    for (col = 0; col < game.n*game.m; col++) {
-        if (board[row][col].value == value){
-        	errorCells[col] = 1;
-        	board[row][col].error = 0;
-        	numOfInstances++;
-        }
-    }
-    if(numOfInstances > 1 ){
-    	for(col = 0; col < game.n*game.m, col++){
-    		if(errorCells[col] == 1){
-    			game.board[row][col].error = 1;
-    		}
-    	}
-    }
-    free(errorCells);
-    return numOfInstances;
+const Geometry* gameGeometry(Game *game){
+	const Geometry *geo = game->geometry;
+	if(geo == NULL || geo->n != game->n || geo->m != game->m){
+		geo = getGeometry(game->n, game->m);
+		game->geometry = geo;
+	}
+	return geo;
 }
 
-/* Returns 1 if an assigned entry in the specified col matches the given number
- * or 0 else */
-int instancesInCol(Game game, int col, int value){
-	int row,  numOfInstances = 0;
-	int errorCells = (int*) calloc(game.n*game.m, sizeof(int));
-	/* go over all the columns of the row and count how many times value appears */
-    for (row = 0; row < game.n*game.m; row++){
-        if (board[row][col].value == value){
-        	errorCells[row] = 1;
-			board[row][col].error = 0;
+/* Returns the number of cells of the unit (a row, column or box, numbered as in geometry.h) that hold value */
+int instancesInUnit(Game *game, int unit, int value){
+	const Geometry *geo = gameGeometry(game);
+	const int *cells;
+	int i, numOfInstances = 0;
+	if(geo == NULL)
+		return 0;
+	cells = geo->unitCells + unit*geo->N;
+	/* go over all the cells of the unit and count how many times value appears */
+	for(i = 0; i < geo->N; i++){
+		if(game->board[geo->rowOf[cells[i]]][geo->colOf[cells[i]]].value == value)
 			numOfInstances++;
-        }
-    }
-    if(numOfInstances > 1 ){
-		for(row = 0; row < game.n*game.m, row++){
-			if(errorCells[row] == 1){
-				game.board[row][col].error = 1;
-			}
-		}
 	}
-    free(errorCells);
-    return numOfInstances;
+	return numOfInstances;
+}
+
+/* Returns the number of cells in the row that hold value, see instancesInUnit */
+int instancesInRow(Game *game, int row, int value){
+	return instancesInUnit(game, row, value);
 }
 
-/* Returns 1 if an assigned entry in the specified 3x3 box matches the given number
- * or 0 else */
-int instancesInBox(Game game, int boxStartRow, int boxStartCol, int value){
-	int row, col, i, numOfInstances = 0;
-	int errorCells = (int*) calloc(game.n*game.m, sizeof(int));
-	/* iterate all the cells in the box and counts how many time value appears*/
-    for (row = 0; row < game.n; row++){
-        for (col = 0; col < game.m; col++){
-            if (board[row+boxStartRow][col+boxStartCol].value == value){
-            	errorCells[row*game.m+col] = 1;
-            	board[row+boxStartRow][col+boxStartCol].error = 0;
-            	numOfInstances++;
-            }
-        }
-    }
-    if(numOfInstances > 1 ){
-   		for(i = 0; i < game.n*game.m, i++){
-   			if(errorCells[i] == 1){
-   				game.board[(i/game.m)+boxStartRow][(i%game.m)boxStartCol].error = 1;
-   			}
-   		}
-   	}
-    free(errorCells);
-    return numOfInstances;
+/* Returns the number of cells in the column that hold value, see instancesInUnit */
+int instancesInCol(Game *game, int col, int value){
+	return instancesInUnit(game, game->n*game->m + col, value);
+}
+
+/* Returns the number of cells in the box that hold value, see instancesInUnit.
+ * boxes are numbered row by row, the box of cell (row,col) is (row/n)*n + col/m */
+int instancesInBox(Game *game, int box, int value){
+	return instancesInUnit(game, 2*game->n*game->m + box, value);
 }
 
 /* Returns 1 if it will be legal to assign num to the given row,col location
  * or 0 if not */
-int isSafe(Game game, int row, int col, int val){
-    /* Check if 'val' is not already placed in current row,
-       current column and current 3x3 box */
-    return instancesInRow(game, row, val) == 0 &&
-    		instancesInCol(game, col, val) == 0 &&
-			instancesInBox(game, row - row%R , col - col%C, val) == 0;
+int isSafe(Game *game, int row, int col, int val){
+	const Geometry *geo = gameGeometry(game);
+	const int *peers;
+	int i;
+	if(geo == NULL)
+		return 0;
+	/* Check if 'val' is not already placed in a cell that shares the row, the column or the box */
+	peers = geo->peers + (row*geo->N + col)*geo->numPeers;
+	for(i = 0; i < geo->numPeers; i++){
+		if(game->board[geo->rowOf[peers[i]]][geo->colOf[peers[i]]].value == val)
+			return 0;
+	}
+	return 1;
 }
 
 /* fill the array of the optional values of cell (row,col)
  * and save the number of optional values */
-void setOptionalValues(Cell** board, int row, int col){
-	int index = 0;
-	int num;
-	/* check if its safe to put each of the values between 1 to 9 in cell (row,col)
-	 * if it is add this value to the optionalValues array */
-	for(num = 1; num <= (C*R); num++){
-		if (isSafe(board, row, col, num) != 0){
-			board[row][col].optionalValues[index] = num;
-			index++;
-		}
+void setOptionalValues(Game *game, int row, int col){
+	const Geometry *geo = gameGeometry(game);
+	const int *peers;
+	Cell *cell = &game->board[row][col];
+	unsigned long used = 0;
+	int i, num, index = 0;
+	if(geo == NULL)
+		return;
+	/* one pass over the peers collects the values already taken, every other value is optional */
+	peers = geo->peers + (row*geo->N + col)*geo->numPeers;
+	for(i = 0; i < geo->numPeers; i++){
+		num = game->board[geo->rowOf[peers[i]]][geo->colOf[peers[i]]].value;
+		if(num != 0)
+			used |= 1UL << (num-1);
+	}
+	/* optionalValues has room for GEOMETRY_MAX_N values, every value of a geometry fits */
+	for(num = 1; num <= geo->N; num++){
+		if(!(used & (1UL << (num-1))))
+			cell->optionalValues[index++] = num;
 	}
 	/* save the number of optional values */
-	board[row][col].numOfOptionalValues = index;
+	cell->numOfOptionalValues = index;
 }
 
 /* Removes from the optional values array the element in index 'chosenIndex'
@@ -137,29 +117,28 @@ void fixOpptions(Cell** board, int row, int col, int chosenIndex){
 
 /* Searches the grid to find an entry that is still unassigned (left to right and head
  * to bottom. If found, 1 is returned. If no unassigned entries remain, 0 is returned. */
-int findUnassignedLocation(Cell** board){
-	int row;
-	int col;
-	for (row =0; row < C*R; row++){
-	        for (col = 0; col < C*R; col++){
-	            if ((board[row][col].fixed == 0) && (board[row][col].value == 0)){
-	            	return 1;
-	            }
-	        }
+int findUnassignedLocation(Game *game){
+	const Geometry *geo = gameGeometry(game);
+	int cell;
+	if(geo == NULL)
+		return 0;
+	for(cell = 0; cell < geo->N*geo->N; cell++){
+		if(game->board[geo->rowOf[cell]][geo->colOf[cell]].fixed == 0 && game->board[geo->rowOf[cell]][geo->colOf[cell]].value == 0)
+			return 1;
 	}
 	return 0;
 }
 
 /* after running a deterministic back-tracking algorithm to validate if the board is solvable,
  * update the saved options of the board in case the user would ask for a hint */
-void updateStoredSolution(Cell **cpBaord, Cell **board){
-	int row;
-	int col;
-	for(row = 0; row < R*C; row++){
-		for(col = 0; col < R*C; col++){
-			/* save in each cell in the board the value of the new solution in the saved value field */
-			board[row][col].savedValue = cpBaord[row][col].value;
-		}
+void updateStoredSolution(Game *game, Cell **cpBaord){
+	const Geometry *geo = gameGeometry(game);
+	int cell;
+	if(geo == NULL)
+		return;
+	for(cell = 0; cell < geo->N*geo->N; cell++){
+		/* save in each cell in the board the value of the new solution in the saved value field */
+		game->board[geo->rowOf[cell]][geo->colOf[cell]].savedValue = cpBaord[geo->rowOf[cell]][geo->colOf[cell]].value;
 	}
 }
 
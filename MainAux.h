@@ -2,8 +2,6 @@
 #define MAINAUX_H_
 #include "game.h"
 
-#define R 3
-#define C 3
 #define init 0
 #define edit 2
 #define solve 1
@@ -11,33 +9,38 @@
 
 /* after running a deterministic back-tracking algorithm to validate if the board is solvable,
  * update the saved options of the board in case the user would ask for a hint */
-void updateStoredSolution(Cell **cpBaord, Cell **board);
+void updateStoredSolution(Game *game, Cell **cpBaord);
 
-/* Returns 1 if an assigned entry in the specified row matches the given number
- * or 0 else */
-int usedInRow(Cell** board, int row, int num);
+/* the geometry of the board of the game. it is looked up (under the lock of getGeometry) only when the board changed
+ * its shape since the last call, and kept in the game for the calls after it. NULL if the shape isn't supported */
+const Geometry* gameGeometry(Game *game);
 
-/* Returns 1 if an assigned entry in the specified col matches the given number
- * or 0 else */
-int usedInCol(Cell** board, int col, int num);
+/* Returns the number of cells of the unit (a row, column or box, numbered as in geometry.h) that hold num.
+ * the board isn't changed */
+int instancesInUnit(Game *game, int unit, int num);
 
-/* Returns 1 if an assigned entry in the specified 3x3 box matches the given number
- * or 0 else */
-int usedInBox(Cell** board, int boxStartRow, int boxStartCol, int num);
+/* instancesInUnit of the row */
+int instancesInRow(Game *game, int row, int num);
+
+/* instancesInUnit of the column */
+int instancesInCol(Game *game, int col, int num);
+
+/* instancesInUnit of the box, the box of cell (row,col) is (row/n)*n + col/m */
+int instancesInBox(Game *game, int box, int num);
 
 /* Searches the grid to find an entry that is still unassigned (left to right and head
  * to bottom. If found, 1 is returned. If no unassigned entries remain, 0 is returned. */
-int findUnassignedLocation(Cell** board);
+int findUnassignedLocation(Game *game);
 
 
 
 /* Returns 1 if it will be legal to assign num to the given row,col location
  * or 0 if not */
-int isSafe(Cell** board, int row, int col, int num);
+int isSafe(Game *game, int row, int col, int num);
 
 /* fill the array of the optional values of cell (row,col)
  * and save the number of optional values */
-void setOptionalValues(Cell** board, int row, int col);
+void setOptionalValues(Game *game, int row, int col);
 
 /* Removes from the optional values array the element in index 'chosenIndex'
  * and decrease by 1 the number of optional values */
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "canon.h"
+
+/* Canon Module
+ * the search runs on a Search struct: the board already transposed (when tried), the current column arrangement,
+ * the rows chosen so far and the digit relabeling they imply. the digits are relabeled by order of first appearance,
+ * which is the smallest relabeling for a fixed arrangement of the cells.
+ */
+
+typedef struct Search{
+	int n;
+	int m;
+	int N;
+	const int *board; /* the board the search arranges, already transposed if transposed is 1 */
+	int transposed;
+	int colOrder[CANON_MAX_N];
+	int rowOrder[CANON_MAX_N];
+	int rowUsed[CANON_MAX_N];
+	int bandUsed[CANON_MAX_N];
+	int stackOrder[CANON_MAX_N];
+	int innerOrder[CANON_MAX_N][CANON_MAX_N]; /* the order of the columns inside every stack slot */
+	int current[CANON_MAX_N*CANON_MAX_N]; /* the canonical rows built so far */
+	int best[CANON_MAX_N*CANON_MAX_N]; /* the smallest grid found so far */
+	int haveBest;
+	Transform bestTransform;
+	SolveControl *control;
+	long work; /* the cells relabeled so far, the search gives up past CANON_MAX_WORK */
+	int stopped; /* 1 once the search gave up, the best grid found isn't the canonical one then */
+}Search;
+
+/* relabels row of the board (read in the current column order) into out, extending relabel by first appearance.
+ * next is the next free label, the new one is returned */
+static int relabelRow(Search *search, int row, int *relabel, int next, int *out){
+	int j, value;
+	search->work += search->N;
+	for(j = 0; j < search->N; j++){
+		value = search->board[row*search->N + search->colOrder[j]];
+		if(value != 0 && relabel[value] == 0)
+			relabel[value] = next++;
+		out[j] = relabel[value];
+	}
+	return next;
+}
+
+static int compareCells(const int *a, const int *b, int count){
+	int j;
+	for(j = 0; j < count; j++){
+		if(a[j] != b[j])
+			return a[j] < b[j] ? -1 : 1;
+	}
+	return 0;
+}
+
+/* chooses the original row of canonical row depth. only the rows giving the smallest relabeled row can lead to the smallest grid,
+ * so only they are branched on, and a branch whose rows are already above the best grid is pruned */
+static void searchRows(Search *search, int depth, const int *relabel, int next){
+	int N = search->N, n = search->n;
+	int candidates[CANON_MAX_N];
+	int minRow[CANON_MAX_N], row[CANON_MAX_N];
+	int childRelabel[CANON_MAX_N+1];
+	int numCandidates = 0, prefix = 0, cmp, band, firstBand, lastBand, i, r, childNext;
+	if(search->stopped || search->work > CANON_MAX_WORK || shouldStop(search->control)){
+		search->stopped = 1;
+		return;
+	}
+	if(search->haveBest){
+		/* the best grid may have gone down since the parent compared, so compare the whole prefix again */
+		prefix = compareCells(search->current, search->best, depth*N);
+		if(prefix > 0)
+			return;
+	}
+	if(depth == N){
+		if(search->haveBest && prefix == 0)
+			return;
+		memcpy(search->best, search->current, N*N*sizeof(int));
+		search->haveBest = 1;
+		search->bestTransform.transposed = search->transposed;
+		memcpy(search->bestTransform.rowOrder, search->rowOrder, N*sizeof(int));
+		memcpy(search->bestTransform.colOrder, search->colOrder, N*sizeof(int));
+		memcpy(search->bestTransform.relabel, relabel, (N+1)*sizeof(int));
+		return;
+	}
+	/* the first row of a band may come from any unused band, the others from the band of the first */
+	if(depth % n == 0){
+		firstBand = 0;
+		lastBand = N/n - 1;
+	}
+	else{
+		firstBand = search->rowOrder[depth - depth%n] / n;
+		lastBand = firstBand;
+	}
+	for(band = firstBand; band <= lastBand; band++){
+		if(depth % n == 0 && search->bandUsed[band])
+			continue;
+		for(r = band*n; r < (band+1)*n; r++){
+			if(search->rowUsed[r])
+				continue;
+			memcpy(childRelabel, relabel, (N+1)*sizeof(int));
+			relabelRow(search, r, childRelabel, next, row);
+			cmp = numCandidates > 0 ? compareCells(row, minRow, N) : -1;
+			if(cmp < 0){
+				memcpy(minRow, row, N*sizeof(int));
+				numCandidates = 0;
+			}
+			if(cmp <= 0)
+				candidates[numCandidates++] = r;
+		}
+	}
+	if(search->haveBest && prefix == 0 && compareCells(minRow, &search->best[depth*N], N) > 0)
+		return;
+	for(i = 0; i < numCandidates && !search->stopped; i++){
+		r = candidates[i];
+		memcpy(childRelabel, relabel, (N+1)*sizeof(int));
+		childNext = relabelRow(search, r, childRelabel, next, &search->current[depth*N]);
+		search->rowOrder[depth] = r;
+		search->rowUsed[r] = 1;
+		if(depth % n == 0)
+			search->bandUsed[r/n] = 1;
+		searchRows(search, depth+1, childRelabel, childNext);
+		search->rowUsed[r] = 0;
+		if(depth % n == 0)
+			search->bandUsed[r/n] = 0;
+	}
+}
+
+/* rearranges a into the next permutation in lexicographic order. after the last one it sorts a back and returns 0 */
+static int nextPermutation(int *a, int count){
+	int i, j, tmp, found;
+	i = count - 2;
+	while(i >= 0 && a[i] >= a[i+1])
+		i--;
+	found = i >= 0;
+	if(found){
+		j = count - 1;
+		while(a[j] <= a[i])
+			j--;
+		tmp = a[i];
+		a[i] = a[j];
+		a[j] = tmp;
+	}
+	/* reverse the suffix */
+	for(i++, j = count - 1; i < j; i++, j--){
+		tmp = a[i];
+		a[i] = a[j];
+		a[j] = tmp;
+	}
+	return found;
+}
+
+/* the number of column arrangements: stacks! * (columns per stack!)^stacks, capped to avoid overflow */
+static double columnOrders(int n, int m){
+	double stackOrders = 1, innerOrders = 1, total;
+	int i;
+	for(i = 2; i <= n; i++)
+		stackOrders *= i;
+	for(i = 2; i <= m; i++)
+		innerOrders *= i;
+	total = stackOrders;
+	for(i = 0; i < n; i++)
+		total *= innerOrders;
+	return total;
+}
+
+/* tries every column arrangement the budget allows on the current board */
+static void searchColumns(Search *search){
+	int n = search->n, m = search->m, N = search->N, s, j, allInner, carry;
+	int relabel[CANON_MAX_N+1];
+	allInner = columnOrders(n, m) <= CANON_MAX_COLUMN_ORDERS;
+	for(s = 0; s < n; s++){
+		search->stackOrder[s] = s;
+		for(j = 0; j < m; j++)
+			search->innerOrder[s][j] = j;
+	}
+	do{
+		do{
+			for(s = 0; s < n; s++){
+				for(j = 0; j < m; j++)
+					search->colOrder[s*m + j] = search->stackOrder[s]*m + search->innerOrder[s][j];
+			}
+			memset(search->rowUsed, 0, sizeof(search->rowUsed));
+			memset(search->bandUsed, 0, sizeof(search->bandUsed));
+			memset(relabel, 0, (N+1)*sizeof(int));
+			searchRows(search, 0, relabel, 1);
+			/* advance the inner orders like an odometer */
+			carry = allInner;
+			for(s = 0; s < n && carry; s++)
+				carry = !nextPermutation(search->innerOrder[s], m);
+		}while(allInner && !carry && !search->stopped);
+	}while(!search->stopped && columnOrders(n, 1) <= CANON_MAX_COLUMN_ORDERS && nextPermutation(search->stackOrder, n));
+}
+
+int canonicalize(int n, int m, const int *grid, int *canonical, Transform *transform, SolveControl *control){
+	Search *search;
+	int *transposedGrid;
+	int N = n*m, i, j, next, value, filled = 0;
+	if(N > CANON_MAX_N)
+		return 0;
+	for(i = 0; i < N*N; i++)
+		filled += grid[i] != 0;
+	if(filled < CANON_MIN_FILLED_PER_N*N)
+		return 0;
+	search = (Search*)calloc(1, sizeof(Search));
+	transposedGrid = (int*)calloc(N*N, sizeof(int));
+	if(search == NULL || transposedGrid == NULL){
+		printf("Error: calloc has failed\n");
+		free(search);
+		free(transposedGrid);
+		return 0;
+	}
+	search->n = n;
+	search->m = m;
+	search->N = N;
+	search->board = grid;
+	search->transposed = 0;
+	search->control = control;
+	searchColumns(search);
+	/* with square boxes the transposed board is in the class too */
+	if(n == m && !search->stopped){
+		for(i = 0; i < N; i++){
+			for(j = 0; j < N; j++)
+				transposedGrid[i*N+j] = grid[j*N+i];
+		}
+		search->board = transposedGrid;
+		search->transposed = 1;
+		searchColumns(search);
+	}
+	if(search->stopped){
+		free(search);
+		free(transposedGrid);
+		return 0;
+	}
+	memcpy(canonical, search->best, N*N*sizeof(int));
+	*transform = search->bestTransform;
+	transform->n = n;
+	transform->m = m;
+	/* give the digits missing from the board the remaining labels, so the relabeling is a full permutation and can be undone */
+	next = 1;
+	for(value = 1; value <= N; value++){
+		if(transform->relabel[value] >= next)
+			next = transform->relabel[value] + 1;
+	}
+	for(value = 1; value <= N; value++){
+		if(transform->relabel[value] == 0)
+			transform->relabel[value] = next++;
+	}
+	free(search);
+	free(transposedGrid);
+	return 1;
+}
+
+void applyTransform(const Transform *transform, const int *grid, int *out){
+	int N = transform->n*transform->m, i, j, row, col;
+	for(i = 0; i < N; i++){
+		for(j = 0; j < N; j++){
+			row = transform->rowOrder[i];
+			col = transform->colOrder[j];
+			if(transform->transposed)
+				out[i*N+j] = transform->relabel[grid[col*N+row]];
+			else
+				out[i*N+j] = transform->relabel[grid[row*N+col]];
+		}
+	}
+}
+
+void undoTransform(const Transform *transform, const int *canonical, int *out){
+	int N = transform->n*transform->m, i, j, row, col, value;
+	int inverse[CANON_MAX_N+1];
+	inverse[0] = 0;
+	for(value = 1; value <= N; value++)
+		inverse[transform->relabel[value]] = value;
+	for(i = 0; i < N; i++){
+		for(j = 0; j < N; j++){
+			row = transform->rowOrder[i];
+			col = transform->colOrder[j];
+			if(transform->transposed)
+				out[col*N+row] = inverse[canonical[i*N+j]];
+			else
+				out[row*N+col] = inverse[canonical[i*N+j]];
+		}
+	}
+}
+
+uint64_t canonicalHash(int n, int m, const int *canonical){
+	/* FNV-1a over the geometry and the values */
+	uint64_t hash = 14695981039346656037ULL;
+	int i, N = n*m;
+	hash = (hash ^ (uint64_t)n) * 1099511628211ULL;
+	hash = (hash ^ (uint64_t)m) * 1099511628211ULL;
+	for(i = 0; i < N*N; i++)
+		hash = (hash ^ (uint64_t)canonical[i]) * 1099511628211ULL;
+	return hash;
+}
@@ -0,0 +1,48 @@
+/* Header file of the canon module. Maps a board to a canonical representative of its class under the sudoku symmetries:
+ * relabeling of the digits, permutations of the rows inside a band and of the columns inside a stack, permutations of the
+ * bands and of the stacks, and transposition when the boxes are square (n == m). Isomorphic boards get the same canonical grid,
+ * and the returned transform maps results found for the canonical grid (e.g. a solution) back to the orientation of the input.
+ * The canonical grid is the lexicographically smallest (row by row) image of the board. For every column arrangement the smallest
+ * row arrangement is found greedily row by row, branching only on ties. The column arrangements are enumerated exhaustively when
+ * there are at most CANON_MAX_COLUMN_ORDERS of them (every geometry up to 9x9); beyond that only the stack orders are tried, which
+ * still gives an isomorphic representative but may miss some duplicates.
+ * Ties multiply on sparse boards (every row of an empty board ties with every other), so the search is capped: a board with
+ * fewer than CANON_MIN_FILLED_PER_N * N filled cells isn't canonicalized, and neither is one whose search relabels more than
+ * CANON_MAX_WORK cells or is stopped by its control. Such a board simply has no canonical form; a finished search is exact.
+ * Grids are flat N*N arrays of values in row major order, 0 for an empty cell.*/
+
+#ifndef CANON_H_
+#define CANON_H_
+#include <stdint.h>
+#include "control.h"
+
+#define CANON_MAX_N 64
+#define CANON_MAX_COLUMN_ORDERS 20000
+#define CANON_MIN_FILLED_PER_N 1 /* a board with fewer than this many filled cells per row on average is too sparse */
+#define CANON_MAX_WORK 20000000 /* the cells a search may relabel before it gives up */
+
+/* canonical[i][j] = relabel[T(original)[rowOrder[i]][colOrder[j]]], where T transposes the board if transposed is 1 */
+typedef struct Transform{
+	int n;
+	int m;
+	int transposed;
+	int rowOrder[CANON_MAX_N];
+	int colOrder[CANON_MAX_N];
+	int relabel[CANON_MAX_N+1]; /* relabel[0] is always 0 */
+}Transform;
+
+/* puts the canonical form of grid (geometry n x m) in canonical and the transform that maps grid to it in transform.
+ * grid and canonical may not overlap. control (may be NULL) stops the search like it stops a solver.
+ * returns 1 on success, 0 if N is larger than CANON_MAX_N, the board is too sparse, or the search ran out of work or was stopped */
+int canonicalize(int n, int m, const int *grid, int *canonical, Transform *transform, SolveControl *control);
+
+/* applies the transform to grid (in its original orientation) and puts the result in out */
+void applyTransform(const Transform *transform, const int *grid, int *out);
+
+/* maps canonical (a grid in the canonical orientation, e.g. its solution) back to the orientation of the original grid */
+void undoTransform(const Transform *transform, const int *canonical, int *out);
+
+/* a 64 bit hash of a canonical grid and its geometry */
+uint64_t canonicalHash(int n, int m, const int *canonical);
+
+#endif /* CANON_H_ */
@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "catalogue.h"
+#include "geometry.h"
+
+/* Catalogue Module
+ * a geometry is enumerated twice by a back-tracking over the cells in order, with a bitmask of the used values of every
+ * row, column and box: the first pass counts the grids and gives up past CATALOGUE_MAX_GRIDS, the second sets the bits
+ * of every grid in the planes. a geometry that was tried is remembered either way, so a large one is tried only once.
+ */
+
+typedef struct Catalogue{
+	int N;
+	long numGrids;
+	int words; /* words of a plane */
+	uint64_t *planes; /* numCells*N planes of words each, plane (cell, value) is at (cell*N + value-1)*words */
+}Catalogue;
+
+typedef struct Enumeration{
+	const Geometry *geo;
+	int *values; /* the grid so far */
+	int *rowUsed;
+	int *colUsed;
+	int *boxUsed;
+	long numGrids;
+	Catalogue *catalogue; /* NULL while counting */
+}Enumeration;
+
+/* catalogues[n][m], NULL if the geometry has none. tried[n][m] once the geometry was enumerated */
+static Catalogue *catalogues[CATALOGUE_MAX_N+1][CATALOGUE_MAX_N+1];
+static int tried[CATALOGUE_MAX_N+1][CATALOGUE_MAX_N+1];
+static pthread_mutex_t cataloguesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int popcount64(uint64_t word){
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+}
+
+/* adds the grid in the values to the planes */
+static void recordGrid(Enumeration *e){
+	Catalogue *cat = e->catalogue;
+	uint64_t bit = (uint64_t)1 << (e->numGrids % 64);
+	long word = e->numGrids / 64;
+	int cell;
+	for(cell = 0; cell < e->geo->numCells; cell++)
+		cat->planes[(size_t)(cell*cat->N + e->values[cell]-1)*cat->words + word] |= bit;
+}
+
+/* fills the cells from cell on, every grid is counted (and recorded if there is a catalogue).
+ * returns 0 once there are more than CATALOGUE_MAX_GRIDS grids */
+static int enumerate(Enumeration *e, int cell){
+	const Geometry *geo = e->geo;
+	int row, col, box, value, bit, used;
+	if(cell == geo->numCells){
+		if(e->catalogue != NULL)
+			recordGrid(e);
+		return ++e->numGrids <= CATALOGUE_MAX_GRIDS;
+	}
+	row = geo->rowOf[cell];
+	col = geo->colOf[cell];
+	box = geo->boxOf[cell];
+	used = e->rowUsed[row] | e->colUsed[col] | e->boxUsed[box];
+	for(value = 1; value <= geo->N; value++){
+		bit = 1 << (value-1);
+		if(used & bit)
+			continue;
+		e->values[cell] = value;
+		e->rowUsed[row] |= bit;
+		e->colUsed[col] |= bit;
+		e->boxUsed[box] |= bit;
+		if(!enumerate(e, cell+1))
+			return 0;
+		e->rowUsed[row] &= ~bit;
+		e->colUsed[col] &= ~bit;
+		e->boxUsed[box] &= ~bit;
+	}
+	return 1;
+}
+
+/* runs an enumeration of the geometry into cat (NULL to count only).
+ * returns the number of grids, 0 if there are too many and -1 on a memory error */
+static long runEnumeration(const Geometry *geo, Catalogue *cat){
+	Enumeration e;
+	long res = -1;
+	e.geo = geo;
+	e.values = (int*)calloc(geo->numCells, sizeof(int));
+	e.rowUsed = (int*)calloc(geo->N, sizeof(int));
+	e.colUsed = (int*)calloc(geo->N, sizeof(int));
+	e.boxUsed = (int*)calloc(geo->N, sizeof(int));
+	e.numGrids = 0;
+	e.catalogue = cat;
+	if(e.values != NULL && e.rowUsed != NULL && e.colUsed != NULL && e.boxUsed != NULL)
+		res = enumerate(&e, 0) ? e.numGrids : 0;
+	free(e.values);
+	free(e.rowUsed);
+	free(e.colUsed);
+	free(e.boxUsed);
+	return res;
+}
+
+/* the catalogue of the geometry, NULL if it has too many grids or on a memory error. the lock is held */
+static Catalogue* buildCatalogue(int n, int m){
+	const Geometry *geo = getGeometry(n, m);
+	Catalogue *cat;
+	long numGrids;
+	if(geo == NULL)
+		return NULL;
+	numGrids = runEnumeration(geo, NULL);
+	if(numGrids <= 0)
+		return NULL;
+	cat = (Catalogue*)calloc(1, sizeof(Catalogue));
+	if(cat == NULL)
+		return NULL;
+	cat->N = geo->N;
+	cat->numGrids = numGrids;
+	cat->words = (int)((numGrids + 63) / 64);
+	cat->planes = (uint64_t*)calloc((size_t)geo->numCells*geo->N*cat->words, sizeof(uint64_t));
+	if(cat->planes == NULL || runEnumeration(geo, cat) != numGrids){
+		free(cat->planes);
+		free(cat);
+		return NULL;
+	}
+	return cat;
+}
+
+/* the catalogue of the geometry, built on the first call. NULL if it has none */
+static Catalogue* getCatalogue(int n, int m){
+	Catalogue *cat;
+	if(n <= 0 || m <= 0 || n*m > CATALOGUE_MAX_N)
+		return NULL;
+	pthread_mutex_lock(&cataloguesLock);
+	if(!tried[n][m]){
+		catalogues[n][m] = buildCatalogue(n, m);
+		tried[n][m] = 1;
+	}
+	cat = catalogues[n][m];
+	pthread_mutex_unlock(&cataloguesLock);
+	return cat;
+}
+
+int hasCatalogue(int n, int m){
+	return getCatalogue(n, m) != NULL;
+}
+
+/* the grids that complete the board, the AND of the planes of its filled cells, in a new bitset.
+ * NULL on a memory error */
+static uint64_t* matchingGrids(const Catalogue *cat, Game *game){
+	int N = cat->N, row, col, value, i;
+	const uint64_t *plane;
+	uint64_t *match = (uint64_t*)malloc((size_t)cat->words*sizeof(uint64_t));
+	if(match == NULL){
+		printf("Error: calloc has failed\n");
+		return NULL;
+	}
+	for(i = 0; i < cat->words; i++)
+		match[i] = ~(uint64_t)0;
+	if(cat->numGrids % 64 != 0)
+		match[cat->words-1] = ((uint64_t)1 << (cat->numGrids % 64)) - 1;
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			value = game->board[row][col].value;
+			if(value == 0)
+				continue;
+			plane = cat->planes + (size_t)((row*N + col)*N + value-1)*cat->words;
+			for(i = 0; i < cat->words; i++)
+				match[i] &= plane[i];
+		}
+	}
+	return match;
+}
+
+int catalogueCount(Game *game, long *count){
+	Catalogue *cat = getCatalogue(game->n, game->m);
+	uint64_t *match;
+	int i;
+	if(cat == NULL)
+		return -1;
+	match = matchingGrids(cat, game);
+	if(match == NULL)
+		return -1;
+	*count = 0;
+	for(i = 0; i < cat->words; i++)
+		*count += popcount64(match[i]);
+	free(match);
+	return 1;
+}
+
+int catalogueSolve(Game *game, int *solution){
+	Catalogue *cat = getCatalogue(game->n, game->m);
+	uint64_t *match, bit;
+	int N, i, cell, value;
+	long word;
+	if(cat == NULL)
+		return -1;
+	N = cat->N;
+	match = matchingGrids(cat, game);
+	if(match == NULL)
+		return -1;
+	for(i = 0; i < cat->words && match[i] == 0; i++);
+	if(i == cat->words){
+		free(match);
+		return 0;
+	}
+	if(solution != NULL){
+		/* the lowest matching grid, read back cell by cell from the planes */
+		word = i;
+		bit = match[i] & (~match[i] + 1);
+		for(cell = 0; cell < N*N; cell++){
+			for(value = 1; value <= N; value++){
+				if(cat->planes[(size_t)(cell*N + value-1)*cat->words + word] & bit)
+					break;
+			}
+			solution[cell] = value;
+		}
+	}
+	free(match);
+	return 1;
+}
+
+void freeCatalogues(){
+	int n, m;
+	pthread_mutex_lock(&cataloguesLock);
+	for(n = 1; n <= CATALOGUE_MAX_N; n++){
+		for(m = 1; n*m <= CATALOGUE_MAX_N; m++){
+			if(catalogues[n][m] != NULL){
+				free(catalogues[n][m]->planes);
+				free(catalogues[n][m]);
+			}
+			catalogues[n][m] = NULL;
+			tried[n][m] = 0;
+		}
+	}
+	pthread_mutex_unlock(&cataloguesLock);
+}
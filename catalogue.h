@@ -0,0 +1,33 @@
+/* Header file of the catalogue module. Every solution grid of the smallest geometries, enumerated once at the first
+ * query of the geometry and kept for the rest of the program, so counting, validating, solving and hinting their boards
+ * is a scan of bitsets instead of a search.
+ * A catalogue is a bitset over its grids for every cell and value: bit g of plane (cell, value) is set if grid g has the
+ * value in the cell. The grids that complete a board are the AND of the planes of its filled cells, 64 grids a word;
+ * their count is the popcount of the result, and any of them is read back from the planes. That is N^3 bits a grid
+ * (8 bytes for a 2x2 grid), 2.3KB for the 288 grids of 2x2 and 2.5MB for the 161280 of 1x5.
+ * Only geometries of side up to CATALOGUE_MAX_N with at most CATALOGUE_MAX_GRIDS grids are catalogued. 2x3 has
+ * 28200960 grids (760MB of planes), it is solved as any other board.
+ * Catalogues are read only once built, like the geometries, so all the threads share them.*/
+
+#ifndef CATALOGUE_H_
+#define CATALOGUE_H_
+#include "game.h"
+
+#define CATALOGUE_MAX_N 5 /* the largest side that is enumerated */
+#define CATALOGUE_MAX_GRIDS 262144 /* a geometry with more grids isn't catalogued */
+
+/* 1 if the boards of the geometry are answered by the catalogue, which is built on the first call */
+int hasCatalogue(int n, int m);
+
+/* counts the solutions of the board of the game, whose geometry has a catalogue.
+ * returns 1 (the count is exact) or -1 on an error */
+int catalogueCount(Game *game, long *count);
+
+/* puts a solution of the board of the game, whose geometry has a catalogue, in solution (N*N, row by row), unless it
+ * is NULL. returns 1 if solved, 0 if the board has no solution and -1 on an error */
+int catalogueSolve(Game *game, int *solution);
+
+/* free all the catalogues */
+void freeCatalogues();
+
+#endif /* CATALOGUE_H_ */
@@ -0,0 +1,81 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <time.h>
+#include "control.h"
+
+/* Control Module
+ * shared stop requests and time budgets for the long running solver operations, and the restart schedule they share.
+ * the clock is read only once every CLOCK_CHECK_INTERVAL calls to shouldStop,
+ * so the solvers can call it in their innermost loop.
+ */
+
+#define CLOCK_CHECK_INTERVAL 1024
+
+double monotonicSeconds(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void initControl(SolveControl *control, double timeout){
+	control->cancelled = 0;
+	control->progress = 0;
+	control->stopReason = STOP_NONE;
+	control->checks = 0;
+	if(timeout > 0)
+		control->deadline = monotonicSeconds() + timeout;
+	else
+		control->deadline = 0;
+}
+
+int shouldStop(SolveControl *control){
+	if(control == NULL)
+		return 0;
+	if(control->stopReason != STOP_NONE)
+		return 1;
+	if(control->cancelled){
+		control->stopReason = STOP_CANCELLED;
+		return 1;
+	}
+	/* read the clock only once in a while, it is much slower than the flag */
+	if(control->deadline > 0 && ++control->checks >= CLOCK_CHECK_INTERVAL){
+		control->checks = 0;
+		if(monotonicSeconds() >= control->deadline){
+			control->stopReason = STOP_TIMEOUT;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int deadlinePassed(SolveControl *control){
+	if(control == NULL || control->deadline <= 0 || monotonicSeconds() < control->deadline)
+		return 0;
+	if(control->stopReason == STOP_NONE)
+		control->stopReason = STOP_TIMEOUT;
+	return 1;
+}
+
+long luby(long i){
+	long size = 1, power = 1;
+	/* find the smallest complete block 2^k - 1 that holds term i, then look inside it */
+	while(size < i + 1){
+		size = 2*size + 1;
+		power *= 2;
+	}
+	while(size - 1 != i){
+		size /= 2;
+		power /= 2;
+		i %= size;
+	}
+	return power;
+}
+
+double remainingTime(SolveControl *control){
+	double left;
+	if(control == NULL || control->deadline == 0)
+		return 0;
+	left = control->deadline - monotonicSeconds();
+	/* a budget that already ran out still has to stop the solver, so never return the "no budget" value */
+	return left > 0 ? left : 1e-3;
+}
@@ -0,0 +1,42 @@
+/* Header file of the control module. A SolveControl is shared between a running solver and whoever may want to stop it:
+ * the command loop (cancel command), the SIGINT handler, or the time budget of the command.
+ * Every long solver loop calls shouldStop every iteration and stops cleanly when it returns 1, leaving its partial result behind.
+ * A NULL control means the solver runs to the end.*/
+
+#ifndef CONTROL_H_
+#define CONTROL_H_
+#include <signal.h>
+
+#define STOP_NONE 0
+#define STOP_CANCELLED 1
+#define STOP_TIMEOUT 2
+
+typedef struct SolveControl{
+	volatile sig_atomic_t cancelled; /* set to 1 (from any thread or a signal handler) to ask the solver to stop */
+	double deadline; /* monotonic time in seconds after which the solver stops, 0 for no time budget */
+	volatile long progress; /* solver specific progress, e.g. the number of solutions counted so far */
+	int stopReason; /* why the solver stopped - STOP_NONE, STOP_CANCELLED or STOP_TIMEOUT */
+	int checks; /* number of shouldStop calls, used to read the clock only once in a while */
+}SolveControl;
+
+/* reset the control and start its time budget, timeout of 0 means no budget */
+void initControl(SolveControl *control, double timeout);
+
+/* returns 1 if the solver using the control should stop (and records why), 0 if it may continue */
+int shouldStop(SolveControl *control);
+
+/* returns 1 if the time budget of the control ran out (and records it as why the solver stops), 0 otherwise.
+ * unlike shouldStop it reads the clock on every call, for the loops that poll the control only once in a while */
+int deadlinePassed(SolveControl *control);
+
+/* the i-th term (from 0) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., the restart schedule of the searches
+ * and of the SAT solver */
+long luby(long i);
+
+/* the number of seconds left in the time budget of the control, or 0 if it has no budget */
+double remainingTime(SolveControl *control);
+
+/* seconds since an arbitrary point, from a clock that never goes back */
+double monotonicSeconds();
+
+#endif /* CONTROL_H_ */
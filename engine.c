@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "engine.h"
+#include "sat.h"
+#include "solver.h"
+#include "portfolio.h"
+#include "selector.h"
+#include "trace.h"
+#include "catalogue.h"
+
+/* Engine Module
+ * a thin dispatch between the back-tracking, the ILP, the SAT solver and the portfolio race. the engine of the game is
+ * set with the engine command, ENGINE_AUTO (the default) asks the selector for the engine of every board.
+ * the catalogued geometries never reach the solvers, and their answers aren't timed for the selector.
+ * the features of a board are extracted when the selector picks its engine or a timing log collects the timings of
+ * every engine. a board whose propagation already found a contradiction is answered from the features. a portfolio
+ * race is timed for its winner, which ran alongside the losers - so its time is an upper bound of the time alone.
+ */
+
+static const char *engineNames[] = {"auto", "ilp", "sat", "portfolio", "backtrack", "catalogue"};
+
+/* the engine of every solver of the portfolio race */
+static const int portfolioEngines[PORTFOLIO_SOLVERS] = {ENGINE_BACKTRACK, ENGINE_ILP, ENGINE_SAT};
+
+/* the engine the size of the board alone picks, when the selector can't compute the features */
+static int sizeEngine(Game *game){
+	/* the ILP has N^3 variables and its model grows past what the optimizer handles quickly from 16x16 up */
+	return game->n*game->m >= ENGINE_SAT_MIN_N ? ENGINE_SAT : ENGINE_ILP;
+}
+
+/* the engine for the board, given its features (NULL if they couldn't be computed) */
+static int pickEngine(Game *game, const BoardFeatures *features){
+	if(game->engine != ENGINE_AUTO)
+		return game->engine;
+	if(features == NULL)
+		return sizeEngine(game);
+	return selectEngine(features, NULL);
+}
+
+int chooseEngine(Game *game){
+	BoardFeatures features;
+	if(hasCatalogue(game->n, game->m))
+		return ENGINE_CATALOGUE;
+	if(game->engine != ENGINE_AUTO)
+		return game->engine;
+	return pickEngine(game, extractFeatures(game, &features) ? &features : NULL);
+}
+
+const char* engineName(int engine){
+	if(engine < ENGINE_AUTO || engine > ENGINE_CATALOGUE)
+		return "unknown";
+	return engineNames[engine];
+}
+
+int parseEngineName(const char *name){
+	int engine;
+	for(engine = ENGINE_AUTO; engine <= ENGINE_BACKTRACK; engine++){
+		if(strcmp(name, engineNames[engine]) == 0)
+			return engine;
+	}
+	return -1;
+}
+
+int engineSolve(Game *game, SolveControl *control, int *solution, int *engine){
+	BoardFeatures features;
+	int haveFeatures, timed, winner, res;
+	double start;
+	if(hasCatalogue(game->n, game->m)){
+		*engine = ENGINE_CATALOGUE;
+		return catalogueSolve(game, solution);
+	}
+	/* a fixed engine needs the features only for the timing log, don't pay for them on every solve */
+	haveFeatures = (game->engine == ENGINE_AUTO || timingLogOpen()) && extractFeatures(game, &features);
+	*engine = pickEngine(game, haveFeatures ? &features : NULL);
+	if(haveFeatures && features.contradiction)
+		return 0;
+	timed = *engine;
+	start = monotonicSeconds();
+	TRACE_BEGIN(engineName(*engine));
+	switch(*engine){
+	case ENGINE_PORTFOLIO:
+		res = portfolioSolve(game, control, solution, &winner);
+		timed = winner >= 0 ? portfolioEngines[winner] : -1;
+		break;
+	case ENGINE_BACKTRACK:
+		res = backtrackSolve(game, control, solution);
+		break;
+	case ENGINE_SAT:
+		res = satSolveBoard(game, control, solution);
+		break;
+	default:
+		res = ilpSolveBoard(game, control, solution);
+		break;
+	}
+	TRACE_END(engineName(*engine));
+	/* only an answer says how long the engine takes on such a board */
+	if(haveFeatures && timed >= 0 && (res == 0 || res == 1))
+		recordTiming(&features, timed, monotonicSeconds() - start);
+	return res;
+}
+
+int engineSolvable(Game *game, SolveControl *control, int *engine){
+	return engineSolve(game, control, NULL, engine);
+}
+
+int engineCount(Game *game, SolveControl *control, long *count, const char **source){
+	int engine = game->engine;
+	if(hasCatalogue(game->n, game->m)){
+		*source = "catalogue";
+		return catalogueCount(game, count);
+	}
+	if(engine == ENGINE_AUTO || engine == ENGINE_PORTFOLIO)
+		engine = sizeEngine(game);
+	if(engine == ENGINE_SAT){
+		*source = "sat";
+		return satCountSolutions(game, control, LONG_MAX, count);
+	}
+	*source = "backtrack";
+	return countSolutions(game, control, count);
+}
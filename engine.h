@@ -0,0 +1,45 @@
+/* Header file of the engine module. Chooses the solver that answers solve, validate, hint, generate and num_solutions:
+ * the back-tracking of the solver module, the Gurobi ILP, the built-in CDCL SAT solver (see sat.h) that needs no license
+ * and scales to the large boards where the ILP model gets slow, or a race of all of them (see portfolio.h).
+ * In auto mode the selector (see selector.h) picks the engine of every board from its features.
+ * The geometries with a catalogue of all their grids are answered from it whatever the engine.*/
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+#include "game.h"
+#include "control.h"
+
+#define ENGINE_AUTO 0
+#define ENGINE_ILP 1
+#define ENGINE_SAT 2
+#define ENGINE_PORTFOLIO 3 /* races all the solvers, see portfolio.h */
+#define ENGINE_BACKTRACK 4
+#define ENGINE_CATALOGUE 5 /* the boards of the smallest geometries, answered from their catalogue (see catalogue.h) */
+
+#define ENGINE_SAT_MIN_N 16 /* the smallest side auto gives to the SAT solver when it can't compute the features of the board */
+
+/* the engine that will solve the board of the game, resolving ENGINE_AUTO with the selector */
+int chooseEngine(Game *game);
+
+/* "auto", "ilp", "sat", "portfolio", "backtrack" or "catalogue" */
+const char* engineName(int engine);
+
+/* the engine named by name, or -1 if there is no such engine */
+int parseEngineName(const char *name);
+
+/* solves the board with the chosen engine, which is put in *engine, and puts the value of every cell in solution
+ * (N*N, row by row). the times of the answers are recorded with the selector (see selector.h for which are), and a board
+ * whose features already show a contradiction is answered without a solver.
+ * returns 1 if solved, 0 if the board has no solution, 2 if the control stopped the search and -1 on an error */
+int engineSolve(Game *game, SolveControl *control, int *solution, int *engine);
+
+/* returns 1 if the board is solvable, 0 if it isn't, 2 if the control stopped the check and -1 on an error */
+int engineSolvable(Game *game, SolveControl *control, int *engine);
+
+/* counts the solutions of the board. the SAT engine blocks every solution it finds and solves again, which wins
+ * on large boards with few solutions; the ILP engine counts with the exhaustive back-tracking of the solver module.
+ * a count can't be raced or predicted from the features of a solve, the portfolio and auto engines count by the size of the board. *source gets the name of the counter.
+ * returns 1 if *count is exact, 0 if the control stopped the count (*count is then a lower bound) and -1 on an error */
+int engineCount(Game *game, SolveControl *control, long *count, const char **source);
+
+#endif /* ENGINE_H_ */
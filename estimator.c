@@ -0,0 +1,319 @@
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "estimator.h"
+#include "geometry.h"
+#include "trace.h"
+
+/* Estimator Module
+ * the probes run on one thread per processor. every thread copies the board once
+ * and takes every probe back along the trail of its steps, and has its own random stream (split from the stream of the game), and adds its probes to the shared Estimate in batches.
+ * the calling thread only watches the control and the width of the interval, and tells the threads when to stop.
+ */
+
+#define MAX_THREADS 16
+#define PROBES_PER_BATCH 32
+#define POLL_NANOSECONDS 5000000L
+
+/* one step of a probe: the value bit put in the cell, which was at place of the empty cells */
+typedef struct ProbeStep{
+	int cell;
+	int place;
+	unsigned long bit;
+}ProbeStep;
+
+/* the board as the probes see it: the empty cells and the used values of every row, column and box as bit masks */
+typedef struct ProbeBoard{
+	const Geometry *geo;
+	int N;
+	unsigned long *rowUsed;
+	unsigned long *colUsed;
+	unsigned long *boxUsed;
+	int *emptyCells; /* the empty cells, the first numEmpty of them are still empty */
+	int numEmpty;
+	ProbeStep *trail; /* the steps of the current probe */
+	int trailLen;
+}ProbeBoard;
+
+/* shared by the threads of one estimation */
+typedef struct Estimation{
+	ProbeBoard *base;
+	long maxSamples;
+	volatile int stop;
+	pthread_mutex_t lock; /* protects result */
+	Estimate result;
+}Estimation;
+
+typedef struct ProbeThread{
+	pthread_t thread;
+	Estimation *estimation;
+	ProbeBoard board;
+	Rng rng;
+}ProbeThread;
+
+/* log(exp(a)+exp(b)) without overflowing */
+static double logAdd(double a, double b){
+	if(a == -HUGE_VAL)
+		return b;
+	if(b == -HUGE_VAL)
+		return a;
+	if(a < b)
+		return b + log1p(exp(a - b));
+	return a + log1p(exp(b - a));
+}
+
+static int countBits(unsigned long mask){
+	int count = 0;
+	while(mask){
+		mask &= mask - 1;
+		count++;
+	}
+	return count;
+}
+
+static void freeProbeBoard(ProbeBoard *board){
+	free(board->rowUsed);
+	free(board->colUsed);
+	free(board->boxUsed);
+	free(board->emptyCells);
+	free(board->trail);
+}
+
+/* allocate an empty probe board of the geometry n x m, returns 0 on a memory error */
+static int allocProbeBoard(ProbeBoard *board, const Geometry *geo){
+	int N = geo->N;
+	board->geo = geo;
+	board->N = N;
+	board->numEmpty = 0;
+	board->trailLen = 0;
+	board->rowUsed = (unsigned long*)calloc(N, sizeof(unsigned long));
+	board->colUsed = (unsigned long*)calloc(N, sizeof(unsigned long));
+	board->boxUsed = (unsigned long*)calloc(N, sizeof(unsigned long));
+	board->emptyCells = (int*)calloc(N*N, sizeof(int));
+	board->trail = (ProbeStep*)calloc(N*N, sizeof(ProbeStep));
+	if(board->rowUsed == NULL || board->colUsed == NULL || board->boxUsed == NULL || board->emptyCells == NULL || board->trail == NULL){
+		freeProbeBoard(board);
+		return 0;
+	}
+	return 1;
+}
+
+static void copyProbeBoard(ProbeBoard *to, ProbeBoard *from){
+	int N = from->N;
+	memcpy(to->rowUsed, from->rowUsed, N*sizeof(unsigned long));
+	memcpy(to->colUsed, from->colUsed, N*sizeof(unsigned long));
+	memcpy(to->boxUsed, from->boxUsed, N*sizeof(unsigned long));
+	memcpy(to->emptyCells, from->emptyCells, from->numEmpty*sizeof(int));
+	to->numEmpty = from->numEmpty;
+	to->trailLen = 0;
+}
+
+/* take back the steps of the last probe, newest first, leaving the board as it was copied */
+static void undoProbe(ProbeBoard *board){
+	const Geometry *geo = board->geo;
+	ProbeStep *step;
+	while(board->trailLen > 0){
+		step = &board->trail[--board->trailLen];
+		board->rowUsed[geo->rowOf[step->cell]] &= ~step->bit;
+		board->colUsed[geo->colOf[step->cell]] &= ~step->bit;
+		board->boxUsed[geo->boxOf[step->cell]] &= ~step->bit;
+		board->numEmpty++;
+		board->emptyCells[step->place] = step->cell;
+	}
+}
+
+/* walk one random path down the back-tracking tree from the board of the thread, and take it back. returns the log of the product of the numbers of candidates
+ * along the path if it ends in a solution, -HUGE_VAL if it hits a cell without candidates.
+ * *logNodes gets the log of the sum of the partial products, the estimate of the size of the tree */
+static double probe(ProbeThread *thread, double *logNodes){
+	ProbeBoard *board = &thread->board;
+	const Geometry *geo = board->geo;
+	ProbeStep *step;
+	int N = board->N, i, best, bestCount, count, cell, pick;
+	unsigned long full = (N == (int)(8*sizeof(unsigned long))) ? ~0UL : (1UL << N) - 1;
+	unsigned long candidates, bestCandidates = 0;
+	double logEstimate = 0;
+	*logNodes = 0;
+	while(board->numEmpty > 0){
+		/* branch on the most constrained cell - any choice that depends only on the board keeps the estimate unbiased,
+		 * and this one keeps its variance low */
+		best = -1;
+		bestCount = N+1;
+		for(i = 0; i < board->numEmpty; i++){
+			cell = board->emptyCells[i];
+			candidates = full & ~(board->rowUsed[geo->rowOf[cell]] | board->colUsed[geo->colOf[cell]] | board->boxUsed[geo->boxOf[cell]]);
+			count = countBits(candidates);
+			if(count < bestCount){
+				best = i;
+				bestCount = count;
+				bestCandidates = candidates;
+				if(count <= 1)
+					break;
+			}
+		}
+		if(bestCount == 0){
+			undoProbe(board);
+			return -HUGE_VAL;
+		}
+		logEstimate += log(bestCount);
+		*logNodes = logAdd(*logNodes, logEstimate);
+		/* put a random one of the candidates in the cell */
+		pick = rngBelow(&thread->rng, bestCount);
+		while(pick-- > 0)
+			bestCandidates &= bestCandidates - 1;
+		bestCandidates &= ~(bestCandidates - 1);
+		cell = board->emptyCells[best];
+		step = &board->trail[board->trailLen++];
+		step->cell = cell;
+		step->place = best;
+		step->bit = bestCandidates;
+		board->rowUsed[geo->rowOf[cell]] |= bestCandidates;
+		board->colUsed[geo->colOf[cell]] |= bestCandidates;
+		board->boxUsed[geo->boxOf[cell]] |= bestCandidates;
+		board->emptyCells[best] = board->emptyCells[--board->numEmpty];
+	}
+	undoProbe(board);
+	return logEstimate;
+}
+
+static void* probeThread(void *arg){
+	ProbeThread *thread = (ProbeThread*)arg;
+	Estimation *estimation = thread->estimation;
+	Estimate batch;
+	double logValue, logNodes;
+	int i;
+	TRACE_BEGIN("probes");
+	while(!estimation->stop){
+		batch.samples = 0;
+		batch.logSum = -HUGE_VAL;
+		batch.logSumSq = -HUGE_VAL;
+		batch.logNodeSum = -HUGE_VAL;
+		for(i = 0; i < PROBES_PER_BATCH && !estimation->stop; i++){
+			logValue = probe(thread, &logNodes);
+			batch.samples++;
+			batch.logSum = logAdd(batch.logSum, logValue);
+			if(logValue != -HUGE_VAL)
+				batch.logSumSq = logAdd(batch.logSumSq, 2*logValue);
+			batch.logNodeSum = logAdd(batch.logNodeSum, logNodes);
+		}
+		pthread_mutex_lock(&estimation->lock);
+		if(estimation->result.samples >= estimation->maxSamples){
+			estimation->stop = 1;
+		}
+		else{
+			estimation->result.samples += batch.samples;
+			estimation->result.logSum = logAdd(estimation->result.logSum, batch.logSum);
+			estimation->result.logSumSq = logAdd(estimation->result.logSumSq, batch.logSumSq);
+			estimation->result.logNodeSum = logAdd(estimation->result.logNodeSum, batch.logNodeSum);
+		}
+		pthread_mutex_unlock(&estimation->lock);
+	}
+	TRACE_END("probes");
+	return NULL;
+}
+
+double estimateLogMean(Estimate *estimate){
+	if(estimate->samples == 0)
+		return -HUGE_VAL;
+	return estimate->logSum - log(estimate->samples);
+}
+
+double estimateRelativeWidth(Estimate *estimate){
+	double ratio;
+	if(estimate->samples < 2 || estimate->logSum == -HUGE_VAL)
+		return HUGE_VAL;
+	/* E[X^2]/E[X]^2 - 1 is the relative variance of a single probe */
+	ratio = exp(estimate->logSumSq - log(estimate->samples) - 2*estimateLogMean(estimate));
+	if(ratio < 1)
+		ratio = 1;
+	return 1.96 * sqrt((ratio - 1) / (estimate->samples - 1));
+}
+
+double estimateLogNodes(Estimate *estimate){
+	if(estimate->samples == 0)
+		return -HUGE_VAL;
+	return estimate->logNodeSum - log(estimate->samples);
+}
+
+int estimateSolutions(Game *game, long maxSamples, double targetWidth, SolveControl *control, Estimate *result){
+	Estimation estimation;
+	ProbeThread threads[MAX_THREADS];
+	ProbeBoard base;
+	struct timespec poll;
+	int numThreads, started, i, row, col, val, N = game->n*game->m;
+	long done;
+	const Geometry *geo;
+	if(N > (int)(8*sizeof(unsigned long)))
+		return 0;
+	geo = getGeometry(game->n, game->m);
+	if(geo == NULL || !allocProbeBoard(&base, geo))
+		return -1;
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			val = game->board[row][col].value;
+			if(val == 0){
+				base.emptyCells[base.numEmpty++] = row*N+col;
+			}
+			else{
+				base.rowUsed[row] |= 1UL << (val-1);
+				base.colUsed[col] |= 1UL << (val-1);
+				base.boxUsed[geo->boxOf[row*N+col]] |= 1UL << (val-1);
+			}
+		}
+	}
+	estimation.base = &base;
+	estimation.maxSamples = maxSamples;
+	estimation.stop = 0;
+	estimation.result.samples = 0;
+	estimation.result.logSum = -HUGE_VAL;
+	estimation.result.logSumSq = -HUGE_VAL;
+	estimation.result.logNodeSum = -HUGE_VAL;
+	pthread_mutex_init(&estimation.lock, NULL);
+	numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(numThreads < 1)
+		numThreads = 1;
+	if(numThreads > MAX_THREADS)
+		numThreads = MAX_THREADS;
+	for(started = 0; started < numThreads; started++){
+		threads[started].estimation = &estimation;
+		/* every thread draws from its own stream, split from the stream of the game */
+		rngSplit(&game->rng, &threads[started].rng);
+		if(!allocProbeBoard(&threads[started].board, geo))
+			break;
+		copyProbeBoard(&threads[started].board, &base);
+		if(pthread_create(&threads[started].thread, NULL, probeThread, &threads[started]) != 0){
+			freeProbeBoard(&threads[started].board);
+			break;
+		}
+	}
+	/* watch the probes until there are enough of them, the interval is tight enough or the control stops us */
+	poll.tv_sec = 0;
+	poll.tv_nsec = POLL_NANOSECONDS;
+	while(started > 0 && !estimation.stop){
+		nanosleep(&poll, NULL);
+		pthread_mutex_lock(&estimation.lock);
+		done = estimation.result.samples;
+		if(control != NULL)
+			control->progress = done;
+		if(done >= maxSamples || (done >= ESTIMATE_MIN_SAMPLES && estimateRelativeWidth(&estimation.result) <= targetWidth))
+			estimation.stop = 1;
+		pthread_mutex_unlock(&estimation.lock);
+		/* shouldStop reads the clock only once in CLOCK_CHECK_INTERVAL calls, which is seconds of this loop */
+		if(shouldStop(control) || deadlinePassed(control))
+			estimation.stop = 1;
+	}
+	estimation.stop = 1;
+	for(i = 0; i < started; i++){
+		pthread_join(threads[i].thread, NULL);
+		freeProbeBoard(&threads[i].board);
+	}
+	pthread_mutex_destroy(&estimation.lock);
+	freeProbeBoard(&base);
+	*result = estimation.result;
+	return started > 0 ? 1 : -1;
+}
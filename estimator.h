@@ -0,0 +1,38 @@
+/* Header file of the estimator module. Estimates the number of solutions of boards too sparse to count exactly,
+ * with Knuth's random probing of the back-tracking tree: every probe walks one random path from the root, always branching
+ * on the empty cell with the fewest candidates, and multiplies the numbers of candidates it saw on the way.
+ * The mean of the products over many probes is an unbiased estimate of the number of solutions, and the mean of the
+ * partial products is an estimate of the size of the tree the exact count has to search.
+ * The values are huge (about 10^98 for an empty 16x16 board), so everything is kept as natural logarithms.*/
+
+#ifndef ESTIMATOR_H_
+#define ESTIMATOR_H_
+#include "game.h"
+#include "control.h"
+
+#define ESTIMATE_DEFAULT_SAMPLES 100000
+#define ESTIMATE_MIN_SAMPLES 200
+#define ESTIMATE_TARGET_WIDTH 0.05 /* stop once the 95% interval is within 5% of the estimate */
+
+typedef struct Estimate{
+	long samples; /* number of probes taken */
+	double logSum; /* log of the sum of the solution estimates of the probes, -HUGE_VAL while all were 0 */
+	double logSumSq; /* log of the sum of their squares */
+	double logNodeSum; /* log of the sum of the tree size estimates of the probes */
+}Estimate;
+
+/* runs up to maxSamples probes on all the processors, and stops early once the relative half width of the 95% confidence
+ * interval drops below targetWidth, or when the control says so. the probes taken so far are always kept in result.
+ * returns 1 on success, 0 if the board is too large for the estimator and -1 on a memory or thread error */
+int estimateSolutions(Game *game, long maxSamples, double targetWidth, SolveControl *control, Estimate *result);
+
+/* the log of the estimated number of solutions, -HUGE_VAL if no probe reached a solution */
+double estimateLogMean(Estimate *estimate);
+
+/* the half width of the 95% confidence interval, relative to the estimate */
+double estimateRelativeWidth(Estimate *estimate);
+
+/* the log of the estimated number of nodes of the back-tracking tree */
+double estimateLogNodes(Estimate *estimate);
+
+#endif /* ESTIMATOR_H_ */
@@ -2,8 +2,9 @@
 #include "parser.h"
 #include "solver.h"
 #include "game.h"
+#include "trace.h"
 
-int loadBoard(Game* game, char* filePath){
+static int readBoard(Game* game, char* filePath){
 	File *file;
 	char mStr[20], nStr[20], numStr[20];
 	int n, m, N, num, row=0, col=0, numOfFilledCells = 0 , numOfEmptyCells = 0, i = 0, fixedSign = 0;
@@ -80,12 +81,12 @@ int loadBoard(Game* game, char* filePath){
 
 }
 
-void saveBoard(Game *game, char* filePath){
+static void writeBoard(Game *game, char* filePath){
 	int row, col, val;
 	File *file;
 	file = fopen(filePath, "w");
 	if(game.mode == edit){
-		if(validate(game, 0) == 0){
+		if(validate(game, 0, NULL) == 0){
 			Error();
 			return;
 		}
@@ -105,3 +106,18 @@ void saveBoard(Game *game, char* filePath){
 	}
 	fclose(file);
 }
+
+/* the board file functions, traced as a whole */
+int loadBoard(Game* game, char* filePath){
+	int res;
+	TRACE_BEGIN("loadBoard");
+	res = readBoard(game, filePath);
+	TRACE_END("loadBoard");
+	return res;
+}
+
+void saveBoard(Game *game, char* filePath){
+	TRACE_BEGIN("saveBoard");
+	writeBoard(game, filePath);
+	TRACE_END("saveBoard");
+}
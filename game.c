@@ -6,6 +6,24 @@
 #include "parser.h"
 #include "solver.h"
 #include "game.h"
+#include "movesList.h"
+#include "gurobi.h"
+#include "control.h"
+#include "worker.h"
+#include "estimator.h"
+#include "results.h"
+#include "geometry.h"
+#include "engine.h"
+#include "portfolio.h"
+#include "selector.h"
+#include "search.h"
+#include "rng.h"
+#include "trace.h"
+#include "metrics.h"
+#include "journal.h"
+#include "pool.h"
+#include "gridPool.h"
+#include "catalogue.h"
 
 
 #define SEP "----------------------------------\n"  /*separator for printBoard*/
@@ -19,64 +37,65 @@ void freeGame(Game* game){
 	freeBoard(game);
 	clearNextMoves(game);
 	clearPrevMoves(game);
+	freeRelaxation(game->relaxation);
+	freeWorkspace(game->workspace);
 	/* we free the game */
 	free(game);
 }
 void freeBoard(Game* game){
-	int j;
-	/* we free each calloc we made for the columns */
-	for(j = 0; j< game.n*game.m; j++)
-		free(game.board[j]);
-	/* we free the calloc of the rows */
-	free(game.board);
+	/* the rows and the cells are one block, from the pools of the game or from the heap */
+	releaseBoard(game->pools, game->board, game->n, game->m);
+	game->board = NULL;
 }
 
 /* a command for exiting the game
  * we free the allocated memory using freeBoard and exiting */
 void exitGame(Game* game){
+	closeJournal();
 	freeGame(game);
+	freeGeometries();
+	freeGridPools();
+	freeCatalogues();
+	closeTimingLog();
+	closeTrace();
+	closeMetricsExport();
 	printf("Exiting...\n");
 	exit(0);
 }
 
 Game* createGame(){
 	Game *game = (Game*)calloc(1, sizeof(Game));
-	game.n = 3;
-	game.m = 3;
-	game.board = createBoard(game);
-	game.mode = 0;
+	if(game == NULL){
+		printf(ErrorCalloc);
+		exit(0);
+	}
+	game->n = 3;
+	game->m = 3;
+	game->board = createBoard(game);
+	game->mode = 0;
+	game->markErrors = 1;
+	return game;
 }
 
-/* create a new board */
+/* create a new board of the geometry of the game, from its pools */
 Cell ** createBoard(Game* game){
-	int n = game.n;
-	int m = game.m;
-	int j;
-	/* allocating n*m*sizeOf(int) bytes for the board rows */
-	Cell** board = (Cell **)calloc(n*m, sizeof(Cell*));
+	/* the n*m row pointers and the n*m*n*m cells in one block */
+	Cell** board = allocBoard(game->pools, game->n, game->m);
 	if(board == NULL){
 		printf(ErrorCalloc);
 		exit(0);
 	}
-	/* allocating n*m*sizeOf(int) bytes for the board column in each row */
-	for(j=0; j<n*m; ++j){
-		board[j] = (Cell *)calloc(n*m, sizeof(Cell));
-		if(board[j] == NULL){
-			printf(ErrorCalloc);
-			exit(0);
-		}
-	}
 	return board;
 }
 
 /* a command the user can put while playing to restart the game */
 void reset(Game* game){
-	Move move;
-	while(game->currentMove != NULL){
-		move = game->currentMove;
+	journalEnter(JOURNAL_RESTART);
+	while(game->currentMove != NULL)
 		undo(game, 0);
-		free(move);
-	}
+	/* the history starts over from the original board */
+	clearNextMoves(game);
+	journalLeave();
 }
 
 /* print the board in the required format */
@@ -92,6 +111,7 @@ void printBoard(Game* game){
     	doubleNM /= 10;
         ++maxSpacePerCell;
     }
+	TRACE_BEGIN("printBoard");
 	/* print each row*/
 	for(row = 0; row<n*m; row++){
 		/* before rows that are multiple of 3, print the separator row*/
@@ -120,6 +140,7 @@ void printBoard(Game* game){
 		printf("|\n");
 	}
 	printf(SEP);
+	TRACE_END("printBoard");
 }
 
 /* a command the user can put to set value to cell (row,col) */
@@ -130,9 +151,13 @@ void set(Game *game, int row, int col, int value, int printSign){
 		return;
 	}
 	/* set the value to the suitable cell and print the board */
-	if((value == 0)||(isSafe(game.board, row-1, col-1, value) == 1)){
+	if((value == 0)||(isSafe(game, row-1, col-1, value) == 1)){
 		clearNextMoves(game);
 		setMove(game, row, col, value, game->board[row-1][col-1].value);
+		if(game->board[row-1][col-1].value == 0 && value != 0)
+			game->numOfFilledCells++;
+		else if(game->board[row-1][col-1].value != 0 && value == 0)
+			game->numOfFilledCells--;
 		game->board[row-1][col-1].value = value;
 		if(printSign == 1){
 			printBoard(game->board);
@@ -141,15 +166,18 @@ void set(Game *game, int row, int col, int value, int printSign){
 	else
 		printf("Error: value is invalid\n");
 	/* check if the board is full. if it is, end the game */
-	if(findUnassignedLocation(game.board) == 0){
+	if(findUnassignedLocation(game) == 0){
 		printf("Puzzle solved successfully\n");
 		endGame(game.board);
 	}
 }
 
 
-int validate(Game *game, int printSign){
-	int ilpSolverRes;
+int validate(Game *game, int printSign, SolveControl *control){
+	int ilpSolverRes, haveKey, exact, engine = ENGINE_AUTO;
+	long count;
+	double start = monotonicSeconds();
+	BoardKey key;
 	if(isErrorneous(game)){
 		if (printSign){
 			printf("The board is errorneous.\n")
@@ -157,13 +185,31 @@ int validate(Game *game, int printSign){
 		return 0;
 	}
 	else{
-		ilpSolverRes = ilpSolver(game);
+		/* an isomorphic board may have been solved or counted already */
+		haveKey = makeBoardKey(game, &key, control);
+		if(haveKey && lookupCount(&key, &count, &exact) && (count > 0 || exact))
+			ilpSolverRes = count > 0;
+		else
+			ilpSolverRes = engineSolvable(game, control, &engine);
+		if(haveKey){
+			if(ilpSolverRes == 0)
+				storeCount(&key, 0, 1, engineName(engine), monotonicSeconds() - start);
+			else if(ilpSolverRes == 1)
+				storeCount(&key, 1, 0, engineName(engine), monotonicSeconds() - start);
+			freeBoardKey(&key);
+		}
 		if(ilpSolverRes == 1){
 			if(printSign){
 				printf("The board is valid and solvable, you may continue.\n");
 			}
 			return 1;
 		}
+		else if(ilpSolverRes == 2){
+			if(printSign){
+				printf("Validation was stopped before the board was fully checked.\n");
+			}
+			return 0;
+		}
 		else{
 			if(printSign){
 				printf("The board is not solvable.\n");
@@ -173,29 +219,33 @@ int validate(Game *game, int printSign){
 	}
 }
 
+/* returns 1 if a value repeats in a row, column or box of the board, and marks the cells that take part in a repetition as errors.
+ * every unit is counted in one pass over its cells */
 int isErrorneous(Game *game){
-	int row, col, i, j, val, errorMark = 0;
-	int N = game->n*game->m;
-	/* for each value from 1 to N, check there is no multiplicity */
-	for(val = 1; val <= game->n*game->n; val++){
-		for(row = 0; row < N, row++){
-			if(instancesInRow(game, row, val) > 1){
-				errorMark = 1;
-			}
+	const Geometry *geo = gameGeometry(game);
+	int unit, i, errorMark = 0;
+	int count[GEOMETRY_MAX_N+1];
+	Cell *cell;
+	if(geo == NULL)
+		return 1;
+	TRACE_BEGIN("isErrorneous");
+	for(i = 0; i < geo->numCells; i++)
+		game->board[geo->rowOf[i]][geo->colOf[i]].error = 0;
+	for(unit = 0; unit < geo->numUnits; unit++){
+		memset(count, 0, sizeof(count));
+		for(i = 0; i < geo->N; i++){
+			cell = &game->board[geo->rowOf[geo->unitCells[unit*geo->N + i]]][geo->colOf[geo->unitCells[unit*geo->N + i]]];
+			count[cell->value]++;
 		}
-		for(col = 0; col < N, col++){
-			if(instancesInCol(game, col, val) > 1){
+		for(i = 0; i < geo->N; i++){
+			cell = &game->board[geo->rowOf[geo->unitCells[unit*geo->N + i]]][geo->colOf[geo->unitCells[unit*geo->N + i]]];
+			if(cell->value != 0 && count[cell->value] > 1){
+				cell->error = 1;
 				errorMark = 1;
 			}
 		}
-		for(i = 0; i < game->n; i++){
-			for(j = 0; j < game->m; j++){
-				if(instancesInBox(game, i*game->m, j*game->n, val) >1){
-					errorMark = 1;
-				}
-			}
-		}
 	}
+	TRACE_END("isErrorneous");
 	return errorMark;
 }
 
@@ -206,97 +256,82 @@ void mark_errors(int markErrorNum, int* error){
 		printf("Error: mark_errors can get only 0 or 1\n");
 }
 
-<<<<<<< HEAD
-=======
-void generate(Game *game, int x, int y){
-	int row, col, val, N = game->n*game->m, i;
+/* the solver workspace of the game, sized for its geometry. it is made by the first command that needs it and kept in the game,
+ * so validate, hint, generate and guess don't allocate the N^3 arrays of the ILP on every call.
+ * returns NULL on a memory error (a message was already printed) */
+static SolverWorkspace* gameWorkspace(Game *game){
+	SolverWorkspace *ws = game->workspace;
+	/* a board of another geometry was loaded since the last use - size a new one */
+	if(ws != NULL && (ws->n != game->n || ws->m != game->m)){
+		freeWorkspace(ws);
+		ws = NULL;
+	}
+	if(ws == NULL)
+		ws = createWorkspace(game->n, game->m);
+	game->workspace = ws;
+	return ws;
+}
+
+void generate(Game *game, int x, int y, SolveControl *control){
+	int row, col, N = game->n*game->m, i, solved;
+	int *solution;
+	SolverWorkspace *ws;
 	/* if the board doesn't contain x empty cells */
 	if(N*N-game->numOfFilledCells < x){
-		pfintf("Error: the board does nor contain %d empty cells.\n", x);
+		printf("Error: the board does not contain %d empty cells.\n", x);
 		return;
 	}
-	/* fill x cells in the board. if there's a problem exit function */
-	if(fillXCells(game, x) == 0){
+	ws = gameWorkspace(game);
+	if(ws == NULL)
+		return;
+	solution = ws->answer;
+	/* a random completion of the board, by the randomized search with restarts. it replaces filling x random cells and
+	 * solving the result, which needed up to 1000 fresh attempts when the random cells led to a dead end.
+	 * an empty board takes a transformed grid of the grid pool instead, without a search most of the time */
+	if(game->numOfFilledCells == 0)
+		solved = drawSolvedGrid(game->n, game->m, &game->rng, control, solution);
+	else
+		solved = nonDeterministicBackTracking(game, control, solution);
+	if(solved == -1){
 		return;
 	}
-	filledCells = (int*) cealloc(game->numOfFilledCells * 3, sizeof(int));
-	if(filledCelles == NULL){
-		printf("ERROR: memory allocation error.\n");
-		return NULL;
-	}
-	sol = (double*) calloc(N*N*N, sizeof(double));
-	if(filledCelles == NULL){
-		printf("ERROR: memory allocation error.\n");
-		return NULL;
-	}
-	findFilledCells(game, filledCells);/* fills the filledCells array with the data of the game filled cells */
-	solved = findSol(game->n, game->m, filledCells, game->numOfFilledCells, sol);
-	/* if the board is unsolvable */
-	if(!solved){
-		/****************************************/
-	}
-	/* put the solution of the ILP in the game-board */
-	for(i=0; i<N*N*N; ii=++){
-		if(sol[i]==1){
-			col = i/(N*N);
-			row = (i-(col*N*N))/N;
-			val = ((i-col*N*N)-row*N);
-			game->board[row][col].value = val;
-		}
+	if(solved == 0){
+		printf("Error: the board has no solution, nothing was generated\n");
+		return;
+	}
+	/* if the generation was cancelled or ran out of time, leave the board as it was */
+	if(solved == 2){
+		printf("Generation was stopped, the board was not changed\n");
+		return;
+	}
+	/* put the solution in the game-board */
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++)
+			game->board[row][col].value = solution[row*N+col];
 	}
 	clearFixedSigns(game, 1);
-	/* choose Y cells to keep */
-	for(i=0; i < y; i++){
-		row = rand()%N;
-		col = rand()%N;
-		game->board[row][col].fixed = 1;
+	/* choose Y different cells to keep: the first y of the cells in a random order */
+	for(i = 0; i < N*N; i++)
+		solution[i] = i;
+	rngShuffle(&game->rng, solution, N*N);
+	for(i=0; i < y && i < N*N; i++){
+		game->board[solution[i]/N][solution[i]%N].fixed = 1;
 	}
 	/* clear the rest of the cells */
-	clearFixedSign(game, 3);
-}
-
-int fillXCells(Game *game, int x){
-	int row, col, val, i=0, j, N = game->n*game->m, counter = 0;
-	while(i<x){
-		if(counter >= 1000){
-			printf("ERROR: error in the puzzle generator, can't execute the operation\n");
-			return 0;
-		}
-		row = rand()%N;
-		col = rand()%N;
-		/* if the cell is free (has 0 as value) */
-		/* set all the possible assignments to the cell (row,col) */
-		setOptionalValues(game->board, row, col);
-		if(game->board[row][col].numOfOptionalValues > 0){
-			if(game->board[row][col].numOfOptionalValues == 1){
-				val = game->board[row][col].optionalValues[0];
-			}
-			else{
-				j = rand()%game->board[row][col].numOfOptionalValues;
-				val = game->board[row][col].optionalValues[j];
-			}
-			game->board[row][col].value = val;
-			game->board[row][col].fixed = 2;
-			i++;
-		}
-		/* if we chose a cell that has no optional value, restart the all process*/
-		else {
-			clearFixedSigns(game, 2);
-			i=0;
-			counter++;
-		}
-	}
-	return 1;
+	clearFixedSigns(game, 3);
+	game->numOfFilledCells = y < N*N ? y : N*N;
+	/* the generated board doesn't go through the moves, the journal keeps all of it */
+	journalBoard(game);
 }
 
 /* goes throw all the board cells
  * case fixedNum == 1 : unfix the cell and set the fix field to 0
  * case fixedNum == 2 : clear the cell, set the value and the fix fields to 0
- * case fixedNum == 3 : set the value of the unfixed cells to 0*/
+ * case fixedNum == 3 : set the value of the unfixed cells to 0 (the fixed ones are unfixed, as in case 1)*/
 void clearFixedSigns(Game *game, int fixedNum){
-	int row, col;
-	for(row = 0; row < game->n; row++ ){
-		for(col = 0; col < game->m; col++ ){
+	int row, col, N = game->n*game->m;
+	for(row = 0; row < N; row++ ){
+		for(col = 0; col < N; col++ ){
 			if(game->board[row][col].fixed ==1 && fixedNum != 0){
 				game->board[row][col].fixed = 0;
 			}
@@ -305,7 +340,7 @@ void clearFixedSigns(Game *game, int fixedNum){
 				game->board[row][col].fixed = 0;
 			}
 			else if(fixedNum == 3){
-				if(game->board[row][col].fixed = 0){
+				if(game->board[row][col].fixed == 0){
 					game->board[row][col].value = 0;
 				}
 			}
@@ -314,48 +349,82 @@ void clearFixedSigns(Game *game, int fixedNum){
 	}
 }
 
-/*The function finds all the filled cells in the game board and return them in an array such that every cells take 3 spaces, x,y, and the value in this cell.
+/*The function finds all the filled cells in the game board and puts them in an array such that every cells take 3 spaces, row, col, and the value in this cell.
 	 * INPUT: Game *game - A pointer to the game.
-	 *        int *filledCells - A pointer to an int array in size 3*numOfFilledCells to put the filled cells of the game
-	 * OUTPUT: An int array with all the filled cells found in the game board, each cell uses 3 spaces in the format x,y, and the current value inside the cell.*/
-int* findFilledCells(Game *game, int *filledCells) {
-	int N = game->m * game->n;
-
+	 *        int *filledCells - A pointer to an int array in size 3*N*N to put the filled cells of the game
+	 * OUTPUT: The number of filled cells found in the game board.*/
+static int findFilledCells(Game *game, int *filledCells) {
+	int row, col, index = 0, N = game->m * game->n;
 	for (row = 0; row < N; row++) {
 		for (col = 0; col < N; col++) {
-			if (game->board[j][i].value != 0) {
+			if (game->board[row][col].value != 0) {
 				filledCells[index * 3] = row;
 				filledCells[index * 3 + 1] = col;
 				filledCells[index * 3 + 2] = game->board[row][col].value;
+				index++;
 			}
 		}
 	}
-	return filled;
+	return index;
+}
+
+/* solves the board with the Gurobi ILP and puts the value of every cell in solution (N*N ints, row by row), solution may be NULL
+ * when only the answer matters. returns 1 if a solution was found, 0 if the board is unsolvable, 2 if the control stopped the
+ * search and -1 on an error */
+int ilpSolveBoard(Game *game, SolveControl *control, int *solution){
+	SolverWorkspace *ws = gameWorkspace(game);
+	int solved, N = game->n*game->m;
+	if(ws == NULL)
+		return -1;
+	solved = findSol(ws, findFilledCells(game, ws->filled), control);
+	if(solved == 1 && solution != NULL)
+		memcpy(solution, ws->values, N*N*sizeof(int));
+	return solved;
 }
 
-/*The function extract the value that should be in the cell <x,y> according to the solution found with the ILP module that is contained in sol.
-	 * INPUT: double *sol - A double array in the size of (cols * rows)^3, where the solution found by the ILP is stored. Function should run only if the solution is valid.
-	 *        int x,y - Integers representing the column and row of the cell we want to know it's value according to the solution sol.
-	 *        int cols, rows - Integers representing the amount of columns and rows in each block of the game board.
-	 * OUTPUT: An integer which should be in the cell <x,y> according to the solution sol.*/
-int findval(double *sol, int x, int y, Game *game) {
-	int i, N = game->n*game->m;
-	for (i = 0; i < N; i++) {
-		if (sol[x*N + y*N* N + i])/*If the location has 1 then the value in the cell in the valid board is the location-1*/
-			return i + 1;
+/* finds a solution of the board of the game and puts the value of every cell in solution (N*N ints, row by row).
+ * the board itself is not changed. a solution of an isomorphic board solved before is reused, a new one is remembered.
+ * the solver is the one the engine module picks for the board.
+ * returns 1 if a solution was found, 0 if the board is unsolvable, 2 if the control stopped the search and -1 on an error */
+int solveGame(Game *game, SolveControl *control, int *solution){
+	int solved, haveKey, exact, engine;
+	long count;
+	double start = monotonicSeconds();
+	BoardKey key;
+	haveKey = makeBoardKey(game, &key, control);
+	if(haveKey && lookupSolution(&key, solution)){
+		freeBoardKey(&key);
+		return 1;
+	}
+	if(haveKey && lookupCount(&key, &count, &exact) && exact && count == 0){
+		freeBoardKey(&key);
+		return 0;
 	}
-	return -1;/*Value not found, there was no valid solution, shouldn't happen since the function runs only if a valid solution was found*/
+	solved = engineSolve(game, control, solution, &engine);
+	if(haveKey){
+		if(solved == 1)
+			storeSolution(&key, solution, engineName(engine), monotonicSeconds() - start);
+		else if(solved == 0)
+			storeCount(&key, 0, 1, engineName(engine), monotonicSeconds() - start);
+		freeBoardKey(&key);
+	}
+	return solved;
 }
 
-/* a command the user can put to get a hint to a suitable value for cell (row,col)
+/* a command the user can put to get a hint to a suitable value for cell (x,y), from 1
  * we use the saves values from the board build to return the suitable value */
-void hint(Game* game , int x , int y){
-	double *sol;
-	int *filledCells;
-	int val, solved, N;
+void hint(Game* game , int x , int y, SolveControl *control){
+	SolverWorkspace *ws;
+	int solved, N;
 	N = game->n*game->m;
-	/* allocate an */
-	if(isErroneous(game)){
+	/* the cell comes from the user, from 1 */
+	if(x < 1 || x > N || y < 1 || y > N){
+		printf("Error: value not in range 1-%d\n", N);
+		return;
+	}
+	x--;
+	y--;
+	if(isErrorneous(game)){
 		printf("ERROR: board is erroneous.\n");
 		return;
 	}
@@ -367,157 +436,466 @@ void hint(Game* game , int x , int y){
 		printf("ERROR: cell already contains a value.\n");
 		return;
 	}
-	filledCells = (int*) cealloc(game->numOfFilledCells * 3, sizeof(int));
-	if(filledCelles == NULL){
-		printf("ERROR: memory allocation error.\n");
-		return NULL;
-	}
-	sol = (double*) calloc(N*N*N, sizeof(double));
-	if(filledCelles == NULL){
-		printf("ERROR: memory allocation error.\n");
-		return NULL;
-	}
-	findFilledCells(game, filledCells);/* fills the filledCells array with the data of the game filled cells */
-	solved = findSol(game->n, game->m, filledCells, game->numOfFilledCells, sol);
-	if (solved > 0) {/*Solution was found, we can give a hint*/
-		val = findval(sol, x, y, cols, rows);
-		printf("Hint: set cell to %d\n", val);
+	ws = gameWorkspace(game);
+	if(ws == NULL)
+		return;
+	solved = solveGame(game, control, ws->answer);
+	if (solved == 1) {/*Solution was found, we can give a hint*/
+		printf("Hint: set cell to %d\n", ws->answer[x*N + y]);
+	} else if (solved == 2) {
+		printf("Hint was stopped before a solution was found\n");
 	} else if (!solved) {
 		printf("Error: board is unsolvable\n");/*solved is 0 here so board is unsolveable*/
 	}/*If we didn't enter the conditions above, we had an error in the Gurobi library and a message was printed*/
-	free(filledCells);
-	free(sol);
 }
 
->>>>>>> refs/heads/shachar
-/* start the game and interactively apply the users commands */
-void gameControl(){
-	char input[256];
+/* solve the LP relaxation of the current board and put the score of every (cell, value) pair in sol (N^3 doubles, in the layout of the variables of findSol).
+ * the relaxation is built once per geometry and kept in the game, so consecutive guesses only re-solve it from the previous basis.
+ * returns 1 if the relaxation is feasible, 0 if it is not and -1 on a gurobi error (a message was already printed) */
+static int relaxationScores(Game *game, double *sol){
+	LPContext *context = game->relaxation;
+	/* a board of another geometry was loaded since the last guess - rebuild the model */
+	if(context != NULL && (context->n != game->n || context->m != game->m)){
+		freeRelaxation(context);
+		context = NULL;
+	}
+	if(context == NULL){
+		context = createRelaxation(game->n, game->m, &game->rng);
+		if(context == NULL){
+			game->relaxation = NULL;
+			return -1;
+		}
+	}
+	game->relaxation = context;
+	return solveRelaxation(context, game, sol);
+}
+
+/* a command the user can put to fill all the empty cells whose best legal value has score of at least threshold in the LP relaxation.
+ * cells are filled one by one, so a value that became illegal because of an earlier fill in this guess is skipped
+ * and the next best value above the threshold is taken instead. the fills are one batch of moves, like autofill's */
+void guess(Game *game, double threshold){
+	SolverWorkspace *ws;
+	double *sol;
+	double score, bestScore;
+	int row, col, val, bestVal, solved, filled = 0, N = game->n*game->m;
+	if(isErrorneous(game)){
+		printf("Error: board is erroneous\n");
+		return;
+	}
+	ws = gameWorkspace(game);
+	if(ws == NULL)
+		return;
+	sol = ws->sol;
+	solved = relaxationScores(game, sol);
+	if(solved == 0){
+		printf("Error: board is unsolvable\n");
+	}
+	else if(solved == 1){
+		for(row = 0; row < N; row++){
+			for(col = 0; col < N; col++){
+				if(game->board[row][col].value != 0)
+					continue;
+				bestVal = 0;
+				bestScore = 0;
+				for(val = 1; val <= N; val++){
+					score = sol[col*N*N + row*N + val-1];
+					if(score >= threshold && score > bestScore && isSafe(game, row, col, val)){
+						bestScore = score;
+						bestVal = val;
+					}
+				}
+				if(bestVal == 0)
+					continue;
+				/* undo and redo take the fills all together */
+				if(filled == 0)
+					clearNextMoves(game);
+				setMove(game, row+1, col+1, bestVal, 0);
+				game->currentMove->chained = filled > 0;
+				if(filled > 0)
+					journalRecord(JOURNAL_CHAIN, 0, 0, 0, 0);
+				game->board[row][col].value = bestVal;
+				game->numOfFilledCells++;
+				filled++;
+			}
+		}
+		printBoard(game);
+		if(filled > 0 && game->numOfFilledCells == N*N)
+			printf("Puzzle solved successfully\n");
+	}
+}
+
+/* a command the user can put to see the score the LP relaxation gives every value of cell (row,col) */
+void guessHint(Game *game, int row, int col){
+	SolverWorkspace *ws;
+	double *sol;
+	double score;
+	int val, solved, N = game->n*game->m;
+	if(row < 1 || row > N || col < 1 || col > N){
+		printf("Error: value not in range 1-%d\n", N);
+		return;
+	}
+	if(isErrorneous(game)){
+		printf("Error: board is erroneous\n");
+		return;
+	}
+	if(game->board[row-1][col-1].fixed == 1){
+		printf("Error: cell is fixed\n");
+		return;
+	}
+	if(game->board[row-1][col-1].value != 0){
+		printf("Error: cell already contains a value\n");
+		return;
+	}
+	ws = gameWorkspace(game);
+	if(ws == NULL)
+		return;
+	sol = ws->sol;
+	solved = relaxationScores(game, sol);
+	if(solved == 0){
+		printf("Error: board is unsolvable\n");
+	}
+	else if(solved == 1){
+		for(val = 1; val <= N; val++){
+			score = sol[(col-1)*N*N + (row-1)*N + val-1];
+			if(score > 0)
+				printf("%d: %.2f\n", val, score);
+		}
+	}
+}
+
+/* a command the user can put to count the solutions of the board.
+ * when the count is stopped (cancel, SIGINT or its time budget) the solutions found so far are reported as a lower bound */
+void num_solutions(Game *game, SolveControl *control){
+	const char *source;
+	long count;
+	int res, haveKey, exact;
+	double start;
+	BoardKey key;
+	if(isErrorneous(game)){
+		printf("Error: board contains erroneous values\n");
+		return;
+	}
+	/* an isomorphic board may have been counted already */
+	haveKey = makeBoardKey(game, &key, control);
+	if(haveKey && lookupCount(&key, &count, &exact) && exact){
+		res = 1;
+	}
+	else{
+		start = monotonicSeconds();
+		res = engineCount(game, control, &count, &source);
+		if(haveKey && res >= 0)
+			storeCount(&key, count, res == 1, source, monotonicSeconds() - start);
+	}
+	if(haveKey)
+		freeBoardKey(&key);
+	if(res == 1){
+		printf("Number of solutions: %ld\n", count);
+		if(count == 1)
+			printf("This is a good board!\n");
+		else if(count > 1)
+			printf("The puzzle has more than 1 solution, try to edit it further\n");
+	}
+	else if(res == 0){
+		printf("Counting was %s: at least %ld solutions\n",
+				control->stopReason == STOP_TIMEOUT ? "timed out" : "cancelled", count);
+	}
+}
+
+/* print a number given as its natural logarithm in scientific notation, it may be far beyond the range of a double */
+static void printFromLog(double logValue){
+	double log10Value = logValue / log(10);
+	double exponent = floor(log10Value);
+	printf("%.2fe+%.0f", pow(10, log10Value - exponent), exponent);
+}
+
+/* a command the user can put to estimate the number of solutions of a board too sparse to count exactly,
+ * and the size of the tree num_solutions would have to search for it */
+void estimate_solutions(Game *game, long samples, SolveControl *control){
+	Estimate estimate;
+	double width;
+	int res;
+	if(isErrorneous(game)){
+		printf("Error: board contains erroneous values\n");
+		return;
+	}
+	if(samples <= 0)
+		samples = ESTIMATE_DEFAULT_SAMPLES;
+	res = estimateSolutions(game, samples, ESTIMATE_TARGET_WIDTH, control, &estimate);
+	if(res == 0){
+		printf("Error: the board is too large for the estimator\n");
+		return;
+	}
+	if(res == -1){
+		printf(ErrorCalloc);
+		return;
+	}
+	if(control != NULL && control->stopReason != STOP_NONE)
+		printf("Estimation was %s, partial result:\n", control->stopReason == STOP_TIMEOUT ? "timed out" : "cancelled");
+	if(estimate.logSum == -HUGE_VAL){
+		printf("No probe out of %ld reached a solution, the board has few solutions or none\n", estimate.samples);
+		return;
+	}
+	printf("Estimated number of solutions: ");
+	printFromLog(estimateLogMean(&estimate));
+	width = estimateRelativeWidth(&estimate);
+	if(width == HUGE_VAL)
+		printf(" (%ld samples, not enough for an interval)\n", estimate.samples);
+	else
+		printf(" (95%% confidence: +-%.1f%%, %ld samples)\n", 100*width, estimate.samples);
+	printf("Estimated search tree size for num_solutions: ");
+	printFromLog(estimateLogNodes(&estimate));
+	printf(" nodes\n");
+}
+
+/* the bodies of the commands that run on the worker thread. each one runs the command on the game of the job
+ * with the control of the job, so cancel, SIGINT and the time budget reach the solver */
+static void runValidate(Job *job){
+	validate(job->game, 1, &job->control);
+}
+
+static void runHint(Job *job){
+	hint(job->game, job->args[2], job->args[1], &job->control);
+}
+
+static void runGenerate(Job *job){
+	generate(job->game, job->args[1], job->args[2], &job->control);
+}
+
+static void runNumSolutions(Job *job){
+	num_solutions(job->game, &job->control);
+}
+
+static void runEstimateSolutions(Job *job){
+	estimate_solutions(job->game, job->args[1], &job->control);
+}
+
+/* the names of the commands by their number from the parser, for the trace and the metrics */
+static const char *commandNames[] = {"unknown", "solve", "edit", "mark_errors", "print_board", "set", "validate", "guess",
+		"generate", "undo", "redo", "save", "hint", "guess_hint", "num_solutions", "autofill", "restart", "exit", "blank",
+		"invalid", "cancel", "status", "timeout", "estimate_solutions", "engine", "explain", "search", "metrics"};
+#define NUM_COMMAND_NAMES ((int)(sizeof(commandNames)/sizeof(char*)))
+
+/* returns 1 if the command may run while a background command is running, 0 otherwise.
+ * these commands don't touch the board, which belongs to the background command until it finishes */
+static int allowedWhileRunning(int command){
+	return command == 17 || command == 18 || command == 20 || command == 21 || command == 22 || command == 27;
+}
+
+/* parse and run one command line of the user on the game */
+int executeCommand(Game *game, Job *job, char *input){
 	int command[4] = {0};
-	int markErrors = 1;
-	int* error = &markErrors;
 	int *p = command;
 	char strPath[256];
 	char *path = strPath;
-	Game game =  createGame();
+	double threshold = 0;
+	const char *commandName;
+	double start, jobStart;
+	TRACE_BEGIN("parse");
+	parseUserInput(p, path, &threshold, input);
+	TRACE_END("parse");
+	if(jobRunning(job) && !allowedWhileRunning(command[0])){
+		printf("Error: %s is still running, use status or cancel\n", job->name);
+		return 0;
+	}
+	/* the background commands only start here, their work is traced on the worker thread */
+	commandName = commandNames[command[0] >= 0 && command[0] < NUM_COMMAND_NAMES ? command[0] : 0];
+	TRACE_BEGIN(commandName);
+	start = monotonicSeconds();
+	jobStart = job->startTime;
+	switch (command[0]) {
+	case 1: /*solve command */
+		if(commands[1] == 1)
+			printf("Error: invalid command, have to enter a path\n");
+		else{
+			/*should load an existing board*/
+			game->mode=1;
+			journalBoard(game);
+		}
+		break;
+	case 2: /*edit command */
+		if(game->markErrors == 0)
+			game->markErrors = 1;
+		if(commands[1] == 1){
+			/*should load a new board 9x9*/
+		}
+		else{
+			/*should load an existing board*/
+		}
+		game->mode=2;
+		journalBoard(game);
+		break;
+	case 3: /*mark_errors command*/
+		if(game->mode == 1)
+			mark_errors(command[1], &game->markErrors);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 4: /*printBoard command*/
+		if(game->mode != 0)
+			printBoard(game);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 5: /*set command */
+		if(game->mode != 0)
+			set(game, command[2], command[1], command[3], 1);
+		break;
+	case 6: /*validate command*/
+		if(game->mode != 0)
+			startJob(job, game, "validate", NULL, command, game->timeout, runValidate);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 7: /*guess command*/
+		if(game->mode == 1)
+			guess(game, threshold);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 8: /*generate command*/
+		if(game->mode == 2)
+			startJob(job, game, "generate", NULL, command, game->timeout, runGenerate);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 9: /*undo command*/
+		if(game->mode != 0)
+			undo(game, 1);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 10: /*redo command*/
+		if(game->mode != 0)
+			redo(game, 1);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 11: /*save command*/
+		if(game->mode != 0)
+			save(game->board);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 12: /*hint command*/
+		if(game->mode == 2)
+			startJob(job, game, "hint", NULL, command, game->timeout, runHint);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 13: /*guess_hint command*/
+		if(game->mode == 1)
+			guessHint(game, command[2], command[1]);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 14: /*num_solutions command*/
+		if(game->mode != 0)
+			startJob(job, game, "num_solutions", "solutions", command, game->timeout, runNumSolutions);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 15: /*autofill command*/
+		if(game->mode == 2 && command[1] == 1)
+			autofillAll(game);
+		else if(game->mode == 2)
+			autofill(game->board);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 16: /*reset command*/
+		if(game->mode != 0)
+			reset(game);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 17: /*exit command*/
+		if(jobRunning(job))
+			job->control.cancelled = 1;
+		waitJob(job);
+		TRACE_END(commandName);
+		recordLatency(commandName, monotonicSeconds() - start);
+		return 1;
+	case 18: /*blank line */
+		break;
+	case 19: /*otherwise */
+		printf("Error: invalid command\n");
+		break;
+	case 20: /*cancel command*/
+		cancelJob(job);
+		break;
+	case 21: /*status command*/
+		printJobStatus(job);
+		break;
+	case 22: /*timeout command*/
+		if(command[1] >= 0)
+			game->timeout = command[1];
+		else
+			printf("Error: timeout must be a non-negative number of seconds\n");
+		break;
+	case 23: /*estimate_solutions command*/
+		if(game->mode != 0)
+			startJob(job, game, "estimate_solutions", "samples", command, game->timeout, runEstimateSolutions);
+		else
+			printf("Error: invalid command\n");
+		break;
+	case 24: /*engine command*/
+		if(jobRunning(job))
+			printf("Error: a command is still running, cancel it or wait for it to finish\n");
+		else if(command[1] >= 0)
+			game->engine = command[1];
+		else{
+			printf("Engine: %s (%s for this board)\n", engineName(game->engine), engineName(chooseEngine(game)));
+			printPortfolioWins(game->n, game->m);
+		}
+		break;
+	case 25: /*explain command*/
+		if(jobRunning(job))
+			printf("Error: a command is still running, cancel it or wait for it to finish\n");
+		else
+			explainSelection(game);
+		break;
+	case 26: /*search command*/
+		if(jobRunning(job))
+			printf("Error: a command is still running, cancel it or wait for it to finish\n");
+		else if(command[1] >= 0)
+			game->searchOptions = command[1];
+		else
+			printSearchOptions(game->searchOptions);
+		break;
+	case 27: /*metrics command*/
+		printMetrics();
+		break;
+	}
+
+	TRACE_END(commandName);
+	/* a command that started a job is timed by the worker, to its end */
+	if(command[0] != 18 && job->startTime == jobStart)
+		recordLatency(commandName, monotonicSeconds() - start);
+	return 0;
+}
+
+/* start the game and interactively apply the users commands */
+void gameControl(){
+	char input[256];
+	Job job;
+	Game *game = createGame();
+	rngSeed(&game->rng, sessionSeed());
+	/* continue a session that was recovered from its journal. a journal that can't be replayed was restarted, and so is
+	 * the half replayed game */
+	if(replayJournal(game) < 0){
+		freeGame(game);
+		game = createGame();
+		rngSeed(&game->rng, sessionSeed());
+	}
+	initJob(&job);
+	installInterruptHandler(&job);
 	/* scan the user commands till EOF */
 	while (!feof(stdin)) {
 		fflush(stdin);
-		if (fgets(input, 1024, stdin) != NULL) {
-			parseUserInput(p, path, input);
-			switch (command[0]) {
-			case 1: /*solve command */
-				if(commands[1] == 1)
-					printf("Error: invalid command, have to enter a path\n");
-				else{
-					/*should load an existing board*/
-					game.mode=1;
-				}
-				break;
-			case 2: /*edit command */
-				if(markErrors == 0)
-					markErrors = 1;
-				if(commands[1] == 1){
-					/*should load a new board 9x9*/
-				}
-				else{
-					/*should load an existing board*/
-				}
-				game.mode=2;
-				break;
-			case 3: /*mark_errors command*/
-				if(game.mode == 1)
-					mark_errors(command[1], error);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 4: /*printBoard command*/
-				if(game.mode != 0)
-					printBoard(game);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 5: /*set command */
-				if(game.mode != 0)
-					set(game.board);
-				break;
-			case 6: /*validate command*/
-				if(game.mode != 0)
-					validate(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 7: /*guess command*/
-				if(game.mode == 1)
-					guess(game.board);
-				else
-					printf("Error: invalid command\n");
-			case 8: /*generate command*/
-				if(game.mode == 2)
-					generate(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 9: /*undo command*/
-				if(game.mode != 0)
-					undo(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 10: /*redo command*/
-				if(game.mode != 0)
-					redo(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 11: /*save command*/
-				if(game.mode != 0)
-					save(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 12: /*hint command*/
-				if(game.mode == 2)
-					hint(command[2], command[1], game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 13: /*guess_hint command*/
-				if(game.mode == 2)
-					hint(command[2], command[1], game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 14: /*num_solutions command*/
-				if(game.mode != 0)
-					num_solutions(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 15: /*autofill command*/
-				if(game.mode == 2)
-					autofill(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 16: /*reset command*/
-				if(game.mode != 0)
-					reset(game.board);
-				else
-					printf("Error: invalid command\n");
-				break;
-			case 17: /*exit command*/
-				exitGame(game.board);
-				break;
-			case 18: /*blank line */
-				break;
-			case 19: /*otherwise */
-				printf("Error: invalid command\n");
-				break;
-			}
-		}
+		if (fgets(input, sizeof(input), stdin) != NULL && executeCommand(game, &job, input))
+			exitGame(game);
 	}
-	/* when reaching EOF, exit the game */
-	exitGame(game.board);
+	/* when reaching EOF, let the background command finish and exit the game */
+	waitJob(&job);
+	exitGame(game);
 }
-
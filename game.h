@@ -1,5 +1,8 @@
 #ifndef GAME_H_
 #define GAME_H_
+#include "control.h"
+#include "rng.h"
+#include "geometry.h"
 
 /* define a struct representing a cell in the sudoku board*/
 typedef struct Cell{
@@ -7,7 +10,8 @@ typedef struct Cell{
 	int fixed ; /* 1 or 0 if the cell is fixed or not (accordingly) */
 	int savedValue; /* the value of the cell in the initialization of the game */
 	int numOfOptionalValues; /* the number of possible values that can be allocated to the cell */
-	int optionalValues[9]; /* an array with the possible values that can be allocated to the cell */
+	int optionalValues[GEOMETRY_MAX_N]; /* an array with the possible values that can be allocated to the cell */
+	int error; /* 1 if the value of the cell repeats in its row, column or box */
 }Cell;
 
 /* define a struct representing a move of the user in the game */
@@ -16,6 +20,7 @@ typedef struct Move{
 	int col;
 	int value;
 	int prevValue;
+	int chained; /* 1 if the move was made together with the move before it (an autofill batch), undo and redo take the whole batch */
 	struct Move *lastMove;
 	struct Move *nextMove;
 }Move;
@@ -27,8 +32,17 @@ typedef struct Game{
 	int m;
 	int markErrors;
 	int numOfFilledCells;
-	Move currentMove;
+	Move *firstMove; /* the first move of the undo/redo history, NULL while it is empty */
+	Move *currentMove; /* the last move applied, NULL before the first */
 	int mode;
+	struct LPContext *relaxation; /* the LP relaxation kept alive between guesses, NULL until the first guess */
+	struct SolverWorkspace *workspace; /* the arrays of the ILP, sized for the geometry of the board, NULL until the first solve */
+	const Geometry *geometry; /* the geometry of the board as of its last use (see gameGeometry), NULL until then */
+	int engine; /* the solver of the game, one of the ENGINE_ values of engine.h */
+	int searchOptions; /* the SEARCH_ options of the back-tracking (see search.h), 0 for the default */
+	Rng rng; /* the random stream of the game: generation, randomized search and the relaxation weights draw from it */
+	double timeout; /* the time budget of background commands in seconds, 0 for none */
+	struct GamePools *pools; /* where the board and the moves come from (see pool.h), NULL for the heap */
 }Game;
 
 void freeGame(Game* game);
@@ -41,20 +55,42 @@ Game* createGame();
 
 Cell ** createBoard(Game* game);
 
-void reset(Game game);
+void reset(Game* game);
 
 void printBoard(Game* game);
 
-void set(Game game, int row, int col, int value, int printSign);
+void set(Game *game, int row, int col, int value, int printSign);
 
-void hint(int row, int col, Cell ** board);
+void hint(Game *game, int x, int y, SolveControl *control);
 
-int validate(Game game, int printSign);
+int validate(Game *game, int printSign, SolveControl *control);
 
-int isErrorneous(Game game);
+void generate(Game *game, int x, int y, SolveControl *control);
+
+void clearFixedSigns(Game *game, int fixedNum);
+
+void num_solutions(Game *game, SolveControl *control);
+
+void estimate_solutions(Game *game, long samples, SolveControl *control);
+
+int isErrorneous(Game *game);
 
 void mark_errors(int markErrorNum, int* error);
 
+int ilpSolveBoard(Game *game, SolveControl *control, int *solution);
+
+int solveGame(Game *game, SolveControl *control, int *solution);
+
+void guess(Game *game, double threshold);
+
+void guessHint(Game *game, int row, int col);
+
+struct Job;
+
+/* parse and run one command line of the user on the game. background commands start on the job.
+ * returns 1 if the command was exit (the job was stopped and waited for), 0 otherwise */
+int executeCommand(Game *game, struct Job *job, char *input);
+
 void gameControl();
 
 
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "geometry.h"
+
+/* Geometry Module
+ * builds the index tables of a board shape once and keeps them for the rest of the program.
+ * the tables are read only after they are built, so the solvers of all the threads share them without locking.
+ */
+
+/* geometries[n][m], a geometry is never replaced once built so the pointers handed out stay valid */
+static Geometry *geometries[GEOMETRY_MAX_N+1][GEOMETRY_MAX_N+1];
+static pthread_mutex_t geometriesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void freeGeometry(Geometry *geo){
+	free(geo->rowOf);
+	free(geo->colOf);
+	free(geo->boxOf);
+	free(geo->unitCells);
+	free(geo->peers);
+	free(geo);
+}
+
+static Geometry* buildGeometry(int n, int m){
+	int N = n*m, cell, row, col, unit, i, peer, count;
+	Geometry *geo = (Geometry*) calloc(1, sizeof(Geometry));
+	if(geo == NULL)
+		return NULL;
+	geo->n = n;
+	geo->m = m;
+	geo->N = N;
+	geo->numCells = N*N;
+	geo->numUnits = 3*N;
+	geo->numPeers = 3*N - n - m - 1;
+	geo->rowOf = (int*) calloc(N*N, sizeof(int));
+	geo->colOf = (int*) calloc(N*N, sizeof(int));
+	geo->boxOf = (int*) calloc(N*N, sizeof(int));
+	geo->unitCells = (int*) calloc(3*N*N, sizeof(int));
+	geo->peers = (int*) calloc(N*N*geo->numPeers, sizeof(int));
+	if(geo->rowOf == NULL || geo->colOf == NULL || geo->boxOf == NULL || geo->unitCells == NULL || geo->peers == NULL){
+		freeGeometry(geo);
+		return NULL;
+	}
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			cell = row*N + col;
+			geo->rowOf[cell] = row;
+			geo->colOf[cell] = col;
+			geo->boxOf[cell] = (row/n)*n + col/m;
+		}
+	}
+	for(unit = 0; unit < N; unit++){
+		for(i = 0; i < N; i++){
+			geo->unitCells[unit*N + i] = unit*N + i; /* row */
+			geo->unitCells[(N + unit)*N + i] = i*N + unit; /* column */
+			geo->unitCells[(2*N + unit)*N + i] = ((unit/n)*n + i/m)*N + (unit%n)*m + i%m; /* box */
+		}
+	}
+	/* the peers: the row, then the column, then the cells of the box that are in neither */
+	for(cell = 0; cell < N*N; cell++){
+		count = 0;
+		for(i = 0; i < N; i++){
+			peer = geo->rowOf[cell]*N + i;
+			if(peer != cell)
+				geo->peers[cell*geo->numPeers + count++] = peer;
+		}
+		for(i = 0; i < N; i++){
+			peer = i*N + geo->colOf[cell];
+			if(peer != cell)
+				geo->peers[cell*geo->numPeers + count++] = peer;
+		}
+		for(i = 0; i < N; i++){
+			peer = geo->unitCells[(2*N + geo->boxOf[cell])*N + i];
+			if(geo->rowOf[peer] != geo->rowOf[cell] && geo->colOf[peer] != geo->colOf[cell])
+				geo->peers[cell*geo->numPeers + count++] = peer;
+		}
+	}
+	return geo;
+}
+
+const Geometry* getGeometry(int n, int m){
+	Geometry *geo;
+	if(n <= 0 || m <= 0 || n*m > GEOMETRY_MAX_N){
+		printf("Error: boards of %d x %d boxes are not supported\n", n, m);
+		return NULL;
+	}
+	pthread_mutex_lock(&geometriesLock);
+	geo = geometries[n][m];
+	if(geo == NULL){
+		geo = buildGeometry(n, m);
+		geometries[n][m] = geo;
+		if(geo == NULL)
+			printf("Error: calloc has failed\n");
+	}
+	pthread_mutex_unlock(&geometriesLock);
+	return geo;
+}
+
+void freeGeometries(){
+	int n, m;
+	pthread_mutex_lock(&geometriesLock);
+	for(n = 1; n <= GEOMETRY_MAX_N; n++){
+		for(m = 1; n*m <= GEOMETRY_MAX_N; m++){
+			if(geometries[n][m] != NULL)
+				freeGeometry(geometries[n][m]);
+			geometries[n][m] = NULL;
+		}
+	}
+	pthread_mutex_unlock(&geometriesLock);
+}
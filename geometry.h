@@ -0,0 +1,32 @@
+/* Header file of the geometry module. Everything that depends only on the shape of the board - which row, column and box
+ * every cell is in, the cells of every unit and the peers of every cell - is computed once per (n, m) and shared.
+ * Cells are numbered row by row, cell = row*N + col. Units 0..N-1 are the rows, N..2N-1 the columns and 2N..3N-1 the boxes.
+ * A box has n rows and m columns, boxes are numbered row by row too, so box = (row/n)*n + col/m.*/
+
+#ifndef GEOMETRY_H_
+#define GEOMETRY_H_
+
+#define GEOMETRY_MAX_N 64 /* the largest side (n*m) a geometry is built for */
+
+typedef struct Geometry{
+	int n; /* rows in a box */
+	int m; /* columns in a box */
+	int N; /* values, cells in a unit, and the side of the board */
+	int numCells; /* N*N */
+	int numUnits; /* 3N */
+	int numPeers; /* peers of every cell - 3N - n - m - 1 */
+	int *rowOf; /* numCells */
+	int *colOf; /* numCells */
+	int *boxOf; /* numCells */
+	int *unitCells; /* numUnits*N, the cells of unit u are unitCells[u*N .. u*N+N-1] */
+	int *peers; /* numCells*numPeers, the cells that share a row, column or box with the cell, each once */
+}Geometry;
+
+/* the geometry of boxes of n rows and m columns, built on the first call and shared by all the callers (and threads) after it.
+ * returns NULL if n*m is out of range (a message is printed) */
+const Geometry* getGeometry(int n, int m);
+
+/* free all the geometries, none of them may be used after it */
+void freeGeometries();
+
+#endif /* GEOMETRY_H_ */
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "gridPool.h"
+#include "game.h"
+#include "geometry.h"
+#include "canon.h"
+#include "search.h"
+#include "pool.h"
+
+/* Grid Pool Module
+ * the seeds of every geometry are in one array of GRIDPOOL_SEEDS grids. a draw copies a seed under the lock and
+ * transforms it outside, with the transforms of the canon module. a search for a new seed runs outside the lock too,
+ * so a draw never waits for another thread's search - two threads may search at once, and both grids are kept.
+ */
+
+typedef struct SeedPool{
+	int numSeeds;
+	long draws;
+	int *seeds; /* GRIDPOOL_SEEDS*N*N */
+}SeedPool;
+
+/* pools[n][m], made by the first draw of the geometry */
+static SeedPool *pools[GEOMETRY_MAX_N+1][GEOMETRY_MAX_N+1];
+static pthread_mutex_t poolsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* a random symmetry of the geometry */
+static void randomTransform(int n, int m, Rng *rng, Transform *transform){
+	int N = n*m, i, j, order[CANON_MAX_N], inner[CANON_MAX_N];
+	transform->n = n;
+	transform->m = m;
+	/* transposing swaps the roles of n and m, so it keeps the geometry only when they are equal */
+	transform->transposed = n == m && rngBelow(rng, 2);
+	/* m bands of n rows: the bands in a random order, and the rows of every band in a random order */
+	for(i = 0; i < m; i++)
+		order[i] = i;
+	rngShuffle(rng, order, m);
+	for(i = 0; i < m; i++){
+		for(j = 0; j < n; j++)
+			inner[j] = j;
+		rngShuffle(rng, inner, n);
+		for(j = 0; j < n; j++)
+			transform->rowOrder[i*n + j] = order[i]*n + inner[j];
+	}
+	/* n stacks of m columns, the same way */
+	for(i = 0; i < n; i++)
+		order[i] = i;
+	rngShuffle(rng, order, n);
+	for(i = 0; i < n; i++){
+		for(j = 0; j < m; j++)
+			inner[j] = j;
+		rngShuffle(rng, inner, m);
+		for(j = 0; j < m; j++)
+			transform->colOrder[i*m + j] = order[i]*m + inner[j];
+	}
+	transform->relabel[0] = 0;
+	for(i = 1; i <= N; i++)
+		transform->relabel[i] = i;
+	rngShuffle(rng, transform->relabel + 1, N);
+}
+
+/* a random solution of the empty board by the randomized search, see randomSearch */
+static int searchSeed(int n, int m, Rng *rng, SolveControl *control, int *grid){
+	Game game;
+	int res;
+	memset(&game, 0, sizeof(Game));
+	game.n = n;
+	game.m = m;
+	game.board = allocBoard(NULL, n, m);
+	if(game.board == NULL){
+		printf("Error: calloc has failed\n");
+		return -1;
+	}
+	res = randomSearch(&game, control, rng, 0, grid, NULL, NULL);
+	releaseBoard(NULL, game.board, n, m);
+	return res;
+}
+
+/* the pool of the geometry, made if it has none. NULL on a memory error. the lock is held */
+static SeedPool* seedPool(int n, int m){
+	SeedPool *pool = pools[n][m];
+	if(pool != NULL)
+		return pool;
+	pool = (SeedPool*) calloc(1, sizeof(SeedPool));
+	if(pool == NULL)
+		return NULL;
+	pool->seeds = (int*) calloc((size_t)GRIDPOOL_SEEDS*n*m*n*m, sizeof(int));
+	if(pool->seeds == NULL){
+		free(pool);
+		return NULL;
+	}
+	pools[n][m] = pool;
+	return pool;
+}
+
+int drawSolvedGrid(int n, int m, Rng *rng, SolveControl *control, int *grid){
+	int N = n*m, res = 0, needSeed, *seed, slot;
+	SeedPool *pool;
+	Transform transform;
+	if(getGeometry(n, m) == NULL || N > CANON_MAX_N)
+		return -1;
+	seed = (int*) malloc((size_t)N*N*sizeof(int));
+	if(seed == NULL){
+		printf("Error: calloc has failed\n");
+		return -1;
+	}
+	pthread_mutex_lock(&poolsLock);
+	pool = seedPool(n, m);
+	if(pool == NULL){
+		pthread_mutex_unlock(&poolsLock);
+		printf("Error: calloc has failed\n");
+		free(seed);
+		return -1;
+	}
+	needSeed = pool->numSeeds == 0 || pool->draws % GRIDPOOL_RESEED_EVERY == 0;
+	pool->draws++;
+	pthread_mutex_unlock(&poolsLock);
+	/* a new seed keeps the pool diverse */
+	if(needSeed){
+		res = searchSeed(n, m, rng, control, seed);
+		if(res == 1){
+			pthread_mutex_lock(&poolsLock);
+			slot = pool->numSeeds < GRIDPOOL_SEEDS ? pool->numSeeds++ : rngBelow(rng, GRIDPOOL_SEEDS);
+			memcpy(pool->seeds + (size_t)slot*N*N, seed, (size_t)N*N*sizeof(int));
+			pthread_mutex_unlock(&poolsLock);
+		}
+	}
+	/* without a new seed (the search was stopped or failed) any seed will do */
+	if(res != 1){
+		pthread_mutex_lock(&poolsLock);
+		if(pool->numSeeds > 0){
+			memcpy(seed, pool->seeds + (size_t)rngBelow(rng, pool->numSeeds)*N*N, (size_t)N*N*sizeof(int));
+			res = 1;
+		}
+		pthread_mutex_unlock(&poolsLock);
+		if(res != 1){
+			free(seed);
+			return res == 0 ? -1 : res;
+		}
+	}
+	randomTransform(n, m, rng, &transform);
+	applyTransform(&transform, seed, grid);
+	free(seed);
+	return 1;
+}
+
+void freeGridPools(){
+	int n, m;
+	pthread_mutex_lock(&poolsLock);
+	for(n = 1; n <= GEOMETRY_MAX_N; n++){
+		for(m = 1; n*m <= GEOMETRY_MAX_N; m++){
+			if(pools[n][m] != NULL){
+				free(pools[n][m]->seeds);
+				free(pools[n][m]);
+			}
+			pools[n][m] = NULL;
+		}
+	}
+	pthread_mutex_unlock(&poolsLock);
+}
@@ -0,0 +1,26 @@
+/* Header file of the grid pool module. A source of random solved grids, for generate on an empty board.
+ * Every geometry keeps up to GRIDPOOL_SEEDS seed solutions found by the randomized search. A grid is drawn by applying a
+ * random sudoku symmetry to a random seed: a relabeling of the digits, a permutation of the bands and of the rows inside
+ * every band, of the stacks and of the columns inside every stack, and a transposition when the boxes are square.
+ * Each of them keeps a solution a solution, and together they cost O(N^2), so a draw takes microseconds instead of a
+ * search. To keep the grids diverse, every GRIDPOOL_RESEED_EVERY draws of a geometry run the search again, and its
+ * grid joins the seeds (replacing a random one once the geometry has GRIDPOOL_SEEDS). The pools are shared by all
+ * threads.*/
+
+#ifndef GRIDPOOL_H_
+#define GRIDPOOL_H_
+#include "rng.h"
+#include "control.h"
+
+#define GRIDPOOL_SEEDS 8 /* seed solutions kept per geometry */
+#define GRIDPOOL_RESEED_EVERY 256 /* draws of a geometry between two searches for a new seed */
+
+/* puts a random solved grid of the geometry in grid (N*N, row by row), drawing from rng. the control (may be NULL) can
+ * stop the search when a seed is needed. returns 1 on success, 2 if the control stopped the search before the geometry
+ * had any seed and -1 on an error */
+int drawSolvedGrid(int n, int m, Rng *rng, SolveControl *control, int *grid);
+
+/* frees the seeds of all the geometries */
+void freeGridPools();
+
+#endif /* GRIDPOOL_H_ */
@@ -1,34 +1,48 @@
-/* Source file which contains the functions that we use in order to use Gurobi for solving boards using ILP. Includes the following functions:
- * free_stuffs - A function that frees data allocated in the findSol function.
+/* Source file which contains the functions that we use in order to solve boards using ILP, through the LP backend (see lpBackend.h) -
+ * Gurobi, or the builtin simplex when the build has no Gurobi. Includes the following functions:
+ * freeGRBdata - A function that frees the arrays the model of the board is built from.
  * addConstraints - A function that adds the needed constraints for the model.
  * addVars - A function that adds the variables needed for the model.
- * findSol - A function that checks if we have a solution for the board provided and returns the solution to the board in the parameter sol.*/
+ * createWorkspace - A function that allocates the arrays and keeps the environment the ILP of a geometry is solved with.
+ * freeWorkspace - A function that frees a workspace.
+ * findSol - A function that checks if we have a solution for the board provided and decodes it into the workspace.
+ * createRelaxation - A function that builds the LP relaxation of the board model, used by guess and guess_hint.
+ * solveRelaxation - A function that re-solves the kept-alive relaxation after fixing the currently filled cells.
+ * freeRelaxation - A function that frees the relaxation model.*/
 
 #include <stdlib.h>
 #include <stdio.h>
 #include "game.h"
 #include "gurobi.h"
 #include "MainAux.h"
+#include "control.h"
+#include "geometry.h"
+#include "trace.h"
+#include "lpBackend.h"
 
 void freeGRBdata(int* ind, double* val, double* obj, char* vtype) {
-	/*Free the arrays of values needed for the calculation of the gurobi functions.Used upon finish or upon error*/
+	/*Free the arrays of values needed for the calculation of the gurobi functions*/
 	free(ind);
 	free(val);
 	free(obj);
 	free(vtype);
 }
 
-int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountFilled, GRBenv *env, GRBmodel *model, double* obj, char* vtype) {
+int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountFilled, const LPBackend *backend, LPModel *model) {
 	/*Add the constraints of the ILP model to the model
 	 INPUT: int cols, rows - Integers representing the amount of columns and rows in a single block in the board.
 	 int *ind - Array that holds the variable indices of non-zero values in constraints.
 	 double *val - Array that holds the values for non-zero values in constraints.
 	 int *filled - An array holding the already filled cells in the board, each cell take 3 spaces, for column, row and value of the cell.
 	 int amount Filled - The amount of already filled cells in the game board.
-	 Other variables - Holds information of the model for gurobi such as the enviroment, the model itself, the type of the variables and the objective function.
+	 const LPBackend *backend, LPModel *model - The backend and the model the constraints are added to.
 	 OUTPUT: The function returns (-1) on error and (0) on success.*/
-	int col, row, value, i, j, error, N;
+	int col, row, value, box, i, error, N;
+	const int *cells;
+	const Geometry *geo = getGeometry(m, n);/*m is the number of rows in a block here*/
 	N = n*m;
+	if (geo == NULL)
+		return -1;
 	/*Only one number per cell constraints*/
 	for (col = 0; col < N; col++) {
 		for (row = 0; row < N; row++) {
@@ -36,13 +50,9 @@ int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountF
 				ind[value] = col * N * N + row * N + value;
 				val[value] = 1;
 			}
-			error = GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1.0, NULL);
-			/*constraint name is defaulted because we don't care what it's name is*/
-			if (error) {
-				printf("ERROR %d in cell constraints GRBaddconstr(): %s\n", error, GRBgeterrormsg(env));
-				freeGRBdata(ind, val, obj, vtype);
+			error = backend->addConstr(model, N, ind, val, LP_EQUAL, 1.0);
+			if (error)
 				return -1;
-			}
 		}
 	}
 	/*Same number only once per row constraints*/
@@ -52,13 +62,9 @@ int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountF
 				ind[row] = col * N * N + row * N + value;
 				val[row] = 1;
 			}
-			error = GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1.0, NULL);
-			/*constraint name is defaulted because we don't care what it's name is*/
-			if (error) {
-				printf("ERROR %d in row constraints GRBaddconstr(): %s\n", error, GRBgeterrormsg(env));
-				freeGRBdata(ind, val, obj, vtype);
+			error = backend->addConstr(model, N, ind, val, LP_EQUAL, 1.0);
+			if (error)
 				return -1;
-			}
 		}
 	}
 	/*Same number only once per col constraints*/
@@ -68,203 +74,271 @@ int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountF
 				ind[col] = col * N * N + row * N + value;
 				val[col] = 1;
 			}
-			error = GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1.0, NULL);
-			/*Constraint name is defaulted because we don't care what it's name is*/
-			if (error) {
-				printf("ERROR %d in col constraints GRBaddconstr(): %s\n", error, GRBgeterrormsg(env));
-				freeGRBdata(ind, val, obj, vtype);
+			error = backend->addConstr(model, N, ind, val, LP_EQUAL, 1.0);
+			if (error)
 				return -1;
-			}
 		}
 	}
-	/*Same number only one per block*/
-	for (col = 0; col < m; col++) {/*block row index*/
-		for (row = 0; row < n; row++) {/*block col index*/
-			for (value = 0; value < n * m; value++) {/*cell number index*/
-				for (i = 0; i < n; i++) {/*cell row index*/
-					for (j = 0; j < m; j++) {/*cell col index*/
-						ind[i * m + j] = (col * n + i) * N * N + (row * m + j) * N + value;
-						val[i * m + j] = 1;
-					}
-				}
-				error = GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1.0, NULL);
-				/*constraint name is defaulted because we don't care what it's name is*/
-				if (error) {
-					printf("ERROR %d in block constraints GRBaddconstr(): %s\n", error, GRBgeterrormsg(env));
-					freeGRBdata(ind, val, obj, vtype);
-					return -1;
-				}
+	/*Same number only one per block, the cells of every block come from the geometry tables*/
+	for (box = 0; box < N; box++) {
+		cells = geo->unitCells + (2 * N + box) * N;
+		for (value = 0; value < N; value++) {/*cell number index*/
+			for (i = 0; i < N; i++) {
+				ind[i] = geo->colOf[cells[i]] * N * N + geo->rowOf[cells[i]] * N + value;
+				val[i] = 1;
 			}
+			error = backend->addConstr(model, N, ind, val, LP_EQUAL, 1.0);
+			if (error)
+				return -1;
 		}
 	}
 	/*Cells already filled constraints*/
-	for (i = 0; col < amountFilled; i++) {/*data is in col row val triplets*/
-		/*+0 is the col,+1 is the row,+2 is the value, we do -1 since indexing start from 0 and the value starts from 1*/
-		ind[0] = filled[col * 3] * N + filled[(col * 3) + 1] * N * N + filled[(col * 3) + 2] - 1;
+	for (i = 0; i < amountFilled; i++) {/*data is in row col val triplets*/
+		/*+0 is the row,+1 is the col,+2 is the value, we do -1 since indexing start from 0 and the value starts from 1*/
+		ind[0] = filled[i * 3] * N + filled[(i * 3) + 1] * N * N + filled[(i * 3) + 2] - 1;
 		val[0] = 1;
-		error = GRBaddconstr(model, 1, ind, val, GRB_EQUAL, 1.0, NULL);
-		/*constraint name is defaulted because we don't care what it's name is*/
-		if (error) {
-			printf("ERROR %d in filled constraints GRBaddconstr(): %s\n", error, GRBgeterrormsg(env));
-			freeGRBdata(ind, val, obj, vtype);
+		error = backend->addConstr(model, 1, ind, val, LP_EQUAL, 1.0);
+		if (error)
 			return -1;
-		}
 	}
 	return 0;
 }
 
-int addVars(int m, int n, int* ind, double* val, double* obj, char* vtype, GRBenv *env, GRBmodel *model) {
-	/* Adds variables to the model and set the variables to be binary.
+int addVars(int m, int n, double* obj, char* vtype, char varType, const LPBackend *backend, LPModel *model) {
+	/* Adds variables to the model and set the variables to be of type varType (binary for the ILP, continuous for the relaxation).
 	 INPUT: int cols, rows - Integers representing the amount of columns and rows in a single block in the board.
-	 int *ind - Array that holds the variable indices of non-zero values in constraints.
-	 double *val - Array that holds the values for non-zero values in constraints.
-	 int *filled - An array holding the already filled cells in the board, each cell take 3 spaces, for column, row and value of the cell.
-	 int amount Filled - The amount of already filled cells in the game board.
-	 Other variables - Holds information of the model for gurobi such as the enviroment, the model itself, the type of the variables and the objective function.
+	 double *obj - The coefficients of the variables in the objective function.
+	 char *vtype - Array in size N^3 to set the types of the variables in.
+	 char varType - LP_BINARY or LP_CONTINUOUS.
+	 const LPBackend *backend, LPModel *model - The backend and the model the variables are added to.
 	 OUTPUT: The function returns (-1) on error and (0) on success.*/
-	int col, row, value, error, N;
+	int col, row, value, N;
 	N = n*m;
-	/*Set the variables to be binary*/
+	/*Set the type of the variables*/
 	for (col = 0; col < N; col++) {
 		for (row = 0; row < N; row++) {
 			for (value = 0; value < N; value++) {
-				vtype[col * N * N + row * N + value] = GRB_BINARY;
+				vtype[col * N * N + row * N + value] = varType;
 			}
 		}
 	}
-	/* Add variables to model */
-	error = GRBaddvars(model, N * N * N, 0, NULL, NULL, NULL, obj, NULL, NULL, vtype, NULL);
-	if (error) {
-		printf("ERROR %d GRBaddvars(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
-	}
-	/* Change objective sense to maximization */
-	error = GRBsetintattr(model, GRB_INT_ATTR_MODELSENSE, GRB_MAXIMIZE);
-	if (error) {
-		printf("ERROR %d GRBsetintattr(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
-	}
-	/* Update the model - to integrate new variables */
-	error = GRBupdatemodel(model);
-	if (error) {
-		printf("ERROR %d GRBupdatemodel(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
+	/* Add variables to model, and change objective sense to maximization */
+	if (backend->addVars(model, N * N * N, obj, vtype) || backend->setSense(model, LP_MAXIMIZE))
 		return -1;
-	}
 	return 0;
 }
 
-int findSol(int m, int n, int* filled, int amountFilled, double* sol) {
-	GRBenv *env = NULL;
-	GRBmodel *model = NULL;
-	int N, error = 0;
-	int* ind; /*Which variable are used in each constraint*/
-	double* val; /*The coefficients of the constraints*/
-	double *obj = { 0 };
-	char* vtype; /*What type the variable will be (all will be binary)*/
-	int optimstatus;
-	N = n*m;
-	/*allocation space for the arrays*/
-	ind = (int*) calloc(N, sizeof(int));
-	if(ind == NULL){
-		printf("ERROR in calloc memory for the gurobi function.\n");
-		return -1;
-	}
-	val = (double*) calloc(N, sizeof(double));
-	if(val == NULL){
+SolverWorkspace* createWorkspace(int n, int m) {
+	/* Allocates the arrays of the ILP for a board whose blocks have n rows and m columns. The environment of the LP backend is loaded
+	 by the first solve and kept, so only the model is built and freed on every solve.
+	 OUTPUT: A pointer to the new workspace, or NULL on error (an appropriate message is printed).*/
+	SolverWorkspace *ws;
+	int N = n*m;
+	ws = (SolverWorkspace*) calloc(1, sizeof(SolverWorkspace));
+	if (ws == NULL) {
 		printf("ERROR in calloc memory for the gurobi function.\n");
-		free(ind);
-		return -1;
-	}
-	vtype = (char*) calloc(N * N * N, sizeof(char));
-	if(vtype == NULL){
-		printf("ERROR in calloc memory for the gurobi function.\n");
-		free(ind);
-		free(val);
-		return -1;
+		return NULL;
 	}
-	obj = (double*) calloc(N * N * N, sizeof(double));
-	if(obj == NULL){
+	ws->n = n;
+	ws->m = m;
+	ws->backend = lpBackend();
+	ws->ind = (int*) calloc(N, sizeof(int));
+	ws->val = (double*) calloc(N, sizeof(double));
+	ws->vtype = (char*) calloc(N * N * N, sizeof(char));
+	ws->obj = (double*) calloc(N * N * N, sizeof(double));
+	ws->sol = (double*) calloc(N * N * N, sizeof(double));
+	ws->filled = (int*) calloc(N * N * 3, sizeof(int));
+	ws->values = (int*) calloc(N * N, sizeof(int));
+	ws->answer = (int*) calloc(N * N, sizeof(int));
+	if (ws->ind == NULL || ws->val == NULL || ws->vtype == NULL || ws->obj == NULL || ws->sol == NULL || ws->filled == NULL
+			|| ws->values == NULL || ws->answer == NULL) {
 		printf("ERROR in calloc memory for the gurobi function.\n");
-		free(ind);
-		free(val);
-		free(vtype);
-		return -1;
+		freeWorkspace(ws);
+		return NULL;
 	}
-	/* Create environment - log file is mip1.log */
-	error = GRBloadenv(&env, "mip1.log");
-	if (error) {
-		printf("ERROR %d GRBloadenv(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
+	return ws;
+}
+
+void freeWorkspace(SolverWorkspace *ws) {
+	/*Frees the arrays of the workspace and its environment*/
+	if (ws == NULL)
+		return;
+	if (ws->env != NULL)
+		ws->backend->freeEnv(ws->env);
+	freeGRBdata(ws->ind, ws->val, ws->obj, ws->vtype);
+	free(ws->sol);
+	free(ws->filled);
+	free(ws->values);
+	free(ws->answer);
+	free(ws);
+}
+
+static void decodeWorkspace(SolverWorkspace *ws) {
+	/*Decodes the variables of the last solve into the value of every cell: one pass over the N^3 variables,
+	 every variable that is 1 gives its cell its value*/
+	int i, N = ws->n * ws->m;
+	for (i = 0; i < N * N * N; i++) {
+		if (ws->sol[i] > 0.5)/*variable i is col*N*N + row*N + value-1*/
+			ws->values[((i / N) % N) * N + i / (N * N)] = i % N + 1;
 	}
+}
 
-	/*Cancel log being written to console*/
-	error = GRBsetintparam(env, GRB_INT_PAR_LOGTOCONSOLE, 0);
-	if (error) {
-		printf("ERROR %d GRBsetintparam(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
+int findSol(SolverWorkspace *ws, int amountFilled, SolveControl *control) {
+	/* Solves the ILP of the board whose filled cells are in ws->filled.
+	 INPUT: SolverWorkspace *ws - The workspace of the geometry of the board, ws->filled holds amountFilled cells as row, col, value triplets.
+	 int amountFilled - The amount of filled cells in the board.
+	 SolveControl *control - Stops the optimization when it is cancelled or its time runs out, may be NULL.
+	 OUTPUT: (1) if a solution was found - ws->values then holds the value of every cell, row by row - (0) if there is no solution,
+	 (2) if the control stopped the optimization first, or (-1) on error (an appropriate message is printed).*/
+	const LPBackend *backend = ws->backend;
+	LPModel *model;
+	int error, status, result = -1, N = ws->n * ws->m;
+	/* Create the environment - log file is mip1.log */
+	if (ws->env == NULL)
+		ws->env = backend->loadEnv("mip1.log", 0);
+	if (ws->env == NULL)
 		return -1;
-	}
 
 	/* Create an empty model named "mip1" */
-	error = GRBnewmodel(env, &model, "mip1", 0, NULL, NULL, NULL, NULL, NULL);
-	if (error) {
-		printf("ERROR %d GRBnewmodel(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
+	model = backend->newModel(ws->env, "mip1");
+	if (model == NULL)
 		return -1;
-	}
 	/*Sets the variables to be binary type*/
-	if (addVars(m, n, ind, val, obj, vtype, env, model))
-		return -1;
+	TRACE_BEGIN("addVars");
+	error = addVars(ws->n, ws->m, ws->obj, ws->vtype, LP_BINARY, backend, model);
+	TRACE_END("addVars");
+	if (error)
+		goto QUIT;
 
 	/*Adds the constraints of the model*/
-	if (addConstraints(m, n, ind, val, filled, amountFilled, env, model, obj, vtype))
-		return -1;
+	TRACE_BEGIN("addConstraints");
+	error = addConstraints(ws->n, ws->m, ws->ind, ws->val, ws->filled, amountFilled, backend, model);
+	TRACE_END("addConstraints");
+	if (error)
+		goto QUIT;
 
-	/*  Optimize model - need to call this before calculation  */
-	error = GRBoptimize(model);
-	if (error) {
-		printf("ERROR %d GRBoptimize(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
+	/*  Optimize model, the control can stop it  */
+	TRACE_BEGIN("optimize");
+	error = backend->optimize(model, control, &status);
+	TRACE_END("optimize");
+	if (error)
+		goto QUIT;
+	if (status != LP_OPTIMAL) {/*No solution, or stopped by the control before finding out*/
+		result = status == LP_STOPPED ? 2 : 0;
+		goto QUIT;
 	}
+	/* Get the solution - the assignment to each variable */
+	if (backend->getX(model, 0, N * N * N, ws->sol))
+		goto QUIT;
+	decodeWorkspace(ws);
+	result = 1;/*found solution,and it's stored in ws->values*/
 
-	/* Write model to 'mip1.lp' - this is not necessary but very helpful */
-	error = GRBwrite(model, "mip1.lp");
-	if (error) {
-		printf("ERROR %d GRBwrite(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
-	}
+QUIT:
+	/* Free the model, the environment stays for the next solve */
+	backend->freeModel(model);
+	return result;
+}
 
-	/* Get solution information - the status of the model: infeasible or feasible,which means there isn't a solution or there is a solution*/
-	error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
-	if (error) {
-		printf("ERROR %d GRBgetintattr(): %s\n", error, GRBgeterrormsg(env));
-		freeGRBdata(ind, val, obj, vtype);
-		return -1;
+LPContext* createRelaxation(int n, int m, Rng *rng) {
+	/* Builds the LP relaxation of the board: the same variables and constraints as the ILP of findSol, but the variables are continuous
+	 and the objective has random positive weights, so the optimal vertex spreads its weight over the values that fit each cell.
+	 No cell is fixed yet, solveRelaxation fixes the filled cells before every solve.
+	 INPUT: int n, m - Integers representing the amount of rows and columns in a single block in the board.
+	        Rng *rng - The random stream the objective weights are drawn from.
+	 OUTPUT: A pointer to the new context, or NULL on error (an appropriate message is printed).*/
+	LPContext *context;
+	int* ind;
+	double* val;
+	double* obj;
+	char* vtype;
+	int i, N;
+	N = n*m;
+	context = (LPContext*) calloc(1, sizeof(LPContext));
+	if (context == NULL) {
+		printf("ERROR in calloc memory for the gurobi function.\n");
+		return NULL;
 	}
-	if (optimstatus == GRB_INFEASIBLE) {/*Was there no solution?if so do this*/
-		/* Free model and environment,and return that there was no solution to this board */
-		GRBfreemodel(model);
-		GRBfreeenv(env);
+	context->n = n;
+	context->m = m;
+	context->backend = lpBackend();
+	context->fixedValues = (int*) calloc(N * N, sizeof(int));
+	ind = (int*) calloc(N, sizeof(int));
+	val = (double*) calloc(N, sizeof(double));
+	vtype = (char*) calloc(N * N * N, sizeof(char));
+	obj = (double*) calloc(N * N * N, sizeof(double));
+	if (context->fixedValues == NULL || ind == NULL || val == NULL || vtype == NULL || obj == NULL) {
+		printf("ERROR in calloc memory for the gurobi function.\n");
 		freeGRBdata(ind, val, obj, vtype);
-		return 0;
+		freeRelaxation(context);
+		return NULL;
 	}
-	/* Get the solution - the assignment to each variable */
-	error = GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, N * N * N, sol);
-	if (error) {
-		printf("ERROR %d GRBgetdblattrarray(): %s\n", error, GRBgeterrormsg(env));
+	/*Random weights in [1,N] so the relaxation doesn't prefer the low values*/
+	for (i = 0; i < N * N * N; i++) {
+		obj[i] = 1 + rngBelow(rng, N);
+	}
+	/*Between guesses only bounds change - the backend re-solves from the previous basis when it can*/
+	context->env = context->backend->loadEnv("guess.log", LP_OPTION_RESOLVE);
+	if (context->env != NULL)
+		context->model = context->backend->newModel(context->env, "guess");
+	if (context->model == NULL
+			|| addVars(n, m, obj, vtype, LP_CONTINUOUS, context->backend, context->model)
+			|| addConstraints(n, m, ind, val, NULL, 0, context->backend, context->model)) {
 		freeGRBdata(ind, val, obj, vtype);
+		freeRelaxation(context);
+		return NULL;
+	}
+	freeGRBdata(ind, val, obj, vtype);
+	return context;
+}
+
+int solveRelaxation(LPContext *context, Game *game, double *sol) {
+	/* Fixes the filled cells of the game in the relaxation and re-solves it from the previous basis.
+	 A filled cell is fixed by raising the lower bound of its (cell, value) variable to 1, the cell constraint then forces the other values to 0.
+	 Only cells whose value changed since the last solve have their bounds touched.
+	 INPUT: LPContext *context - The relaxation, built for the geometry of the game.
+	 Game *game - The game whose filled cells are fixed.
+	 double *sol - A double array in size N^3 to hold the score of every (cell, value) pair.
+	 OUTPUT: (1) if the relaxation is feasible and sol was filled, (0) if it is infeasible, (-1) on error.*/
+	int row, col, value, prevValue, error, status, N;
+	N = context->n * context->m;
+	for (row = 0; row < N; row++) {
+		for (col = 0; col < N; col++) {
+			value = game->board[row][col].value;
+			prevValue = context->fixedValues[row * N + col];
+			if (value == prevValue)
+				continue;
+			if (prevValue != 0) {
+				if (context->backend->setLowerBound(context->model, col * N * N + row * N + prevValue - 1, 0.0))
+					return -1;
+			}
+			if (value != 0) {
+				if (context->backend->setLowerBound(context->model, col * N * N + row * N + value - 1, 1.0))
+					return -1;
+			}
+			context->fixedValues[row * N + col] = value;
+		}
+	}
+	TRACE_BEGIN("optimize");
+	error = context->backend->optimize(context->model, NULL, &status);
+	TRACE_END("optimize");
+	if (error)
 		return -1;
+	if (status != LP_OPTIMAL) {/*Infeasible (or unbounded, which can't happen with these constraints)*/
+		return 0;
 	}
+	if (context->backend->getX(context->model, 0, N * N * N, sol))
+		return -1;
+	return 1;
+}
 
-	/* Free model and environment,and return that there was a solution to this board */
-	GRBfreemodel(model);
-	GRBfreeenv(env);
-	freeGRBdata(ind, val, obj, vtype);
-	return 1;/*found solution,and it's stored in sol*/
+void freeRelaxation(LPContext *context) {
+	/*Free the relaxation model, its environment and the context itself*/
+	if (context == NULL)
+		return;
+	if (context->model != NULL)
+		context->backend->freeModel(context->model);
+	if (context->env != NULL)
+		context->backend->freeEnv(context->env);
+	free(context->fixedValues);
+	free(context);
 }
@@ -1,21 +1,70 @@
 
-/* Header file which contains the functions that we use in order to use Gurobi for solving boards using ILP. Including the following functions:
- * findSol - The function needs the amount of columns and rows that are in a block in the current game, an array representing all the currently
- *           filled cells in the board, the number of cells that are filled in the board, and a pointer to a double array that will hold the
- *           solution found for the board. The format of the filled cells should be 3 spaces for each cell, representing the column, row and value in the cell.
- *           The function will update the double array with the solution if any was found, and will return (1) if a solution was found, (0) if
- *           no solution was found, or (-1) if an error occurred (and an appropriate message will be printed). No changes will be made to the game board.*/
+/* Header file which contains the functions that we use in order to solve boards using ILP, through the LP backend (see lpBackend.h).
+ * Including the following functions:
+ * createWorkspace - Allocates the arrays the ILP of a geometry is built and solved with, once per geometry instead of once per solve.
+ * freeWorkspace - Frees a workspace and the environment it keeps.
+ * findSol - The function needs the workspace of the geometry of the current game, with all the currently filled cells of the board in
+ *           ws->filled (3 spaces for each cell, representing the row, column and value in the cell), and the number of cells that are
+ *           filled in the board. The function will decode the solution into ws->values if any was found, and will return (1) if a solution
+ *           was found, (0) if no solution was found, (2) if the control stopped the search before it found out, or (-1) if an error occurred
+ *           (and an appropriate message will be printed). No changes will be made to the game board.
+ * createRelaxation - Builds the continuous (LP) relaxation of the board model once per geometry. The model is kept alive between calls.
+ *           Its random objective weights are drawn from the given stream.
+ * solveRelaxation - Fixes the filled cells of the game in the kept-alive relaxation and re-solves it. Only the cells that changed since the
+ *           last call are touched, so a backend that keeps its basis re-optimizes from it instead of building and solving a new model.
+ *           The scores of every (cell, value) pair are returned in sol, in the layout of the variables of findSol.
+ * freeRelaxation - Frees the relaxation model and its environment.*/
 
 #ifndef GUROBIFUNC_H_
 #define GUROBIFUNC_H_
+#include "game.h"
+#include "control.h"
+#include "lpBackend.h"
+
+/* the LP relaxation of a board, kept alive between guesses so re-solving starts from the previous basis */
+typedef struct LPContext{
+	const LPBackend *backend;
+	LPEnv *env;
+	LPModel *model;
+	int n;
+	int m;
+	int *fixedValues; /* the value each cell (row*N+col) is fixed to in the model, 0 if the cell is free */
+}LPContext;
+
+/* the arrays the ILP of a geometry is solved with. the environment is loaded by the first solve and kept warm, only the model
+ * is built for every solve */
+typedef struct SolverWorkspace{
+	int n;
+	int m;
+	const LPBackend *backend;
+	LPEnv *env; /* NULL until the first solve */
+	int *ind; /* N: the variables of one constraint */
+	double *val; /* N: their coefficients */
+	char *vtype; /* N^3 */
+	double *obj; /* N^3, all zero - any solution will do */
+	double *sol; /* N^3: the variables of the last solve, or the scores of the relaxation */
+	int *filled; /* 3*N*N: the filled cells, row, col and value */
+	int *values; /* N*N: the value of every cell in the last solution, row by row */
+	int *answer; /* N*N: a solution for the commands that need one, like hint and generate */
+}SolverWorkspace;
 
 void freeGRBdata(int* ind, double* val, double* obj, char* vtype);
 
-int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountFilled, GRBenv *env, GRBmodel *model, double* obj, char* vtype);
+int addConstraints(int m, int n, int* ind, double* val, int* filled, int amountFilled, const LPBackend *backend, LPModel *model);
+
+int addVars(int m, int n, double* obj, char* vtype, char varType, const LPBackend *backend, LPModel *model);
+
+SolverWorkspace* createWorkspace(int n, int m);
+
+void freeWorkspace(SolverWorkspace *ws);
+
+int findSol(SolverWorkspace *ws, int amountFilled, SolveControl *control);
+
+LPContext* createRelaxation(int n, int m, Rng *rng);
 
-int addVars(int m, int n, int* ind, double* val, double* obj, char* vtype, GRBenv *env, GRBmodel *model);
+int solveRelaxation(LPContext *context, Game *game, double *sol);
 
-int findSol(int m, int n, int* filled, int amountFilled, double* sol);
+void freeRelaxation(LPContext *context);
 
 
 #endif /* GUROBIFUNC_H_ */
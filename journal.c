@@ -0,0 +1,413 @@
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "journal.h"
+#include "movesList.h"
+
+/* Journal Module
+ * the file is a header and then fixed size records, each with a checksum of its fields. there are two buffers: appends
+ * copy the record to the filling one under the lock, and only the committer thread writes. it wakes every JOURNAL_SYNC_MS
+ * milliseconds, or as soon as the filling buffer holds JOURNAL_SYNC_RECORDS records, swaps the buffers under the lock and
+ * writes and syncs the full one without it, so an append never waits for the disk. the buffers grow, a snapshot is
+ * appended whole under one hold of the lock and so is always committed in one piece; a crash in the middle of its write
+ * leaves a snapshot with missing cells at the end, which recovery drops.
+ * depth counts the open journalEnter scopes; replay runs with a depth of 1, so what it does isn't journaled again.
+ */
+
+#define JOURNAL_MAGIC "SDKJRNL1"
+
+typedef struct JournalHeader{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+}JournalHeader;
+
+typedef struct JournalRecord{
+	uint8_t type;
+	uint8_t unused;
+	uint16_t row;
+	uint16_t col;
+	uint16_t value;
+	uint16_t prevValue;
+	uint16_t unused2;
+	uint32_t check; /* the checksum of the fields above */
+}JournalRecord;
+
+typedef struct Journal{
+	int fd;
+	JournalRecord *buffers[2];
+	int capacity[2];
+	int filling; /* the buffer appends go to, the committer writes the other one */
+	int count; /* the records in the filling buffer */
+	int depth;
+	int failed; /* a write or an allocation failed, nothing more is appended */
+	int stop; /* tells the committer to exit */
+	pthread_t committer;
+	pthread_mutex_t lock; /* protects everything above */
+	pthread_cond_t wake;
+	const JournalRecord *recovered; /* the records to replay, in the mapped file */
+	size_t numRecovered;
+	void *map;
+	size_t mapLength;
+}Journal;
+
+static Journal journal;
+static int journaling = 0;
+
+/* FNV-1a of the fields of the record */
+static uint32_t checksum(const JournalRecord *record){
+	const unsigned char *bytes = (const unsigned char*)record;
+	uint32_t hash = 2166136261u;
+	size_t i;
+	for(i = 0; i < offsetof(JournalRecord, check); i++){
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* swap the buffers and write the full one and make it durable. called by the committer with the lock held, which is
+ * released for the write */
+static void commit(){
+	const JournalRecord *full = journal.buffers[journal.filling];
+	size_t length = journal.count*sizeof(JournalRecord), written = 0;
+	ssize_t res;
+	int ok = 1;
+	if(journal.count == 0)
+		return;
+	journal.filling ^= 1;
+	journal.count = 0;
+	pthread_mutex_unlock(&journal.lock);
+	while(written < length){
+		res = write(journal.fd, (const char*)full + written, length - written);
+		if(res < 0){
+			ok = 0;
+			break;
+		}
+		written += res;
+	}
+	fdatasync(journal.fd);
+	pthread_mutex_lock(&journal.lock);
+	if(!ok && !journal.failed){
+		printf("Error: the journal could not be written, journaling stops\n");
+		journal.failed = 1;
+	}
+}
+
+static void* committerThread(void *arg){
+	struct timespec wake;
+	(void)arg;
+	pthread_mutex_lock(&journal.lock);
+	for(;;){
+		if(!journal.stop && journal.count < JOURNAL_SYNC_RECORDS){
+			clock_gettime(CLOCK_REALTIME, &wake);
+			wake.tv_nsec += JOURNAL_SYNC_MS*1000000L;
+			wake.tv_sec += wake.tv_nsec/1000000000L;
+			wake.tv_nsec %= 1000000000L;
+			pthread_cond_timedwait(&journal.wake, &journal.lock, &wake);
+		}
+		/* whatever came in since the last wakeup waited less than JOURNAL_SYNC_MS */
+		commit();
+		if(journal.stop && journal.count == 0)
+			break;
+	}
+	pthread_mutex_unlock(&journal.lock);
+	return NULL;
+}
+
+/* make room for count more records in the filling buffer, the lock is held. returns 0 if nothing can be appended */
+static int reserve(int count){
+	JournalRecord *grown;
+	int f = journal.filling, newCap = journal.capacity[f] > 0 ? journal.capacity[f] : 2*JOURNAL_SYNC_RECORDS;
+	if(journal.failed)
+		return 0;
+	while(newCap < journal.count + count)
+		newCap *= 2;
+	if(newCap == journal.capacity[f])
+		return 1;
+	grown = (JournalRecord*)realloc(journal.buffers[f], newCap*sizeof(JournalRecord));
+	if(grown == NULL){
+		printf("Error: realloc has failed, journaling stops\n");
+		journal.failed = 1;
+		return 0;
+	}
+	journal.buffers[f] = grown;
+	journal.capacity[f] = newCap;
+	return 1;
+}
+
+/* copy a record to the filling buffer, which reserve made room in. the lock is held */
+static void append(int type, int row, int col, int value, int prevValue){
+	JournalRecord *record;
+	record = &journal.buffers[journal.filling][journal.count++];
+	memset(record, 0, sizeof(JournalRecord));
+	record->type = (uint8_t)type;
+	record->row = (uint16_t)row;
+	record->col = (uint16_t)col;
+	record->value = (uint16_t)value;
+	record->prevValue = (uint16_t)prevValue;
+	record->check = checksum(record);
+	/* the committer takes a full buffer right away */
+	if(journal.count == JOURNAL_SYNC_RECORDS)
+		pthread_cond_signal(&journal.wake);
+}
+
+/* map the journal and find the valid records, returns 0 if it isn't a journal */
+static int mapJournal(){
+	struct stat st;
+	const JournalHeader *header;
+	size_t i, j, numRecords, length;
+	if(fstat(journal.fd, &st) != 0 || (size_t)st.st_size < sizeof(JournalHeader))
+		return 0;
+	journal.mapLength = st.st_size;
+	journal.map = mmap(NULL, journal.mapLength, PROT_READ, MAP_PRIVATE, journal.fd, 0);
+	if(journal.map == MAP_FAILED){
+		journal.map = NULL;
+		return 0;
+	}
+	header = (const JournalHeader*)journal.map;
+	if(memcmp(header->magic, JOURNAL_MAGIC, 8) != 0 || header->recordSize != sizeof(JournalRecord))
+		return 0;
+	journal.recovered = (const JournalRecord*)((const char*)journal.map + sizeof(JournalHeader));
+	numRecords = (journal.mapLength - sizeof(JournalHeader))/sizeof(JournalRecord);
+	/* the journal ends at the first record that doesn't check, the rest was being written when the process died */
+	for(i = 0; i < numRecords; i++){
+		if(journal.recovered[i].check != checksum(&journal.recovered[i]))
+			break;
+	}
+	/* and so does a snapshot that was cut short, it is dropped whole */
+	for(j = 0; j < i; j += length){
+		length = 1;
+		if(journal.recovered[j].type == JOURNAL_BOARD)
+			length += (size_t)journal.recovered[j].row*journal.recovered[j].col*journal.recovered[j].row*journal.recovered[j].col;
+		if(length > i - j){
+			i = j;
+			break;
+		}
+	}
+	journal.numRecovered = i;
+	return 1;
+}
+
+int openJournal(const char *path, int recover){
+	JournalHeader header;
+	off_t end;
+	memset(&journal, 0, sizeof(Journal));
+	journal.fd = open(path, recover ? O_RDWR | O_CREAT : O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(journal.fd < 0){
+		printf("Error: can't open the journal %s\n", path);
+		return 0;
+	}
+	if(recover && !mapJournal()){
+		if(journal.map != NULL)
+			munmap(journal.map, journal.mapLength);
+		journal.map = NULL;
+		journal.recovered = NULL;
+		printf("Error: %s is not a journal, starting a new one\n", path);
+		recover = 0;
+	}
+	if(recover){
+		/* cut the torn end, new records go right after the valid ones */
+		end = sizeof(JournalHeader) + journal.numRecovered*sizeof(JournalRecord);
+		if(ftruncate(journal.fd, end) != 0 || lseek(journal.fd, end, SEEK_SET) != end){
+			printf("Error: can't write the journal %s\n", path);
+			close(journal.fd);
+			return 0;
+		}
+	}
+	else{
+		if(ftruncate(journal.fd, 0) != 0){
+			printf("Error: can't write the journal %s\n", path);
+			close(journal.fd);
+			return 0;
+		}
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, JOURNAL_MAGIC, 8);
+		header.version = 1;
+		header.recordSize = sizeof(JournalRecord);
+		if(write(journal.fd, &header, sizeof(header)) != (ssize_t)sizeof(header)){
+			printf("Error: can't write the journal %s\n", path);
+			close(journal.fd);
+			return 0;
+		}
+		fdatasync(journal.fd);
+	}
+	pthread_mutex_init(&journal.lock, NULL);
+	pthread_cond_init(&journal.wake, NULL);
+	if(pthread_create(&journal.committer, NULL, committerThread, NULL) != 0){
+		printf("Error: could not start the journal thread\n");
+		close(journal.fd);
+		return 0;
+	}
+	journaling = 1;
+	return 1;
+}
+
+/* drop the recovered records and continue with an empty journal, the lock is held */
+static int restartJournal(){
+	off_t end = sizeof(JournalHeader);
+	munmap(journal.map, journal.mapLength);
+	journal.map = NULL;
+	journal.recovered = NULL;
+	journal.numRecovered = 0;
+	if(ftruncate(journal.fd, end) != 0 || lseek(journal.fd, end, SEEK_SET) != end){
+		printf("Error: the journal could not be written, journaling stops\n");
+		journal.failed = 1;
+		return 0;
+	}
+	fdatasync(journal.fd);
+	return 1;
+}
+
+/* replay a snapshot that starts at record, returns the number of records it takes or -1 if it doesn't fit */
+static long replayBoard(Game *game, const JournalRecord *record, size_t left){
+	int n = record->row, m = record->col, N = n*m, i;
+	if(N <= 0 || left < (size_t)(1 + N*N))
+		return -1;
+	if(n != game->n || m != game->m){
+		freeBoard(game);
+		game->n = n;
+		game->m = m;
+		game->board = createBoard(game);
+	}
+	/* a snapshot starts a new history, like loading a board does */
+	clearNextMoves(game);
+	clearPrevMoves(game);
+	game->currentMove = NULL;
+	game->mode = record->value;
+	game->numOfFilledCells = 0;
+	for(i = 0; i < N*N; i++){
+		game->board[i/N][i%N].value = record[1+i].value;
+		game->board[i/N][i%N].fixed = record[1+i].prevValue;
+		if(record[1+i].value != 0)
+			game->numOfFilledCells++;
+	}
+	return 1 + N*N;
+}
+
+int replayJournal(Game *game){
+	const JournalRecord *record;
+	size_t i = 0;
+	long taken;
+	int N, replayed = 0;
+	if(journal.recovered == NULL)
+		return 0;
+	journal.depth = 1;
+	while(i < journal.numRecovered){
+		record = &journal.recovered[i++];
+		N = game->n*game->m;
+		switch(record->type){
+		case JOURNAL_MOVE:
+			if(record->row < 1 || record->row > N || record->col < 1 || record->col > N)
+				break;
+			clearNextMoves(game);
+			setMove(game, record->row, record->col, record->value, record->prevValue);
+			if(game->board[record->row-1][record->col-1].value == 0 && record->value != 0)
+				game->numOfFilledCells++;
+			else if(game->board[record->row-1][record->col-1].value != 0 && record->value == 0)
+				game->numOfFilledCells--;
+			game->board[record->row-1][record->col-1].value = record->value;
+			break;
+		case JOURNAL_CHAIN:
+			if(game->currentMove != NULL)
+				game->currentMove->chained = 1;
+			break;
+		case JOURNAL_UNDO:
+			undo(game, 0);
+			break;
+		case JOURNAL_REDO:
+			redo(game, 0);
+			break;
+		case JOURNAL_RESTART:
+			reset(game);
+			break;
+		case JOURNAL_BOARD:
+			taken = replayBoard(game, record, journal.numRecovered - i + 1);
+			if(taken < 0){
+				printf("Error: the journal holds a board that can't be restored, starting a new session\n");
+				/* nothing was appended while replaying, so the committer has nothing in hand */
+				pthread_mutex_lock(&journal.lock);
+				restartJournal();
+				journal.depth = 0;
+				pthread_mutex_unlock(&journal.lock);
+				return -1;
+			}
+			i += taken - 1;
+			break;
+		}
+		replayed++;
+	}
+	journal.depth = 0;
+	munmap(journal.map, journal.mapLength);
+	journal.map = NULL;
+	journal.recovered = NULL;
+	printf("Recovered %d changes from the journal\n", replayed);
+	return replayed;
+}
+
+void closeJournal(){
+	if(!journaling)
+		return;
+	/* the committer writes what is left before it exits */
+	pthread_mutex_lock(&journal.lock);
+	journal.stop = 1;
+	pthread_cond_signal(&journal.wake);
+	pthread_mutex_unlock(&journal.lock);
+	pthread_join(journal.committer, NULL);
+	if(journal.map != NULL)
+		munmap(journal.map, journal.mapLength);
+	close(journal.fd);
+	free(journal.buffers[0]);
+	free(journal.buffers[1]);
+	journaling = 0;
+}
+
+void journalRecord(int type, int row, int col, int value, int prevValue){
+	if(!journaling)
+		return;
+	pthread_mutex_lock(&journal.lock);
+	if(journal.depth == 0 && reserve(1))
+		append(type, row, col, value, prevValue);
+	pthread_mutex_unlock(&journal.lock);
+}
+
+void journalEnter(int type){
+	if(!journaling)
+		return;
+	pthread_mutex_lock(&journal.lock);
+	if(journal.depth == 0 && reserve(1))
+		append(type, 0, 0, 0, 0);
+	journal.depth++;
+	pthread_mutex_unlock(&journal.lock);
+}
+
+void journalLeave(){
+	if(!journaling)
+		return;
+	pthread_mutex_lock(&journal.lock);
+	journal.depth--;
+	pthread_mutex_unlock(&journal.lock);
+}
+
+void journalBoard(Game *game){
+	int N = game->n*game->m, i;
+	if(!journaling)
+		return;
+	pthread_mutex_lock(&journal.lock);
+	/* the whole snapshot goes into one buffer, and so into one write */
+	if(journal.depth == 0 && reserve(1 + N*N)){
+		append(JOURNAL_BOARD, game->n, game->m, game->mode, 0);
+		for(i = 0; i < N*N; i++)
+			append(JOURNAL_CELL, 0, 0, game->board[i/N][i%N].value, game->board[i/N][i%N].fixed);
+	}
+	pthread_mutex_unlock(&journal.lock);
+}
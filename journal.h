@@ -0,0 +1,50 @@
+/* Header file of the journal module. An optional append-only binary journal of every change of the board and of its
+ * undo/redo history, so a session survives a crash of the process.
+ * The moves are recorded where they are made (setMove), undo, redo and restart as themselves, and the changes that don't
+ * go through the history (a loaded or generated board) as a snapshot of the whole board.
+ * Records go to a buffer, which a thread of the journal writes with one write and one fdatasync (a group commit) every
+ * JOURNAL_SYNC_RECORDS records or every JOURNAL_SYNC_MS milliseconds, whichever comes first, so a crash loses at most
+ * that much and a set never waits for the disk. A snapshot is always in one commit.
+ * Recovery maps the journal, checks the records (a torn record or an incomplete snapshot at the end, from a crash in
+ * the middle of a write, ends the journal) and replays them in memory, restoring the board and the history. The
+ * journal then goes on from there.*/
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+#include "game.h"
+
+#define JOURNAL_SYNC_RECORDS 64
+#define JOURNAL_SYNC_MS 200
+
+/* the types of the records */
+#define JOURNAL_MOVE 1 /* a move of the history: row, col (from 1), value and prevValue */
+#define JOURNAL_CHAIN 2 /* the last move was made together with the one before it */
+#define JOURNAL_UNDO 3
+#define JOURNAL_REDO 4
+#define JOURNAL_RESTART 5
+#define JOURNAL_BOARD 6 /* a snapshot of the board follows: n, m and mode, then N*N JOURNAL_CELL records */
+#define JOURNAL_CELL 7 /* value and fixed of one cell of a snapshot */
+
+/* start journaling to the file at path. with recover the records already in it are kept for replayJournal and the
+ * journal goes on after them, otherwise the file starts empty. returns 1 on success and 0 on an error */
+int openJournal(const char *path, int recover);
+
+/* replay the records kept by openJournal on the game, if there are any.
+ * returns the number of records replayed, or -1 if the journal holds a board the game can't take. the journal is then
+ * emptied and the game is left half replayed, the caller starts it over */
+int replayJournal(Game *game);
+
+/* commit the buffered records, wait for them to be on disk and close the journal */
+void closeJournal();
+
+/* record a change. a change made inside a journalEnter scope is part of the recorded change and isn't recorded */
+void journalRecord(int type, int row, int col, int value, int prevValue);
+
+/* record a change that is made of other changes, which aren't recorded until the matching journalLeave */
+void journalEnter(int type);
+void journalLeave();
+
+/* record a snapshot of the board of the game */
+void journalBoard(Game *game);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <string.h>
+#include "lpBackend.h"
+
+/* LP Backend Module
+ * the backends of this build, the first one is the default. the choice is made at startup, before any model exists,
+ * and every environment and model keeps the backend it was made with.
+ */
+
+#ifndef SUDOKU_NO_GUROBI
+extern const LPBackend gurobiBackend;
+#endif
+extern const LPBackend builtinBackend;
+
+static const LPBackend *backends[] = {
+#ifndef SUDOKU_NO_GUROBI
+	&gurobiBackend,
+#endif
+	&builtinBackend
+};
+#define NUM_BACKENDS ((int)(sizeof(backends)/sizeof(backends[0])))
+
+static const LPBackend *current = NULL;
+
+const LPBackend* lpBackend(){
+	if(current == NULL)
+		current = backends[0];
+	return current;
+}
+
+int setLPBackend(const char *name){
+	int i;
+	for(i = 0; i < NUM_BACKENDS; i++){
+		if(strcmp(backends[i]->name, name) == 0){
+			current = backends[i];
+			return 1;
+		}
+	}
+	printf("Error: there is no LP backend %s in this build\n", name);
+	return 0;
+}
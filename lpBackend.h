@@ -0,0 +1,64 @@
+/* Header file of the LP backend interface. The ILP of validate, hint and generate and the LP relaxation of guess are built
+ * and solved through it, so the rest of the project doesn't call a solver library directly.
+ * The interface covers what the project uses: an environment, models with binary or continuous variables, sparse linear
+ * constraints, the lower bounds of variables, optimizing under a SolveControl and reading the values of the variables.
+ * Two backends implement it:
+ * gurobi - the Gurobi C library. Left out of builds with -DSUDOKU_NO_GUROBI, for machines without Gurobi and its license.
+ * builtin - a self-contained bounded simplex with branch-and-bound, see lpBuiltin.c. The default when gurobi is left out.
+ * Every function that returns an int returns 0 on success, and prints a message and returns a nonzero value on an error.*/
+
+#ifndef LPBACKEND_H_
+#define LPBACKEND_H_
+#include "control.h"
+
+/* the types of variables and the senses of constraints, the same characters as Gurobi's */
+#define LP_BINARY 'B'
+#define LP_CONTINUOUS 'C'
+#define LP_EQUAL '='
+#define LP_LESS_EQUAL '<'
+#define LP_GREATER_EQUAL '>'
+#define LP_INFINITY 1e100
+
+#define LP_MINIMIZE 1
+#define LP_MAXIMIZE -1
+
+/* options of an environment */
+#define LP_OPTION_RESOLVE 1 /* its models are re-solved after changes of bounds, re-solve from the previous basis if possible */
+
+/* the outcomes of optimize */
+#define LP_INFEASIBLE 0
+#define LP_OPTIMAL 1
+#define LP_STOPPED 2 /* the control stopped the optimization before it found out */
+
+typedef struct LPEnv LPEnv;
+typedef struct LPModel LPModel;
+
+typedef struct LPBackend{
+	const char *name;
+	/* an environment for models, logged to logFile if the backend keeps a log. NULL on an error */
+	LPEnv* (*loadEnv)(const char *logFile, int options);
+	void (*freeEnv)(LPEnv *env);
+	/* an empty model that minimizes. NULL on an error */
+	LPModel* (*newModel)(LPEnv *env, const char *name);
+	void (*freeModel)(LPModel *model);
+	/* LP_MINIMIZE or LP_MAXIMIZE */
+	int (*setSense)(LPModel *model, int sense);
+	/* add count variables with the objective coefficients obj and the types vtype. they are between 0 and 1 if binary,
+	 * and at least 0 if continuous */
+	int (*addVars)(LPModel *model, int count, const double *obj, const char *vtype);
+	/* add the constraint sum of val[i]*x[ind[i]] (sense) rhs */
+	int (*addConstr)(LPModel *model, int count, const int *ind, const double *val, char sense, double rhs);
+	int (*setLowerBound)(LPModel *model, int var, double lb);
+	/* optimize the model, the control (may be NULL) can stop it. *status is one of the LP_ outcomes */
+	int (*optimize)(LPModel *model, SolveControl *control, int *status);
+	/* the values of the variables first to first+count-1 after an optimize that found them */
+	int (*getX)(LPModel *model, int first, int count, double *x);
+}LPBackend;
+
+/* the backend new environments and models are made with */
+const LPBackend* lpBackend();
+
+/* use the backend called name from now on. returns 1 on success and 0 if there is no such backend in this build */
+int setLPBackend(const char *name);
+
+#endif /* LPBACKEND_H_ */
@@ -0,0 +1,1128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lpBackend.h"
+
+/* Builtin LP Backend Module
+ * the LP backend interface without any library: a bounded simplex under a depth-first branch-and-bound.
+ * a model keeps its constraints row by row as they are added. optimize turns them into columns once and then works on
+ * a copy of the bounds: every node of the search tightens bounds, and the tightenings are recorded on a trail that is
+ * popped when the node is left, like the trail of the back-tracking search.
+ * the sudoku models are made of "exactly one" rows (coefficients 1, = 1), so before the simplex runs a node propagates
+ * them: a variable at 1 puts the others of its rows at 0, and a row with one variable left that isn't at 0 puts it at 1.
+ * the LP keeps all the variables and rows of the model, a variable the node fixed is a column whose bounds are equal.
+ * the first node is solved by the primal simplex from a basis of artificial variables (phase one drives them to 0,
+ * phase two optimizes the objective), with the largest reduced cost and Bland's rule after a run of degenerate pivots.
+ * nodes only change bounds, which keeps the last basis dual feasible, so every other node is re-solved from the basis
+ * the previous one ended with by the dual simplex, in a few pivots. the inverse of the basis is a dense matrix updated
+ * after every pivot, and inverted again from the basis when the updates drifted.
+ * the branching picks the exactly-one row with the fewest free variables that has a fractional variable, and tries the
+ * largest variable in it at 1 first.
+ * with LP_OPTION_RESOLVE the model keeps the basis (and its inverse) an optimize ended with. a model only changes bounds
+ * between optimizes, so the next one starts its first node from that basis by the dual simplex, like any other node.
+ * adding variables or rows drops the kept basis.
+ */
+
+#define BUILTIN_FEAS_TOL 1e-9
+#define BUILTIN_INFEAS_TOL 1e-7 /* the phase one objective per row above which there is no feasible point */
+#define BUILTIN_PIVOT_TOL 1e-9
+#define BUILTIN_COST_TOL 1e-9
+#define BUILTIN_INT_TOL 1e-6
+#define BUILTIN_DRIFT_TOL 1e-9 /* the residual of the basic values above which the basis is inverted again */
+#define BUILTIN_RECOMPUTE_PIVOTS 64 /* pivots between recomputations of the basic values from the inverse */
+#define BUILTIN_BLAND_AFTER 50 /* degenerate pivots in a row before Bland's rule */
+#define BUILTIN_MAX_PIVOTS_FACTOR 50 /* a simplex that takes more than this times its columns and rows pivots failed */
+
+#define AT_LOWER 0
+#define AT_UPPER 1
+#define BASIC 2
+
+#define NOT_CONVERGED -2 /* the dual simplex gave up, the node is solved by the primal simplex */
+
+struct LPEnv{
+	int options;
+};
+
+struct LPModel{
+	int sense; /* LP_MINIMIZE or LP_MAXIMIZE */
+	int numVars;
+	int varCap;
+	double *obj;
+	double *lb;
+	double *ub;
+	char *vtype;
+	int numRows;
+	int rowCap;
+	int rowStartCap;
+	int *rowStart; /* the entries of row r are rowStart[r] to rowStart[r+1]-1 */
+	char *rowSense;
+	double *rhs;
+	int nnz;
+	int nnzCap;
+	int *rowInd;
+	double *rowVal;
+	double *x; /* the values found by the last optimize, NULL if it found none */
+	int resolve; /* the env has LP_OPTION_RESOLVE, the basis of an optimize is kept for the next one */
+	int *keptStatus; /* the status of every column of the LP at the end of the last optimize, NULL if no basis is kept */
+	int *keptBasis; /* the basic column of every row */
+	double *keptArtSign; /* the signs of the artificials, their columns depend on them */
+	double *keptBinv; /* the inverse of the basis, numRows*numRows */
+};
+
+/* the state of one optimize */
+typedef struct Builtin{
+	LPModel *model;
+	SolveControl *control;
+	int stopped;
+	int failed;
+	/* the model by columns */
+	int *colStart;
+	int *colRow;
+	double *colVal;
+	int *partition; /* 1 for the exactly-one rows */
+	/* the bounds of the current node and the trail that restores them */
+	double *lo;
+	double *up;
+	int *trailVar;
+	double *trailLo;
+	double *trailUp;
+	int trailSize;
+	int *queue; /* the exactly-one rows to propagate, a circular buffer of numRows */
+	int *queued;
+	int queueHead;
+	int queueSize;
+	/* the LP: a column for every variable, a slack for every inequality and an artificial for every row */
+	int m;
+	int ns;
+	int numCols;
+	int haveBasis; /* the basis is dual feasible, the next node starts from it */
+	int *slackRow;
+	double *slackSign;
+	double *artSign;
+	double *cLo;
+	double *cUp;
+	double *cost;
+	double *value;
+	int *status;
+	int *basis;
+	double *binv; /* m*m, row by row */
+	double *work; /* m*m, for inverting the basis again. allocated the first time it is */
+	double *y; /* the duals, cost of the basis times binv */
+	double *alpha; /* the entering column times binv */
+	double *residual;
+	int *pivotNonzeros; /* the nonzeros of the pivot row of binv */
+	int entryRow; /* a slack or artificial column of the LP */
+	double entryVal;
+	/* the values of the node and the best integral values found */
+	double *nodeX;
+	double nodeObj;
+	double *best;
+	double bestObj;
+	int haveBest;
+}Builtin;
+
+static LPEnv* builtinLoadEnv(const char *logFile, int options){
+	LPEnv *env = (LPEnv*) calloc(1, sizeof(LPEnv));
+	(void)logFile;
+	if (env == NULL) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		return NULL;
+	}
+	env->options = options;
+	return env;
+}
+
+static void builtinFreeEnv(LPEnv *env){
+	free(env);
+}
+
+static LPModel* builtinNewModel(LPEnv *env, const char *name){
+	LPModel *model = (LPModel*) calloc(1, sizeof(LPModel));
+	(void)name;
+	if (model == NULL) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		return NULL;
+	}
+	model->sense = LP_MINIMIZE;
+	model->resolve = (env->options & LP_OPTION_RESOLVE) != 0;
+	model->rowStart = (int*) calloc(1, sizeof(int));
+	model->rowStartCap = 1;
+	if (model->rowStart == NULL) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		free(model);
+		return NULL;
+	}
+	return model;
+}
+
+/* forget the kept basis, the LP of the model changed shape */
+static void dropBasis(LPModel *model){
+	free(model->keptStatus);
+	free(model->keptBasis);
+	free(model->keptArtSign);
+	free(model->keptBinv);
+	model->keptStatus = NULL;
+	model->keptBasis = NULL;
+	model->keptArtSign = NULL;
+	model->keptBinv = NULL;
+}
+
+static void builtinFreeModel(LPModel *model){
+	if (model == NULL)
+		return;
+	dropBasis(model);
+	free(model->obj);
+	free(model->lb);
+	free(model->ub);
+	free(model->vtype);
+	free(model->rowStart);
+	free(model->rowSense);
+	free(model->rhs);
+	free(model->rowInd);
+	free(model->rowVal);
+	free(model->x);
+	free(model);
+}
+
+static int builtinSetSense(LPModel *model, int sense){
+	model->sense = sense == LP_MAXIMIZE ? LP_MAXIMIZE : LP_MINIMIZE;
+	/* the costs change, the kept basis may not be dual feasible for them */
+	dropBasis(model);
+	return 0;
+}
+
+/* grow *array of *cap elements of size to hold need, doubling. returns 0 on a memory error */
+static int grow(void **array, int *cap, int need, size_t size){
+	void *grown;
+	int newCap = *cap > 0 ? *cap : 16;
+	if (need <= *cap)
+		return 1;
+	while (newCap < need)
+		newCap *= 2;
+	grown = realloc(*array, newCap * size);
+	if (grown == NULL)
+		return 0;
+	*array = grown;
+	*cap = newCap;
+	return 1;
+}
+
+static int builtinAddVars(LPModel *model, int count, const double *obj, const char *vtype){
+	int i, cap = model->varCap;
+	if (!grow((void**) &model->obj, &cap, model->numVars + count, sizeof(double))
+			|| (cap = model->varCap, !grow((void**) &model->lb, &cap, model->numVars + count, sizeof(double)))
+			|| (cap = model->varCap, !grow((void**) &model->ub, &cap, model->numVars + count, sizeof(double)))
+			|| (cap = model->varCap, !grow((void**) &model->vtype, &cap, model->numVars + count, sizeof(char)))) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		return 1;
+	}
+	model->varCap = cap;
+	for (i = 0; i < count; i++) {
+		model->obj[model->numVars + i] = obj != NULL ? obj[i] : 0;
+		model->vtype[model->numVars + i] = vtype != NULL ? vtype[i] : LP_CONTINUOUS;
+		model->lb[model->numVars + i] = 0;
+		model->ub[model->numVars + i] = model->vtype[model->numVars + i] == LP_BINARY ? 1 : LP_INFINITY;
+	}
+	model->numVars += count;
+	/* a new variable makes the values of the last optimize incomplete */
+	free(model->x);
+	model->x = NULL;
+	dropBasis(model);
+	return 0;
+}
+
+static int builtinAddConstr(LPModel *model, int count, const int *ind, const double *val, char sense, double rhs){
+	int i, cap = model->rowCap;
+	for (i = 0; i < count; i++) {
+		if (ind[i] < 0 || ind[i] >= model->numVars) {
+			printf("ERROR in the builtin LP backend: constraint on variable %d, the model has %d\n", ind[i], model->numVars);
+			return 1;
+		}
+	}
+	if (!grow((void**) &model->rowSense, &cap, model->numRows + 1, sizeof(char))
+			|| (cap = model->rowCap, !grow((void**) &model->rhs, &cap, model->numRows + 1, sizeof(double)))
+			|| !grow((void**) &model->rowStart, &model->rowStartCap, model->numRows + 2, sizeof(int))) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		return 1;
+	}
+	model->rowCap = cap;
+	cap = model->nnzCap;
+	if (!grow((void**) &model->rowInd, &cap, model->nnz + count, sizeof(int))
+			|| (cap = model->nnzCap, !grow((void**) &model->rowVal, &cap, model->nnz + count, sizeof(double)))) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		return 1;
+	}
+	model->nnzCap = cap;
+	memcpy(model->rowInd + model->nnz, ind, count * sizeof(int));
+	memcpy(model->rowVal + model->nnz, val, count * sizeof(double));
+	model->nnz += count;
+	model->rowSense[model->numRows] = sense;
+	model->rhs[model->numRows] = rhs;
+	model->numRows++;
+	model->rowStart[model->numRows] = model->nnz;
+	dropBasis(model);
+	return 0;
+}
+
+static int builtinSetLowerBound(LPModel *model, int var, double lb){
+	if (var < 0 || var >= model->numVars) {
+		printf("ERROR in the builtin LP backend: no variable %d\n", var);
+		return 1;
+	}
+	model->lb[var] = lb;
+	return 0;
+}
+
+static int builtinGetX(LPModel *model, int first, int count, double *x){
+	if (model->x == NULL || first < 0 || first + count > model->numVars) {
+		printf("ERROR in the builtin LP backend: there are no values for these variables\n");
+		return 1;
+	}
+	memcpy(x, model->x + first, count * sizeof(double));
+	return 0;
+}
+
+/* ----- the bounds of the nodes ----- */
+
+static void clearQueue(Builtin *s){
+	while (s->queueSize > 0) {
+		s->queued[s->queue[s->queueHead]] = 0;
+		s->queueHead = (s->queueHead + 1) % s->model->numRows;
+		s->queueSize--;
+	}
+}
+
+/* put the exactly-one rows of var in the queue */
+static void queueRows(Builtin *s, int var){
+	int e, row, numRows = s->model->numRows;
+	for (e = s->colStart[var]; e < s->colStart[var + 1]; e++) {
+		row = s->colRow[e];
+		if (s->partition[row] && !s->queued[row]) {
+			s->queued[row] = 1;
+			s->queue[(s->queueHead + s->queueSize) % numRows] = row;
+			s->queueSize++;
+		}
+	}
+}
+
+/* tighten the bounds of var to lo and up on the trail. returns 0 if they cross */
+static int tighten(Builtin *s, int var, double lo, double up){
+	if (lo < s->lo[var])
+		lo = s->lo[var];
+	if (up > s->up[var])
+		up = s->up[var];
+	if (lo == s->lo[var] && up == s->up[var])
+		return 1;
+	s->trailVar[s->trailSize] = var;
+	s->trailLo[s->trailSize] = s->lo[var];
+	s->trailUp[s->trailSize] = s->up[var];
+	s->trailSize++;
+	s->lo[var] = lo;
+	s->up[var] = up;
+	if (lo > up + BUILTIN_FEAS_TOL)
+		return 0;
+	queueRows(s, var);
+	return 1;
+}
+
+static void undoTo(Builtin *s, int mark){
+	while (s->trailSize > mark) {
+		s->trailSize--;
+		s->lo[s->trailVar[s->trailSize]] = s->trailLo[s->trailSize];
+		s->up[s->trailVar[s->trailSize]] = s->trailUp[s->trailSize];
+	}
+}
+
+/* propagate the queued exactly-one rows until nothing changes. returns 0 if a row can't be satisfied */
+static int propagate(Builtin *s){
+	LPModel *model = s->model;
+	int row, e, var, ones, numFree, lastFree;
+	while (s->queueSize > 0) {
+		row = s->queue[s->queueHead];
+		s->queueHead = (s->queueHead + 1) % model->numRows;
+		s->queueSize--;
+		s->queued[row] = 0;
+		ones = 0;
+		numFree = 0;
+		lastFree = -1;
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			var = model->rowInd[e];
+			if (s->lo[var] >= 1 - BUILTIN_FEAS_TOL)
+				ones++;
+			else if (s->up[var] > BUILTIN_FEAS_TOL) {
+				numFree++;
+				lastFree = var;
+			}
+		}
+		if (ones > 1 || (ones == 0 && numFree == 0)) {
+			clearQueue(s);
+			return 0;
+		}
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			var = model->rowInd[e];
+			if (ones == 1 && s->lo[var] < 1 - BUILTIN_FEAS_TOL && s->up[var] > BUILTIN_FEAS_TOL) {
+				if (!tighten(s, var, s->lo[var], 0)) {
+					clearQueue(s);
+					return 0;
+				}
+			}
+		}
+		if (ones == 0 && numFree == 1 && !tighten(s, lastFree, 1, 1)) {
+			clearQueue(s);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* ----- the simplex ----- */
+
+/* the entries of column c of the LP: the rows in *rows and the coefficients in *vals. returns their number */
+static int lpColumn(Builtin *s, int c, int **rows, double **vals){
+	int numVars = s->model->numVars;
+	if (c < numVars) {
+		*rows = s->colRow + s->colStart[c];
+		*vals = s->colVal + s->colStart[c];
+		return s->colStart[c + 1] - s->colStart[c];
+	}
+	if (c < numVars + s->ns) {
+		s->entryRow = s->slackRow[c - numVars];
+		s->entryVal = s->slackSign[c - numVars];
+	}
+	else {
+		s->entryRow = c - numVars - s->ns;
+		s->entryVal = s->artSign[c - numVars - s->ns];
+	}
+	*rows = &s->entryRow;
+	*vals = &s->entryVal;
+	return 1;
+}
+
+/* the reduced cost of column c */
+static double reducedCost(Builtin *s, int c){
+	int i, count, *rows;
+	double d = s->cost[c], *vals;
+	count = lpColumn(s, c, &rows, &vals);
+	for (i = 0; i < count; i++)
+		d -= s->y[rows[i]] * vals[i];
+	return d;
+}
+
+/* the bounds of the node go to the columns of the variables, a nonbasic column moves with its bound */
+static void syncBounds(Builtin *s){
+	int c;
+	for (c = 0; c < s->model->numVars; c++) {
+		s->cLo[c] = s->lo[c];
+		s->cUp[c] = s->up[c];
+		if (s->status[c] == AT_UPPER && s->cUp[c] >= LP_INFINITY / 2)
+			s->status[c] = AT_LOWER;
+		if (s->status[c] != BASIC)
+			s->value[c] = s->status[c] == AT_LOWER ? s->cLo[c] : s->cUp[c];
+	}
+}
+
+/* inverts the basis again into binv by the Gauss-Jordan elimination of [B | I]. returns 0 if it is singular */
+static int refactor(Builtin *s){
+	int m = s->m, k, i, j, p, count, *rows;
+	double *vals, factor, *work;
+	if (s->work == NULL) {
+		s->work = (double*) malloc((size_t) m * m * sizeof(double) + 1);
+		if (s->work == NULL)
+			return 0;
+	}
+	work = s->work;
+	memset(work, 0, (size_t) m * m * sizeof(double));
+	memset(s->binv, 0, (size_t) m * m * sizeof(double));
+	for (k = 0; k < m; k++) {
+		count = lpColumn(s, s->basis[k], &rows, &vals);
+		for (i = 0; i < count; i++)
+			work[(size_t) rows[i] * m + k] = vals[i];
+		s->binv[(size_t) k * m + k] = 1;
+	}
+	for (k = 0; k < m; k++) {
+		p = k;
+		for (i = k + 1; i < m; i++) {
+			if (fabs(work[(size_t) i * m + k]) > fabs(work[(size_t) p * m + k]))
+				p = i;
+		}
+		if (fabs(work[(size_t) p * m + k]) < BUILTIN_PIVOT_TOL)
+			return 0;
+		if (p != k) {
+			for (j = 0; j < m; j++) {
+				factor = work[(size_t) k * m + j];
+				work[(size_t) k * m + j] = work[(size_t) p * m + j];
+				work[(size_t) p * m + j] = factor;
+				factor = s->binv[(size_t) k * m + j];
+				s->binv[(size_t) k * m + j] = s->binv[(size_t) p * m + j];
+				s->binv[(size_t) p * m + j] = factor;
+			}
+		}
+		factor = work[(size_t) k * m + k];
+		for (j = 0; j < m; j++) {
+			work[(size_t) k * m + j] /= factor;
+			s->binv[(size_t) k * m + j] /= factor;
+		}
+		for (i = 0; i < m; i++) {
+			factor = work[(size_t) i * m + k];
+			if (i == k || factor == 0)
+				continue;
+			for (j = 0; j < m; j++) {
+				work[(size_t) i * m + j] -= factor * work[(size_t) k * m + j];
+				s->binv[(size_t) i * m + j] -= factor * s->binv[(size_t) k * m + j];
+			}
+		}
+	}
+	return 1;
+}
+
+/* recomputes the basic values and the duals from the inverse of the basis, taking out the drift of the updates.
+ * the basis is inverted again when the basic values don't satisfy the rows any more. returns 0 if it can't be */
+static int recompute(Builtin *s){
+	int c, i, k, count, *rows, m = s->m, attempt;
+	double sum, drift, *vals, *rhs = s->model->rhs;
+	for (attempt = 0; attempt < 2; attempt++) {
+		for (i = 0; i < m; i++)
+			s->residual[i] = rhs[i];
+		for (c = 0; c < s->numCols; c++) {
+			if (s->status[c] == BASIC || s->value[c] == 0)
+				continue;
+			count = lpColumn(s, c, &rows, &vals);
+			for (i = 0; i < count; i++)
+				s->residual[rows[i]] -= vals[i] * s->value[c];
+		}
+		for (k = 0; k < m; k++) {
+			sum = 0;
+			for (i = 0; i < m; i++)
+				sum += s->binv[(size_t) k * m + i] * s->residual[i];
+			s->value[s->basis[k]] = sum;
+		}
+		/* B times the basic values against what the nonbasic columns leave of the rows */
+		for (k = 0; k < m; k++) {
+			count = lpColumn(s, s->basis[k], &rows, &vals);
+			for (i = 0; i < count; i++)
+				s->residual[rows[i]] -= vals[i] * s->value[s->basis[k]];
+		}
+		drift = 0;
+		for (i = 0; i < m; i++) {
+			if (fabs(s->residual[i]) > drift)
+				drift = fabs(s->residual[i]);
+		}
+		if (drift <= BUILTIN_DRIFT_TOL)
+			break;
+		if (attempt == 1 || !refactor(s))
+			return 0;
+	}
+	for (i = 0; i < m; i++)
+		s->y[i] = 0;
+	for (k = 0; k < m; k++) {
+		if (s->cost[s->basis[k]] == 0)
+			continue;
+		for (i = 0; i < m; i++)
+			s->y[i] += s->cost[s->basis[k]] * s->binv[(size_t) k * m + i];
+	}
+	return 1;
+}
+
+/* the column q entering the basis, times binv, into alpha */
+static void enteringColumn(Builtin *s, int q){
+	int m = s->m, k, i, count, *rows;
+	double *vals;
+	count = lpColumn(s, q, &rows, &vals);
+	for (k = 0; k < m; k++) {
+		s->alpha[k] = 0;
+		for (i = 0; i < count; i++)
+			s->alpha[k] += s->binv[(size_t) k * m + rows[i]] * vals[i];
+	}
+}
+
+/* column q, whose reduced cost is dq, replaces the basic column of row r: row r of binv is divided by the pivot and
+ * taken out of the others, and the duals move by dq times it. only the nonzeros of row r are touched */
+static void pivotBasis(Builtin *s, int r, int q, double dq){
+	int m = s->m, i, j, k, numNonzeros = 0;
+	double pivot = s->alpha[r], *rowR = s->binv + (size_t) r * m, *rowK;
+	for (i = 0; i < m; i++) {
+		if (rowR[i] != 0) {
+			rowR[i] /= pivot;
+			s->pivotNonzeros[numNonzeros++] = i;
+		}
+	}
+	for (k = 0; k < m; k++) {
+		if (k == r || s->alpha[k] == 0)
+			continue;
+		rowK = s->binv + (size_t) k * m;
+		for (j = 0; j < numNonzeros; j++)
+			rowK[s->pivotNonzeros[j]] -= s->alpha[k] * rowR[s->pivotNonzeros[j]];
+	}
+	for (j = 0; j < numNonzeros; j++)
+		s->y[s->pivotNonzeros[j]] += dq * rowR[s->pivotNonzeros[j]];
+	s->basis[r] = q;
+	s->status[q] = BASIC;
+}
+
+/* the primal simplex: minimizes the costs from the current primal feasible basis.
+ * returns LP_OPTIMAL, LP_STOPPED or -1 on an error */
+static int runPrimal(Builtin *s){
+	int m = s->m, c, q, k, r, degenerate = 0, bland = 0, dir, leave, sincePivot = 0;
+	long pivots = 0, maxPivots = (long) BUILTIN_MAX_PIVOTS_FACTOR * (s->numCols + m + 1);
+	double d, dq, best, t, limit, delta;
+	if (!recompute(s)) {
+		printf("ERROR in the builtin LP backend: the basis is singular\n");
+		return -1;
+	}
+	for (;;) {
+		if (shouldStop(s->control))
+			return LP_STOPPED;
+		if (sincePivot >= BUILTIN_RECOMPUTE_PIVOTS) {
+			if (!recompute(s)) {
+				printf("ERROR in the builtin LP backend: the basis is singular\n");
+				return -1;
+			}
+			sincePivot = 0;
+		}
+		/* pricing */
+		q = -1;
+		dq = 0;
+		best = 0;
+		for (c = 0; c < s->numCols; c++) {
+			if (s->status[c] == BASIC || s->cUp[c] - s->cLo[c] <= BUILTIN_FEAS_TOL)
+				continue;
+			d = reducedCost(s, c);
+			if ((s->status[c] == AT_LOWER && d < -BUILTIN_COST_TOL) || (s->status[c] == AT_UPPER && d > BUILTIN_COST_TOL)) {
+				if (bland) {
+					q = c;
+					dq = d;
+					break;
+				}
+				if (fabs(d) > best) {
+					best = fabs(d);
+					q = c;
+					dq = d;
+				}
+			}
+		}
+		if (q < 0)
+			return LP_OPTIMAL;
+		enteringColumn(s, q);
+		/* ratio test: the entering column moves dir, the first basic column to reach a bound leaves */
+		dir = s->status[q] == AT_LOWER ? 1 : -1;
+		t = s->cUp[q] - s->cLo[q];
+		leave = -1;
+		for (k = 0; k < m; k++) {
+			if (fabs(s->alpha[k]) <= BUILTIN_PIVOT_TOL)
+				continue;
+			c = s->basis[k];
+			delta = -dir * s->alpha[k];
+			if (delta < 0)
+				limit = (s->value[c] - s->cLo[c]) / -delta;
+			else if (s->cUp[c] < LP_INFINITY / 2)
+				limit = (s->cUp[c] - s->value[c]) / delta;
+			else
+				continue;
+			if (limit < 0)
+				limit = 0;
+			if (limit < t - BUILTIN_FEAS_TOL || (leave >= 0 && limit <= t + BUILTIN_FEAS_TOL
+					&& (bland ? c < s->basis[leave] : fabs(s->alpha[k]) > fabs(s->alpha[leave])))) {
+				t = limit < t ? limit : t;
+				leave = k;
+			}
+		}
+		if (t >= LP_INFINITY / 2) {
+			printf("ERROR in the builtin LP backend: the model is unbounded\n");
+			return -1;
+		}
+		for (k = 0; k < m; k++) {
+			if (s->alpha[k] != 0)
+				s->value[s->basis[k]] -= dir * t * s->alpha[k];
+		}
+		if (leave < 0) {
+			/* the entering column reached its other bound before any basic column did */
+			s->status[q] = dir > 0 ? AT_UPPER : AT_LOWER;
+			s->value[q] = dir > 0 ? s->cUp[q] : s->cLo[q];
+		}
+		else {
+			r = leave;
+			c = s->basis[r];
+			delta = -dir * s->alpha[r];
+			s->status[c] = delta < 0 ? AT_LOWER : AT_UPPER;
+			s->value[c] = delta < 0 ? s->cLo[c] : s->cUp[c];
+			s->value[q] += dir * t;
+			pivotBasis(s, r, q, dq);
+			sincePivot++;
+		}
+		/* stalling at a degenerate vertex turns to Bland's rule until the objective moves again */
+		if (t <= BUILTIN_FEAS_TOL)
+			degenerate++;
+		else
+			degenerate = 0;
+		bland = degenerate >= BUILTIN_BLAND_AFTER;
+		if (++pivots > maxPivots) {
+			printf("ERROR in the builtin LP backend: the simplex did not converge\n");
+			return -1;
+		}
+	}
+}
+
+/* the dual simplex: makes the current dual feasible basis primal feasible. the basic column farthest out of its
+ * bounds leaves, and the column that keeps the reduced costs feasible enters.
+ * returns LP_OPTIMAL, LP_INFEASIBLE, LP_STOPPED or NOT_CONVERGED */
+static int runDual(Builtin *s){
+	int m = s->m, c, q, k, r, i, count, *rows, toLower, sincePivot = 0, eligible;
+	long pivots = 0, maxPivots = (long) BUILTIN_MAX_PIVOTS_FACTOR * (m + 1);
+	double worst, a, d, dq, ratio, bestRatio, bestAlpha, target, t, *vals, *rowR;
+	if (!recompute(s))
+		return NOT_CONVERGED;
+	for (;;) {
+		if (shouldStop(s->control))
+			return LP_STOPPED;
+		if (sincePivot >= BUILTIN_RECOMPUTE_PIVOTS) {
+			if (!recompute(s))
+				return NOT_CONVERGED;
+			sincePivot = 0;
+		}
+		/* leaving row */
+		r = -1;
+		worst = BUILTIN_FEAS_TOL;
+		for (k = 0; k < m; k++) {
+			c = s->basis[k];
+			if (s->cLo[c] - s->value[c] > worst) {
+				worst = s->cLo[c] - s->value[c];
+				r = k;
+			}
+			else if (s->value[c] - s->cUp[c] > worst) {
+				worst = s->value[c] - s->cUp[c];
+				r = k;
+			}
+		}
+		if (r < 0)
+			return LP_OPTIMAL;
+		toLower = s->value[s->basis[r]] < s->cLo[s->basis[r]];
+		/* entering column: the smallest ratio of reduced cost to pivot row entry, the largest entry among ties */
+		rowR = s->binv + (size_t) r * m;
+		q = -1;
+		dq = 0;
+		bestRatio = LP_INFINITY;
+		bestAlpha = 0;
+		for (c = 0; c < s->numCols; c++) {
+			if (s->status[c] == BASIC || s->cUp[c] - s->cLo[c] <= BUILTIN_FEAS_TOL)
+				continue;
+			count = lpColumn(s, c, &rows, &vals);
+			a = 0;
+			for (i = 0; i < count; i++)
+				a += rowR[rows[i]] * vals[i];
+			if (fabs(a) <= BUILTIN_PIVOT_TOL)
+				continue;
+			if (toLower)
+				eligible = (s->status[c] == AT_LOWER && a < 0) || (s->status[c] == AT_UPPER && a > 0);
+			else
+				eligible = (s->status[c] == AT_LOWER && a > 0) || (s->status[c] == AT_UPPER && a < 0);
+			if (!eligible)
+				continue;
+			d = reducedCost(s, c);
+			ratio = fabs(d) / fabs(a);
+			/* a reduced cost with the wrong sign is noise around 0 */
+			if ((s->status[c] == AT_LOWER && d < 0) || (s->status[c] == AT_UPPER && d > 0))
+				ratio = 0;
+			if (ratio < bestRatio - BUILTIN_COST_TOL || (ratio <= bestRatio + BUILTIN_COST_TOL && fabs(a) > fabs(bestAlpha))) {
+				bestRatio = ratio < bestRatio ? ratio : bestRatio;
+				bestAlpha = a;
+				q = c;
+				dq = d;
+			}
+		}
+		/* nothing can bring the row back to its bound */
+		if (q < 0)
+			return LP_INFEASIBLE;
+		enteringColumn(s, q);
+		if (fabs(s->alpha[r]) <= BUILTIN_PIVOT_TOL)
+			return NOT_CONVERGED;
+		c = s->basis[r];
+		target = toLower ? s->cLo[c] : s->cUp[c];
+		t = (s->value[c] - target) / s->alpha[r];
+		for (k = 0; k < m; k++) {
+			if (s->alpha[k] != 0)
+				s->value[s->basis[k]] -= t * s->alpha[k];
+		}
+		s->value[q] += t;
+		s->value[c] = target;
+		s->status[c] = toLower ? AT_LOWER : AT_UPPER;
+		pivotBasis(s, r, q, dq);
+		sincePivot++;
+		if (++pivots > maxPivots)
+			return NOT_CONVERGED;
+	}
+}
+
+/* solves the LP of the node from a basis of artificials. returns LP_OPTIMAL, LP_INFEASIBLE, LP_STOPPED or -1 */
+static int solvePrimal(Builtin *s){
+	LPModel *model = s->model;
+	int c, i, k, count, *rows, numVars = model->numVars, res;
+	double infeasibility = 0, *vals;
+	s->haveBasis = 0;
+	for (c = 0; c < s->numCols; c++) {
+		s->cLo[c] = c < numVars ? s->lo[c] : 0;
+		s->cUp[c] = c < numVars ? s->up[c] : LP_INFINITY;
+		s->status[c] = AT_LOWER;
+		s->value[c] = s->cLo[c];
+	}
+	/* the artificials take what the nonbasic columns leave of every row */
+	for (i = 0; i < s->m; i++)
+		s->residual[i] = model->rhs[i];
+	for (c = 0; c < numVars; c++) {
+		if (s->value[c] == 0)
+			continue;
+		count = lpColumn(s, c, &rows, &vals);
+		for (i = 0; i < count; i++)
+			s->residual[rows[i]] -= vals[i] * s->value[c];
+	}
+	memset(s->binv, 0, (size_t) s->m * s->m * sizeof(double));
+	for (k = 0; k < s->m; k++) {
+		s->artSign[k] = s->residual[k] >= 0 ? 1 : -1;
+		c = numVars + s->ns + k;
+		s->basis[k] = c;
+		s->status[c] = BASIC;
+		s->binv[(size_t) k * s->m + k] = s->artSign[k];
+	}
+	/* phase one: drive the artificials to 0 */
+	for (c = 0; c < s->numCols; c++)
+		s->cost[c] = c >= numVars + s->ns ? 1 : 0;
+	res = runPrimal(s);
+	if (res != LP_OPTIMAL)
+		return res;
+	for (c = numVars + s->ns; c < s->numCols; c++)
+		infeasibility += s->value[c];
+	if (infeasibility > BUILTIN_INFEAS_TOL * (s->m + 1))
+		return LP_INFEASIBLE;
+	/* phase two: the artificials stay at 0, the basic ones leave the basis as the simplex goes */
+	for (c = 0; c < s->numCols; c++) {
+		if (c >= numVars + s->ns)
+			s->cUp[c] = 0;
+		s->cost[c] = c < numVars ? model->sense * model->obj[c] : 0;
+	}
+	res = runPrimal(s);
+	if (res == LP_OPTIMAL)
+		s->haveBasis = 1;
+	return res;
+}
+
+/* solves the LP of the node into nodeX and nodeObj. returns LP_OPTIMAL, LP_INFEASIBLE, LP_STOPPED or -1 on an error */
+static int solveLP(Builtin *s){
+	LPModel *model = s->model;
+	int res = NOT_CONVERGED, var;
+	if (s->haveBasis) {
+		syncBounds(s);
+		res = runDual(s);
+	}
+	if (res == NOT_CONVERGED)
+		res = solvePrimal(s);
+	if (res != LP_OPTIMAL)
+		return res;
+	s->nodeObj = 0;
+	for (var = 0; var < model->numVars; var++) {
+		s->nodeX[var] = s->value[var];
+		s->nodeObj += model->sense * model->obj[var] * s->nodeX[var];
+	}
+	return LP_OPTIMAL;
+}
+
+/* ----- the branch-and-bound ----- */
+
+static int isFractional(Builtin *s, int var){
+	double x = s->nodeX[var];
+	return s->model->vtype[var] == LP_BINARY && fabs(x - floor(x + 0.5)) > BUILTIN_INT_TOL;
+}
+
+/* the binary variable to branch on, -1 if the values of the node are integral */
+static int branchVariable(Builtin *s){
+	LPModel *model = s->model;
+	int row, e, var, numFree, bestVar = -1, bestFree = 0, rowVar;
+	for (row = 0; row < model->numRows; row++) {
+		if (!s->partition[row])
+			continue;
+		numFree = 0;
+		rowVar = -1;
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			var = model->rowInd[e];
+			if (s->up[var] - s->lo[var] > BUILTIN_FEAS_TOL)
+				numFree++;
+			if (isFractional(s, var) && (rowVar < 0 || s->nodeX[var] > s->nodeX[rowVar]))
+				rowVar = var;
+		}
+		if (rowVar >= 0 && (bestVar < 0 || numFree < bestFree)) {
+			bestVar = rowVar;
+			bestFree = numFree;
+		}
+	}
+	if (bestVar >= 0)
+		return bestVar;
+	for (var = 0; var < model->numVars; var++) {
+		if (isFractional(s, var))
+			return var;
+	}
+	return -1;
+}
+
+static void branch(Builtin *s, double parentBound){
+	int mark = s->trailSize, propagated, res, var;
+	if (s->stopped || s->failed)
+		return;
+	/* the node can't do better than its parent */
+	if (s->haveBest && parentBound >= s->bestObj - BUILTIN_COST_TOL)
+		return;
+	if (!propagate(s)) {
+		undoTo(s, mark);
+		return;
+	}
+	propagated = s->trailSize;
+	res = solveLP(s);
+	if (res != LP_OPTIMAL) {
+		if (res == LP_STOPPED)
+			s->stopped = 1;
+		else if (res < 0)
+			s->failed = 1;
+		undoTo(s, mark);
+		return;
+	}
+	if (s->haveBest && s->nodeObj >= s->bestObj - BUILTIN_COST_TOL) {
+		undoTo(s, mark);
+		return;
+	}
+	var = branchVariable(s);
+	if (var < 0) {
+		memcpy(s->best, s->nodeX, s->model->numVars * sizeof(double));
+		s->bestObj = s->nodeObj;
+		s->haveBest = 1;
+		undoTo(s, mark);
+		return;
+	}
+	parentBound = s->nodeObj;
+	if (tighten(s, var, 1, s->up[var]))
+		branch(s, parentBound);
+	else
+		clearQueue(s);
+	/* the other child starts from the propagated bounds of this node, only var changes */
+	undoTo(s, propagated);
+	if (s->stopped || s->failed) {
+		undoTo(s, mark);
+		return;
+	}
+	if (tighten(s, var, s->lo[var], 0))
+		branch(s, parentBound);
+	else
+		clearQueue(s);
+	undoTo(s, mark);
+}
+
+static void freeBuiltin(Builtin *s){
+	free(s->colStart);
+	free(s->colRow);
+	free(s->colVal);
+	free(s->partition);
+	free(s->lo);
+	free(s->up);
+	free(s->trailVar);
+	free(s->trailLo);
+	free(s->trailUp);
+	free(s->queue);
+	free(s->queued);
+	free(s->slackRow);
+	free(s->slackSign);
+	free(s->artSign);
+	free(s->cLo);
+	free(s->cUp);
+	free(s->cost);
+	free(s->value);
+	free(s->status);
+	free(s->basis);
+	free(s->binv);
+	free(s->work);
+	free(s->y);
+	free(s->alpha);
+	free(s->residual);
+	free(s->pivotNonzeros);
+	free(s->nodeX);
+	free(s->best);
+}
+
+/* allocates the state of an optimize, turns the rows of the model into columns and sets up the LP.
+ * returns 0 on a memory error */
+static int initBuiltin(Builtin *s, LPModel *model){
+	int n = model->numVars, rows = model->numRows, cols = n + 2 * rows, var, row, e;
+	s->model = model;
+	s->colStart = (int*) calloc(n + 1, sizeof(int));
+	s->colRow = (int*) calloc(model->nnz + 1, sizeof(int));
+	s->colVal = (double*) calloc(model->nnz + 1, sizeof(double));
+	s->partition = (int*) calloc(rows + 1, sizeof(int));
+	s->lo = (double*) calloc(n + 1, sizeof(double));
+	s->up = (double*) calloc(n + 1, sizeof(double));
+	/* a branch only raises lower bounds and lowers upper bounds, each at most once for 0-1 values */
+	s->trailVar = (int*) calloc(2 * n + 2, sizeof(int));
+	s->trailLo = (double*) calloc(2 * n + 2, sizeof(double));
+	s->trailUp = (double*) calloc(2 * n + 2, sizeof(double));
+	s->queue = (int*) calloc(rows + 1, sizeof(int));
+	s->queued = (int*) calloc(rows + 1, sizeof(int));
+	s->slackRow = (int*) calloc(rows + 1, sizeof(int));
+	s->slackSign = (double*) calloc(rows + 1, sizeof(double));
+	s->artSign = (double*) calloc(rows + 1, sizeof(double));
+	s->cLo = (double*) calloc(cols + 1, sizeof(double));
+	s->cUp = (double*) calloc(cols + 1, sizeof(double));
+	s->cost = (double*) calloc(cols + 1, sizeof(double));
+	s->value = (double*) calloc(cols + 1, sizeof(double));
+	s->status = (int*) calloc(cols + 1, sizeof(int));
+	s->basis = (int*) calloc(rows + 1, sizeof(int));
+	s->binv = (double*) calloc((size_t) rows * rows + 1, sizeof(double));
+	s->y = (double*) calloc(rows + 1, sizeof(double));
+	s->alpha = (double*) calloc(rows + 1, sizeof(double));
+	s->residual = (double*) calloc(rows + 1, sizeof(double));
+	s->pivotNonzeros = (int*) calloc(rows + 1, sizeof(int));
+	s->nodeX = (double*) calloc(n + 1, sizeof(double));
+	s->best = (double*) calloc(n + 1, sizeof(double));
+	if (s->colStart == NULL || s->colRow == NULL || s->colVal == NULL || s->partition == NULL || s->lo == NULL
+			|| s->up == NULL || s->trailVar == NULL || s->trailLo == NULL || s->trailUp == NULL || s->queue == NULL
+			|| s->queued == NULL || s->slackRow == NULL || s->slackSign == NULL || s->artSign == NULL || s->cLo == NULL
+			|| s->cUp == NULL || s->cost == NULL || s->value == NULL || s->status == NULL || s->basis == NULL
+			|| s->binv == NULL || s->y == NULL || s->alpha == NULL || s->residual == NULL || s->pivotNonzeros == NULL
+			|| s->nodeX == NULL || s->best == NULL)
+		return 0;
+	/* the columns */
+	for (e = 0; e < model->nnz; e++)
+		s->colStart[model->rowInd[e] + 1]++;
+	for (var = 0; var < n; var++)
+		s->colStart[var + 1] += s->colStart[var];
+	for (row = 0; row < rows; row++) {
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			var = model->rowInd[e];
+			s->colRow[s->colStart[var]] = row;
+			s->colVal[s->colStart[var]] = model->rowVal[e];
+			s->colStart[var]++;
+		}
+	}
+	for (var = n; var > 0; var--)
+		s->colStart[var] = s->colStart[var - 1];
+	s->colStart[0] = 0;
+	/* the slacks of the inequalities */
+	s->m = rows;
+	for (row = 0; row < rows; row++) {
+		if (model->rowSense[row] != LP_EQUAL) {
+			s->slackRow[s->ns] = row;
+			s->slackSign[s->ns] = model->rowSense[row] == LP_LESS_EQUAL ? 1 : -1;
+			s->ns++;
+		}
+	}
+	s->numCols = n + s->ns + rows;
+	memcpy(s->lo, model->lb, n * sizeof(double));
+	memcpy(s->up, model->ub, n * sizeof(double));
+	/* the exactly-one rows, their variables are at most 1 */
+	for (row = 0; row < rows; row++) {
+		s->partition[row] = model->rowSense[row] == LP_EQUAL && model->rhs[row] == 1;
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			if (model->rowVal[e] != 1 || model->lb[model->rowInd[e]] < 0)
+				s->partition[row] = 0;
+		}
+		if (!s->partition[row])
+			continue;
+		for (e = model->rowStart[row]; e < model->rowStart[row + 1]; e++) {
+			if (s->up[model->rowInd[e]] > 1)
+				s->up[model->rowInd[e]] = 1;
+		}
+		s->queued[row] = 1;
+		s->queue[s->queueSize++] = row;
+	}
+	return 1;
+}
+
+/* starts from the basis the model kept: the first node is solved by the dual simplex from it, once syncBounds moved
+ * the columns of the variables to the new bounds. the slacks and the artificials have the bounds of phase two */
+static void restoreBasis(Builtin *s){
+	LPModel *model = s->model;
+	int c, numVars = model->numVars;
+	memcpy(s->status, model->keptStatus, s->numCols * sizeof(int));
+	memcpy(s->basis, model->keptBasis, s->m * sizeof(int));
+	memcpy(s->artSign, model->keptArtSign, s->m * sizeof(double));
+	memcpy(s->binv, model->keptBinv, (size_t) s->m * s->m * sizeof(double));
+	for (c = 0; c < s->numCols; c++) {
+		s->cost[c] = c < numVars ? model->sense * model->obj[c] : 0;
+		if (c < numVars)
+			continue;
+		s->cLo[c] = 0;
+		s->cUp[c] = c < numVars + s->ns ? LP_INFINITY : 0;
+		if (s->status[c] != BASIC) {
+			s->status[c] = AT_LOWER;
+			s->value[c] = 0;
+		}
+	}
+	s->haveBasis = 1;
+}
+
+/* keeps the basis the optimize ended with in the model. a failed allocation just keeps none */
+static void keepBasis(Builtin *s){
+	LPModel *model = s->model;
+	if (model->keptStatus == NULL) {
+		model->keptStatus = (int*) malloc(s->numCols * sizeof(int) + 1);
+		model->keptBasis = (int*) malloc(s->m * sizeof(int) + 1);
+		model->keptArtSign = (double*) malloc(s->m * sizeof(double) + 1);
+		model->keptBinv = (double*) malloc((size_t) s->m * s->m * sizeof(double) + 1);
+		if (model->keptStatus == NULL || model->keptBasis == NULL || model->keptArtSign == NULL || model->keptBinv == NULL) {
+			dropBasis(model);
+			return;
+		}
+	}
+	memcpy(model->keptStatus, s->status, s->numCols * sizeof(int));
+	memcpy(model->keptBasis, s->basis, s->m * sizeof(int));
+	memcpy(model->keptArtSign, s->artSign, s->m * sizeof(double));
+	memcpy(model->keptBinv, s->binv, (size_t) s->m * s->m * sizeof(double));
+}
+
+static int builtinOptimize(LPModel *model, SolveControl *control, int *status){
+	Builtin s;
+	int var;
+	memset(&s, 0, sizeof(Builtin));
+	free(model->x);
+	model->x = NULL;
+	if (!initBuiltin(&s, model)) {
+		printf("ERROR in calloc memory for the builtin LP backend.\n");
+		freeBuiltin(&s);
+		return 1;
+	}
+	s.control = control;
+	if (model->keptStatus != NULL)
+		restoreBasis(&s);
+	branch(&s, -LP_INFINITY);
+	if (s.failed) {
+		freeBuiltin(&s);
+		return 1;
+	}
+	/* the last basis is dual feasible whenever haveBasis is set, only the bounds of the next optimize differ */
+	if (model->resolve && s.haveBasis)
+		keepBasis(&s);
+	if (s.stopped)
+		*status = LP_STOPPED;
+	else if (s.haveBest) {
+		*status = LP_OPTIMAL;
+		for (var = 0; var < model->numVars; var++) {
+			if (model->vtype[var] == LP_BINARY)
+				s.best[var] = floor(s.best[var] + 0.5);
+		}
+		/* the values go to the model, the state is freed */
+		model->x = s.best;
+		s.best = NULL;
+	}
+	else
+		*status = LP_INFEASIBLE;
+	freeBuiltin(&s);
+	return 0;
+}
+
+const LPBackend builtinBackend = {
+	"builtin",
+	builtinLoadEnv,
+	builtinFreeEnv,
+	builtinNewModel,
+	builtinFreeModel,
+	builtinSetSense,
+	builtinAddVars,
+	builtinAddConstr,
+	builtinSetLowerBound,
+	builtinOptimize,
+	builtinGetX
+};
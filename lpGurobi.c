@@ -0,0 +1,180 @@
+#ifndef SUDOKU_NO_GUROBI
+#include <stdio.h>
+#include <stdlib.h>
+#include "gurobi_c.h"
+#include "lpBackend.h"
+
+/* Gurobi LP Backend Module
+ * the LP backend interface on the Gurobi C library. an environment is a Gurobi environment, a model a Gurobi model, and the
+ * control of an optimize becomes the time limit of the model and a callback that terminates it once the control is cancelled.
+ */
+
+struct LPEnv{
+	GRBenv *env;
+};
+
+struct LPModel{
+	GRBenv *env; /* the environment of the model, for the messages */
+	GRBmodel *model;
+};
+
+static LPEnv* gurobiLoadEnv(const char *logFile, int options){
+	LPEnv *env = (LPEnv*) calloc(1, sizeof(LPEnv));
+	int error;
+	if (env == NULL) {
+		printf("ERROR in calloc memory for the gurobi function.\n");
+		return NULL;
+	}
+	error = GRBloadenv(&env->env, logFile);
+	if (error) {
+		printf("ERROR %d GRBloadenv(): %s\n", error, GRBgeterrormsg(env->env));
+		GRBfreeenv(env->env);
+		free(env);
+		return NULL;
+	}
+	/*Cancel log being written to console*/
+	error = GRBsetintparam(env->env, GRB_INT_PAR_LOGTOCONSOLE, 0);
+	/*Only bounds change between solves, which keeps the previous basis dual feasible - use the dual simplex to re-solve from it*/
+	if (!error && (options & LP_OPTION_RESOLVE))
+		error = GRBsetintparam(env->env, GRB_INT_PAR_METHOD, 1);
+	if (error) {
+		printf("ERROR %d GRBsetintparam(): %s\n", error, GRBgeterrormsg(env->env));
+		GRBfreeenv(env->env);
+		free(env);
+		return NULL;
+	}
+	return env;
+}
+
+static void gurobiFreeEnv(LPEnv *env){
+	if (env == NULL)
+		return;
+	GRBfreeenv(env->env);
+	free(env);
+}
+
+static LPModel* gurobiNewModel(LPEnv *env, const char *name){
+	LPModel *model = (LPModel*) calloc(1, sizeof(LPModel));
+	int error;
+	if (model == NULL) {
+		printf("ERROR in calloc memory for the gurobi function.\n");
+		return NULL;
+	}
+	model->env = env->env;
+	error = GRBnewmodel(env->env, &model->model, name, 0, NULL, NULL, NULL, NULL, NULL);
+	if (error) {
+		printf("ERROR %d GRBnewmodel(): %s\n", error, GRBgeterrormsg(env->env));
+		free(model);
+		return NULL;
+	}
+	return model;
+}
+
+static void gurobiFreeModel(LPModel *model){
+	if (model == NULL)
+		return;
+	GRBfreemodel(model->model);
+	free(model);
+}
+
+static int gurobiSetSense(LPModel *model, int sense){
+	int error = GRBsetintattr(model->model, GRB_INT_ATTR_MODELSENSE, sense == LP_MAXIMIZE ? GRB_MAXIMIZE : GRB_MINIMIZE);
+	if (error)
+		printf("ERROR %d GRBsetintattr(): %s\n", error, GRBgeterrormsg(model->env));
+	return error;
+}
+
+static int gurobiAddVars(LPModel *model, int count, const double *obj, const char *vtype){
+	int error = GRBaddvars(model->model, count, 0, NULL, NULL, NULL, (double*) obj, NULL, NULL, (char*) vtype, NULL);
+	if (error) {
+		printf("ERROR %d GRBaddvars(): %s\n", error, GRBgeterrormsg(model->env));
+		return error;
+	}
+	/* Update the model - to integrate new variables */
+	error = GRBupdatemodel(model->model);
+	if (error)
+		printf("ERROR %d GRBupdatemodel(): %s\n", error, GRBgeterrormsg(model->env));
+	return error;
+}
+
+static int gurobiAddConstr(LPModel *model, int count, const int *ind, const double *val, char sense, double rhs){
+	/*constraint name is defaulted because we don't care what it's name is*/
+	int error = GRBaddconstr(model->model, count, (int*) ind, (double*) val, sense, rhs, NULL);
+	if (error)
+		printf("ERROR %d GRBaddconstr(): %s\n", error, GRBgeterrormsg(model->env));
+	return error;
+}
+
+static int gurobiSetLowerBound(LPModel *model, int var, double lb){
+	int error = GRBsetdblattrelement(model->model, GRB_DBL_ATTR_LB, var, lb);
+	if (error)
+		printf("ERROR %d GRBsetdblattrelement(): %s\n", error, GRBgeterrormsg(model->env));
+	return error;
+}
+
+static int __stdcall stopCallback(GRBmodel *model, void *cbdata, int where, void *usrdata) {
+	/*Called by Gurobi periodically while it optimizes - stops it once the control asks to*/
+	(void)cbdata;
+	(void)where;
+	if (shouldStop((SolveControl*) usrdata))
+		GRBterminate(model);
+	return 0;
+}
+
+static int gurobiOptimize(LPModel *model, SolveControl *control, int *status){
+	int error, optimstatus;
+	/* the time budget of the control is the time limit of the model, a model optimized again without one has no limit */
+	error = GRBsetdblparam(GRBgetenv(model->model), GRB_DBL_PAR_TIMELIMIT,
+			control != NULL && control->deadline > 0 ? remainingTime(control) : GRB_INFINITY);
+	if (error) {
+		printf("ERROR %d GRBsetdblparam(): %s\n", error, GRBgeterrormsg(model->env));
+		return error;
+	}
+	error = GRBsetcallbackfunc(model->model, control != NULL ? stopCallback : NULL, control);
+	if (error) {
+		printf("ERROR %d GRBsetcallbackfunc(): %s\n", error, GRBgeterrormsg(model->env));
+		return error;
+	}
+	error = GRBoptimize(model->model);
+	if (error) {
+		printf("ERROR %d GRBoptimize(): %s\n", error, GRBgeterrormsg(model->env));
+		return error;
+	}
+	error = GRBgetintattr(model->model, GRB_INT_ATTR_STATUS, &optimstatus);
+	if (error) {
+		printf("ERROR %d GRBgetintattr(): %s\n", error, GRBgeterrormsg(model->env));
+		return error;
+	}
+	if (optimstatus == GRB_OPTIMAL)
+		*status = LP_OPTIMAL;
+	else if (optimstatus == GRB_INTERRUPTED || optimstatus == GRB_TIME_LIMIT)
+		*status = LP_STOPPED;
+	else/*Infeasible (or unbounded, which can't happen with the models of the project)*/
+		*status = LP_INFEASIBLE;
+	return 0;
+}
+
+static int gurobiGetX(LPModel *model, int first, int count, double *x){
+	int error = GRBgetdblattrarray(model->model, GRB_DBL_ATTR_X, first, count, x);
+	if (error)
+		printf("ERROR %d GRBgetdblattrarray(): %s\n", error, GRBgeterrormsg(model->env));
+	return error;
+}
+
+const LPBackend gurobiBackend = {
+	"gurobi",
+	gurobiLoadEnv,
+	gurobiFreeEnv,
+	gurobiNewModel,
+	gurobiFreeModel,
+	gurobiSetSense,
+	gurobiAddVars,
+	gurobiAddConstr,
+	gurobiSetLowerBound,
+	gurobiOptimize,
+	gurobiGetX
+};
+
+#else
+typedef int lpGurobiLeftOut; /* a translation unit can't be empty */
+#endif /* SUDOKU_NO_GUROBI */
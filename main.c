@@ -2,16 +2,116 @@
 #include <stdlib.h>
 #include <string.h>
 #include "game.h"
+#include "solCache.h"
+#include "server.h"
+#include "selector.h"
+#include "rng.h"
+#include "trace.h"
+#include "metrics.h"
+#include "journal.h"
+#include "lpBackend.h"
+#include "sessions.h"
+#include "geometry.h"
+#include "gridPool.h"
+#include "catalogue.h"
 
 
 
+/* frees the shared tables and closes the files main opened, when a daemon (--serve or --sessions) returns */
+static void closeDaemon(){
+	freeGeometries();
+	freeGridPools();
+	freeCatalogues();
+	closeSolutionCache();
+	closeTimingLog();
+	closeTrace();
+	closeMetricsExport();
+}
+
 /* generates the all game */
 int main(int argc, char *argv[]){
-	/* set the seed for the random function from the main arguments */
+	/* set the seed of the random streams from the main arguments */
 	char* seedInput = argv[argc-1];
 	int seed = atoi(seedInput);
+	long cacheBytes = CACHE_DEFAULT_MAX_BYTES;
+	char *cachePath = NULL;
+	char *socketPath = NULL;
+	char *timingsPath = NULL;
+	char *tracePath = NULL;
+	char *metricsPath = NULL;
+	char *journalPath = NULL;
+	int recover = 0;
+	int hosting = 0;
+	int i, res;
 	setbuf(stdout, NULL);
-	srand(seed);
+	setSessionSeed((uint64_t)seed);
+	/* options come before the seed */
+	for(i = 1; i < argc-1; i++){
+		if(strcmp(argv[i], "--cache-size") == 0 && i+1 < argc-1){
+			cacheBytes = atol(argv[++i])*1024*1024;
+		}
+		else if(strcmp(argv[i], "--cache") == 0 && i+1 < argc-1){
+			cachePath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--serve") == 0 && i+1 < argc-1){
+			socketPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--timings") == 0 && i+1 < argc-1){
+			timingsPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--trace") == 0 && i+1 < argc-1){
+			tracePath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--metrics") == 0 && i+1 < argc-1){
+			metricsPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--journal") == 0 && i+1 < argc-1){
+			journalPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--recover") == 0 && i+1 < argc-1){
+			/* replay the journal of a session that died and go on journaling into it */
+			journalPath = argv[++i];
+			recover = 1;
+		}
+		else if(strcmp(argv[i], "--sessions") == 0){
+			/* host many games, one per session id, instead of the interactive game */
+			hosting = 1;
+		}
+		else if(strcmp(argv[i], "--lp") == 0 && i+1 < argc-1){
+			/* the LP backend of the ILP and the relaxation: gurobi or builtin */
+			if(!setLPBackend(argv[++i]))
+				return 1;
+		}
+	}
+	if(hosting && journalPath != NULL){
+		printf("Error: the journal follows one game, it can't be used with --sessions\n");
+		return 1;
+	}
+	if(socketPath != NULL && journalPath != NULL){
+		printf("Error: the journal follows one game, it can't be used with --serve\n");
+		return 1;
+	}
+	if(cachePath != NULL)
+		openSolutionCache(cachePath, cacheBytes);
+	if(timingsPath != NULL)
+		openTimingLog(timingsPath);
+	if(tracePath != NULL)
+		openTrace(tracePath);
+	if(metricsPath != NULL)
+		openMetricsExport(metricsPath);
+	if(journalPath != NULL)
+		openJournal(journalPath, recover);
+	/* run as a solver daemon instead of the interactive game */
+	if(socketPath != NULL){
+		res = serve(socketPath);
+		closeDaemon();
+		return res;
+	}
+	if(hosting){
+		res = hostSessions();
+		closeDaemon();
+		return res;
+	}
 	/* start the game */
 	initMode();
 
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "metrics.h"
+#include "control.h"
+
+/* Metrics Module
+ * a latency of v microseconds goes to bucket v below 2*METRICS_SUB_BUCKETS, and above it to the bucket of its top
+ * log2(2*METRICS_SUB_BUCKETS) bits: the shift that brings v under 2*METRICS_SUB_BUCKETS selects a group of
+ * METRICS_SUB_BUCKETS buckets and the remaining bits the bucket inside the group. the command loop and the worker both
+ * record, the lock protects the histograms and the export file.
+ * the export writes a temporary file and renames it over the real one, so the scraper never reads half a file.
+ */
+
+#define METRICS_PATH_LEN 512
+
+typedef struct Histogram{
+	const char *name;
+	unsigned long counts[METRICS_BUCKETS];
+	unsigned long total;
+	double sum; /* seconds */
+	unsigned long max; /* microseconds */
+}Histogram;
+
+static Histogram histograms[METRICS_MAX_NAMES];
+static int numHistograms = 0;
+static pthread_mutex_t metricsLock = PTHREAD_MUTEX_INITIALIZER;
+static char exportPath[METRICS_PATH_LEN];
+static int exporting = 0;
+static double lastExport;
+
+/* the bounds of the buckets of the export, in seconds */
+static const double exportBounds[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25,
+		0.5, 1, 2.5, 5, 10, 30, 60, 300};
+#define NUM_EXPORT_BOUNDS ((int)(sizeof(exportBounds)/sizeof(double)))
+
+static int bucketOf(unsigned long micros){
+	int shift = 0;
+	while((micros >> shift) >= 2*METRICS_SUB_BUCKETS)
+		shift++;
+	if(shift > METRICS_MAX_SHIFT)
+		return METRICS_BUCKETS-1;
+	return shift*METRICS_SUB_BUCKETS + (int)(micros >> shift);
+}
+
+/* the largest latency in microseconds that falls in the bucket */
+static unsigned long bucketTop(int bucket){
+	int shift = bucket < 2*METRICS_SUB_BUCKETS ? 0 : bucket/METRICS_SUB_BUCKETS - 1;
+	return ((unsigned long)(bucket - shift*METRICS_SUB_BUCKETS + 1) << shift) - 1;
+}
+
+/* the histogram of name, a new one the first time. NULL if there are too many names. the lock is held */
+static Histogram* histogramOf(const char *name){
+	int i;
+	for(i = 0; i < numHistograms; i++){
+		if(histograms[i].name == name || strcmp(histograms[i].name, name) == 0)
+			return &histograms[i];
+	}
+	if(numHistograms == METRICS_MAX_NAMES)
+		return NULL;
+	histograms[numHistograms].name = name;
+	return &histograms[numHistograms++];
+}
+
+/* the smallest latency in microseconds that at least fraction of the latencies of the histogram don't exceed */
+static unsigned long percentile(Histogram *histogram, double fraction){
+	unsigned long rank = (unsigned long)(fraction*histogram->total + 0.5), seen = 0, top;
+	int bucket;
+	if(rank < 1)
+		rank = 1;
+	for(bucket = 0; bucket < METRICS_BUCKETS; bucket++){
+		seen += histogram->counts[bucket];
+		if(seen >= rank){
+			/* the last bucket also holds every longer latency */
+			top = bucket < METRICS_BUCKETS-1 ? bucketTop(bucket) : histogram->max;
+			return top < histogram->max ? top : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/* write the histograms to the export file, the lock is held */
+static void exportMetrics(){
+	char tempPath[METRICS_PATH_LEN + 8];
+	FILE *file;
+	Histogram *histogram;
+	unsigned long below;
+	int i, bound, bucket;
+	sprintf(tempPath, "%s.tmp", exportPath);
+	file = fopen(tempPath, "w");
+	if(file == NULL){
+		printf("Error: can't write the metrics file %s\n", tempPath);
+		return;
+	}
+	fprintf(file, "# HELP sudoku_command_seconds Latency of the commands of the game.\n");
+	fprintf(file, "# TYPE sudoku_command_seconds histogram\n");
+	for(i = 0; i < numHistograms; i++){
+		histogram = &histograms[i];
+		below = 0;
+		bucket = 0;
+		for(bound = 0; bound < NUM_EXPORT_BOUNDS; bound++){
+			/* the buckets that end below the bound, a bucket that straddles it is counted above it */
+			while(bucket < METRICS_BUCKETS && bucketTop(bucket) < (unsigned long)(exportBounds[bound]*1e6))
+				below += histogram->counts[bucket++];
+			fprintf(file, "sudoku_command_seconds_bucket{command=\"%s\",le=\"%g\"} %lu\n", histogram->name, exportBounds[bound], below);
+		}
+		fprintf(file, "sudoku_command_seconds_bucket{command=\"%s\",le=\"+Inf\"} %lu\n", histogram->name, histogram->total);
+		fprintf(file, "sudoku_command_seconds_sum{command=\"%s\"} %f\n", histogram->name, histogram->sum);
+		fprintf(file, "sudoku_command_seconds_count{command=\"%s\"} %lu\n", histogram->name, histogram->total);
+	}
+	fclose(file);
+	if(rename(tempPath, exportPath) != 0)
+		printf("Error: can't write the metrics file %s\n", exportPath);
+	lastExport = monotonicSeconds();
+}
+
+void recordLatency(const char *name, double seconds){
+	Histogram *histogram;
+	unsigned long micros = seconds > 0 ? (unsigned long)(seconds*1e6) : 0;
+	pthread_mutex_lock(&metricsLock);
+	histogram = histogramOf(name);
+	if(histogram != NULL){
+		histogram->counts[bucketOf(micros)]++;
+		histogram->total++;
+		histogram->sum += seconds;
+		if(micros > histogram->max)
+			histogram->max = micros;
+	}
+	if(exporting && monotonicSeconds() - lastExport >= METRICS_EXPORT_SECONDS)
+		exportMetrics();
+	pthread_mutex_unlock(&metricsLock);
+}
+
+void printMetrics(){
+	Histogram *histogram;
+	int i;
+	pthread_mutex_lock(&metricsLock);
+	if(numHistograms == 0)
+		printf("No command was timed yet\n");
+	else
+		printf("%-20s %8s %10s %10s %10s %10s\n", "command", "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+	for(i = 0; i < numHistograms; i++){
+		histogram = &histograms[i];
+		printf("%-20s %8lu %10.3f %10.3f %10.3f %10.3f\n", histogram->name, histogram->total,
+				percentile(histogram, 0.5)/1e3, percentile(histogram, 0.9)/1e3, percentile(histogram, 0.99)/1e3, histogram->max/1e3);
+	}
+	pthread_mutex_unlock(&metricsLock);
+}
+
+int openMetricsExport(const char *path){
+	if(strlen(path) >= METRICS_PATH_LEN){
+		printf("Error: the metrics file path is too long\n");
+		return 0;
+	}
+	pthread_mutex_lock(&metricsLock);
+	strcpy(exportPath, path);
+	exporting = 1;
+	exportMetrics();
+	pthread_mutex_unlock(&metricsLock);
+	return 1;
+}
+
+void closeMetricsExport(){
+	pthread_mutex_lock(&metricsLock);
+	if(exporting)
+		exportMetrics();
+	exporting = 0;
+	pthread_mutex_unlock(&metricsLock);
+}
@@ -0,0 +1,30 @@
+/* Header file of the metrics module. Keeps a latency histogram for every command of the game: gameControl times the
+ * commands it runs itself and the worker times the background ones from their start to their end.
+ * The histograms have fixed log-linear buckets in the style of HdrHistogram - METRICS_SUB_BUCKETS buckets for every
+ * power of two of microseconds - so a percentile is within about 3% of the true latency, and recording a latency is an
+ * index computation and an increment.
+ * When an export file is open the histograms are written to it in the Prometheus text format every
+ * METRICS_EXPORT_SECONDS (checked when a latency is recorded) and when it is closed, for the node exporter to scrape.*/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#define METRICS_SUB_BUCKETS 32 /* buckets per power of two of microseconds, a power of 2 */
+#define METRICS_MAX_SHIFT 36 /* latencies up to 2^(36+6) microseconds, longer ones go to the last bucket */
+#define METRICS_BUCKETS ((METRICS_MAX_SHIFT+2)*METRICS_SUB_BUCKETS)
+#define METRICS_MAX_NAMES 32 /* different names that get a histogram */
+#define METRICS_EXPORT_SECONDS 15
+
+/* add a latency of the command name (a string that lives as long as the process) to its histogram */
+void recordLatency(const char *name, double seconds);
+
+/* print the count, p50, p90, p99 and max latency of every command that ran */
+void printMetrics();
+
+/* write the histograms to the file at path from now on. returns 1 on success and 0 if it can't be written */
+int openMetricsExport(const char *path);
+
+/* write the histograms a last time and stop exporting */
+void closeMetricsExport();
+
+#endif /* METRICS_H_ */
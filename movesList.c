@@ -1,82 +1,115 @@
-<<<<<<< HEAD
-<<<<<<< HEAD
-=======
-<<<<<<< HEAD
-=======
->>>>>>> refs/heads/shachar
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <math.h>
-#include "MainAux.h"
-#include "parser.h"
-#include "solver.h"
 #include "game.h"
+#include "movesList.h"
+#include "journal.h"
+#include "pool.h"
 
+/* Moves List Module
+ * the history is a doubly linked list of moves from game->firstMove. game->currentMove is the last applied move, NULL
+ * when none is, and the moves after it are the undone ones that redo applies again. undo and redo write the values of
+ * the moves to the board themselves, going through set would record them as new moves.
+ */
 
+#define ErrorUndo "Error: no moves to undo\n"
+#define ErrorRedo "Error: no moves to redo\n"
+
+/* put value in cell (row,col), from 1, keeping the number of filled cells */
+static void applyValue(Game *game, int row, int col, int value){
+	Cell *cell = &game->board[row-1][col-1];
+	if(cell->value == 0 && value != 0)
+		game->numOfFilledCells++;
+	else if(cell->value != 0 && value == 0)
+		game->numOfFilledCells--;
+	cell->value = value;
+}
 
 /* creating new move and add it to the moves list*/
 void setMove(Game* game, int row, int col, int value, int prevValue){
-	Move move = (Move *)calloc(1, sizeof(Move));
-	move.row = row;
-	move.col = col;
-	move.value = value;
-	move.prevValue = prevValue;
-	move.lastMove = game.currentMove;
-	move.nextMove = NULL;
-	game.currentMove = move;
+	Move *move = allocMove(game->pools);
+	if(move == NULL){
+		printf("Error: calloc has failed\n");
+		return;
+	}
+	move->row = row;
+	move->col = col;
+	move->value = value;
+	move->prevValue = prevValue;
+	move->lastMove = game->currentMove;
+	move->nextMove = NULL;
+	if(game->currentMove != NULL)
+		game->currentMove->nextMove = move;
+	else
+		game->firstMove = move;
+	game->currentMove = move;
+	journalRecord(JOURNAL_MOVE, row, col, value, prevValue);
 }
 
-void clearNextMoves(Game game){
-	Move nextMove = game.currentMove.nextMove;
-	Move moveToClear = game.currentMove.nextMove;
-	while(nextMove != NULL){
-		nextMove = moveToClear.nextMove;
-		free(moveToClear);
+void clearNextMoves(Game* game){
+	Move *moveToClear = game->currentMove != NULL ? game->currentMove->nextMove : game->firstMove;
+	Move *nextMove;
+	while(moveToClear != NULL){
+		nextMove = moveToClear->nextMove;
+		releaseMove(game->pools, moveToClear);
 		moveToClear = nextMove;
 	}
+	if(game->currentMove != NULL)
+		game->currentMove->nextMove = NULL;
+	else
+		game->firstMove = NULL;
 }
-void clearPrevMoves(Game game){
-	Move moveToClear = game.currentMove.prev;
-	Move prevMove = game.currentMove.prev;
+
+void clearPrevMoves(Game* game){
+	Move *moveToClear = game->currentMove;
+	Move *prevMove;
+	if(moveToClear == NULL)
+		return;
+	/* the undone moves, if any, are the whole history now */
+	game->firstMove = moveToClear->nextMove;
+	if(game->firstMove != NULL)
+		game->firstMove->lastMove = NULL;
 	while(moveToClear != NULL){
-		prevMove = moveToClear.prevMove;
-		free(moveToClear);
-		moveToClear = nextMove;
+		prevMove = moveToClear->lastMove;
+		releaseMove(game->pools, moveToClear);
+		moveToClear = prevMove;
 	}
-	free(game.currentMove);
+	game->currentMove = NULL;
 }
 
-void undo(Game game, int printSign){
+void undo(Game* game, int printSign){
+	Move *move;
 	/* if there was no move done yet */
-	if(game.currentMove == NULL){
+	if(game->currentMove == NULL){
 		printf(ErrorUndo);
+		return;
 	}
-	else{
-		int row = game.currentMove.row;
-		int col = game.currentMove.col;
-		int value = game.currentMove.prevValue;
-		set(game, row, col, prevValue, printSign);
-		game.currentMove = game.currentMove.lastMove;
-	}
+	journalEnter(JOURNAL_UNDO);
+	/* a batch of chained moves is undone as one move */
+	do{
+		move = game->currentMove;
+		applyValue(game, move->row, move->col, move->prevValue);
+		game->currentMove = move->lastMove;
+	}while(move->chained && game->currentMove != NULL);
+	journalLeave();
+	if(printSign == 1)
+		printBoard(game);
 }
 
-void redo(Game game, int printSign){
-	if(game.currentMove.nextMove == NULL){
+void redo(Game* game, int printSign){
+	Move *move = game->currentMove != NULL ? game->currentMove->nextMove : game->firstMove;
+	if(move == NULL){
 		printf(ErrorRedo);
+		return;
 	}
-	else{
-		int row = game.currentMove.nextMove.row;
-		int col = game.currentMove.nextMove.col;
-		int value = game.currentMove.nextMove.value;
-		set(game, row, col, prevValue, printSign);
-		game.currentMove = game.currentMove.nextMove;
-	}
+	journalEnter(JOURNAL_REDO);
+	/* a batch of chained moves is redone as one move */
+	do{
+		applyValue(game, move->row, move->col, move->value);
+		game->currentMove = move;
+		move = move->nextMove;
+	}while(move != NULL && move->chained);
+	journalLeave();
+	if(printSign == 1)
+		printBoard(game);
 }
-
-<<<<<<< HEAD
-=======
-=======
->>>>>>> refs/remotes/origin/master
->>>>>>> refs/heads/shachar
-
@@ -1,15 +1,25 @@
+/* Header file of the moves list module. The undo/redo history of the game: every change the user makes to a cell is a
+ * move, and undo and redo walk the list of moves back and forth. A batch of moves made by one command (autofill) is
+ * chained, undo and redo take the whole batch. */
+
 #ifndef MOVELIST_H_
 #define MOVELIST_H_
+#include "game.h"
 
-
+/* add the move of cell (row,col), from 1, from prevValue to value after the current move and make it the current move.
+ * the moves after the current move must have been cleared */
 void setMove(Game* game, int row, int col, int value, int prevValue);
 
-void clearNextMoves(Game game);
+/* free the moves after the current move, the ones that were undone */
+void clearNextMoves(Game* game);
 
-void clearPrevMoves(Game game);
+/* free the current move and the moves before it, the ones that were applied */
+void clearPrevMoves(Game* game);
 
-void undo(Game game, int printSign);
+/* take the current move (or batch) back, and print the board if printSign is 1 */
+void undo(Game* game, int printSign);
 
-void redo(Game game, int printSign);
+/* apply the move (or batch) after the current move again, and print the board if printSign is 1 */
+void redo(Game* game, int printSign);
 
 #endif
@@ -2,6 +2,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include "MainAux.h"
+#include "engine.h"
+#include "search.h"
 
 
 
@@ -11,7 +13,7 @@
 
 
 /* parse the input string of the player during the game into commands on the board */
-void parseUserInput(int *command, char* path, char input[]){
+void parseUserInput(int *command, char* path, double *threshold, char input[]){
 	/* define the separators of the user inputs */
 	   const char s[5] = " \t\r\n";
 	   char* token;
@@ -91,7 +93,8 @@ void parseUserInput(int *command, char* path, char input[]){
 		   while(i < 1) {
 			   token = strtok(NULL, s);
 			   if(token != NULL){
-				   command[i+1] = atoi(token);
+				   /* the threshold is a fraction, so it doesn't fit in the command array */
+				   *threshold = atof(token);
 			   }
 			   else{
 				   command[0] = 19;
@@ -166,6 +169,15 @@ void parseUserInput(int *command, char* path, char input[]){
 	   }
 	   else if(strcmp(token, "autofill") == 0){
 		   command[0] = 15;
+		   /* "autofill all" fills forced cells until nothing changes */
+		   command[1] = 0;
+		   token = strtok(NULL, s);
+		   if(token != NULL && strcmp(token, "all") == 0){
+			   command[1] = 1;
+		   }
+		   else if(token != NULL){
+			   command[0] = 19;
+		   }
 	   }
 	   else if(strcmp(token, "restart") == 0){
 		   command[0] = 16;
@@ -173,6 +185,73 @@ void parseUserInput(int *command, char* path, char input[]){
 	   else if(strcmp(token, "exit") == 0){
 		   command[0] = 17;
 	   }
+	   else if(strcmp(token, "estimate_solutions") == 0){
+		   command[0] = 23;
+		   /* the number of samples is optional, 0 means the default */
+		   command[1] = 0;
+		   token = strtok(NULL, s);
+		   if(token != NULL){
+			   command[1] = atoi(token);
+		   }
+	   }
+	   else if(strcmp(token, "engine") == 0){
+		   command[0] = 24;
+		   /* without a name the current engine is printed */
+		   command[1] = -1;
+		   token = strtok(NULL, s);
+		   if(token != NULL){
+			   command[1] = parseEngineName(token);
+			   if(command[1] < 0)
+				   command[0] = 19;
+		   }
+	   }
+	   else if(strcmp(token, "search") == 0){
+		   command[0] = 26;
+		   /* without options the current ones are printed, the options not named keep their default */
+		   command[1] = -1;
+		   token = strtok(NULL, s);
+		   while(token != NULL && command[0] == 26){
+			   if(command[1] < 0)
+				   command[1] = 0;
+			   if(strcmp(token, "rows") == 0)
+				   command[1] |= SEARCH_ROW_ORDER;
+			   else if(strcmp(token, "lcv") == 0)
+				   command[1] |= SEARCH_LCV;
+			   else if(strcmp(token, "geometric") == 0)
+				   command[1] |= SEARCH_GEOMETRIC;
+			   else if(strcmp(token, "nolearn") == 0)
+				   command[1] |= SEARCH_NO_LEARN;
+			   else if(strcmp(token, "mrv") != 0 && strcmp(token, "ascending") != 0 && strcmp(token, "luby") != 0 && strcmp(token, "learn") != 0)
+				   command[0] = 19;
+			   token = strtok(NULL, s);
+		   }
+	   }
+	   else if(strcmp(token, "explain") == 0){
+		   command[0] = 25;
+	   }
+	   else if(strcmp(token, "metrics") == 0){
+		   command[0] = 27;
+	   }
+	   else if(strcmp(token, "cancel") == 0){
+		   command[0] = 20;
+	   }
+	   else if(strcmp(token, "status") == 0){
+		   command[0] = 21;
+	   }
+	   else if(strcmp(token, "timeout") == 0){
+		   command[0] = 22;
+		   /* walk through other tokens */
+		   while(i < 1) {
+			   token = strtok(NULL, s);
+			   if(token != NULL){
+				   command[i+1] = atoi(token);
+			   }
+			   else{
+				   command[0] = 19;
+		          }
+		      i++;
+		   }
+	   }
 	   else{
 		   command[0] = 19;
 
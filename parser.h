@@ -2,6 +2,6 @@
 #define PARSER_H_
 
 /* parse the input string of the player during the game into commands on the board */
-void parseUserInput(int *command, char input[]);
+void parseUserInput(int *command, char *path, double *threshold, char input[]);
 
 #endif
@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+/* Pool Module
+ * fixed-size object pools. a slab is one malloc of POOL_SLAB_OBJECTS objects, threaded onto the free list when it is
+ * made. an object on the free list keeps the pointer to the next free object in its first bytes, so objects are at
+ * least a pointer long and rounded up to the alignment of a pointer.
+ */
+
+void initPool(Pool *pool, size_t objectSize){
+	memset(pool, 0, sizeof(Pool));
+	if(objectSize < sizeof(void*))
+		objectSize = sizeof(void*);
+	pool->objectSize = (objectSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+}
+
+/* add a slab to the pool and its objects to the free list, returns 0 on a memory error */
+static int addSlab(Pool *pool){
+	char *slab, **slabs;
+	int i;
+	if(pool->numSlabs == pool->slabCap){
+		slabs = (char**)realloc(pool->slabs, (pool->slabCap > 0 ? 2*pool->slabCap : 8)*sizeof(char*));
+		if(slabs == NULL)
+			return 0;
+		pool->slabs = slabs;
+		pool->slabCap = pool->slabCap > 0 ? 2*pool->slabCap : 8;
+	}
+	slab = (char*)malloc(POOL_SLAB_OBJECTS*pool->objectSize);
+	if(slab == NULL)
+		return 0;
+	pool->slabs[pool->numSlabs++] = slab;
+	for(i = POOL_SLAB_OBJECTS-1; i >= 0; i--){
+		*(void**)(slab + i*pool->objectSize) = pool->freeList;
+		pool->freeList = slab + i*pool->objectSize;
+	}
+	return 1;
+}
+
+void* poolAlloc(Pool *pool){
+	void *object;
+	if(pool->freeList == NULL && !addSlab(pool))
+		return NULL;
+	object = pool->freeList;
+	pool->freeList = *(void**)object;
+	memset(object, 0, pool->objectSize);
+	pool->inUse++;
+	return object;
+}
+
+void poolFree(Pool *pool, void *object){
+	if(object == NULL)
+		return;
+	*(void**)object = pool->freeList;
+	pool->freeList = object;
+	pool->inUse--;
+}
+
+void destroyPool(Pool *pool){
+	int i;
+	for(i = 0; i < pool->numSlabs; i++)
+		free(pool->slabs[i]);
+	free(pool->slabs);
+	initPool(pool, pool->objectSize);
+}
+
+size_t poolBytes(const Pool *pool){
+	return (size_t)pool->numSlabs*POOL_SLAB_OBJECTS*pool->objectSize;
+}
+
+void initGamePools(GamePools *pools){
+	memset(pools, 0, sizeof(GamePools));
+	initPool(&pools->moves, sizeof(Move));
+}
+
+void destroyGamePools(GamePools *pools){
+	int i;
+	destroyPool(&pools->moves);
+	for(i = 0; i < pools->numBoardPools; i++)
+		destroyPool(&pools->boards[i]);
+	pools->numBoardPools = 0;
+}
+
+/* the bytes of a board block: the row pointers, then the rows */
+static size_t boardBytes(int n, int m){
+	return (size_t)n*m*sizeof(Cell*) + (size_t)n*m*n*m*sizeof(Cell);
+}
+
+/* the board pool of the geometry, made on its first use. NULL if all the board pools are taken by other geometries */
+static Pool* boardPool(GamePools *pools, int n, int m){
+	int i;
+	for(i = 0; i < pools->numBoardPools; i++){
+		if(pools->boardN[i] == n && pools->boardM[i] == m)
+			return &pools->boards[i];
+	}
+	if(pools->numBoardPools == POOL_MAX_GEOMETRIES)
+		return NULL;
+	pools->boardN[i] = n;
+	pools->boardM[i] = m;
+	initPool(&pools->boards[i], boardBytes(n, m));
+	pools->numBoardPools++;
+	return &pools->boards[i];
+}
+
+Cell** allocBoard(GamePools *pools, int n, int m){
+	Pool *pool = pools != NULL ? boardPool(pools, n, m) : NULL;
+	Cell **board;
+	Cell *cells;
+	int row, N = n*m;
+	board = pool != NULL ? (Cell**)poolAlloc(pool) : (Cell**)calloc(1, boardBytes(n, m));
+	if(board == NULL)
+		return NULL;
+	cells = (Cell*)(board + N);
+	for(row = 0; row < N; row++)
+		board[row] = cells + row*N;
+	return board;
+}
+
+void releaseBoard(GamePools *pools, Cell **board, int n, int m){
+	Pool *pool = pools != NULL ? boardPool(pools, n, m) : NULL;
+	if(pool != NULL)
+		poolFree(pool, board);
+	else
+		free(board);
+}
+
+Move* allocMove(GamePools *pools){
+	return pools != NULL ? (Move*)poolAlloc(&pools->moves) : (Move*)calloc(1, sizeof(Move));
+}
+
+void releaseMove(GamePools *pools, Move *move){
+	if(pools != NULL)
+		poolFree(&pools->moves, move);
+	else
+		free(move);
+}
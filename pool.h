@@ -0,0 +1,65 @@
+/* Header file of the pool module. Fixed-size object pools for the games of the session host (see sessions.h), so
+ * thousands of games don't each pay a malloc per board row and per move of the history.
+ * A pool hands out objects of one size from slabs of POOL_SLAB_OBJECTS objects and keeps the freed ones on a free list
+ * for the next allocation. Slabs are only returned to the system when the pool is destroyed.
+ * GamePools groups the pools of a host: one for the moves of the undo/redo histories and one per geometry for the
+ * boards. A board is one block, the row pointers followed by the cells, so a board of any geometry is one object.
+ * A game whose pools are NULL (the interactive game, the warm games of the server) allocates from the heap.
+ * Pools aren't thread safe, they belong to the thread of the host (background jobs don't allocate boards or moves).*/
+
+#ifndef POOL_H_
+#define POOL_H_
+#include <stddef.h>
+#include "game.h"
+
+#define POOL_SLAB_OBJECTS 64
+#define POOL_MAX_GEOMETRIES 8 /* geometries with a board pool, boards of other geometries come from the heap */
+
+typedef struct Pool{
+	size_t objectSize;
+	void *freeList; /* the free objects, every one holds a pointer to the next */
+	char **slabs;
+	int numSlabs;
+	int slabCap;
+	long inUse;
+}Pool;
+
+typedef struct GamePools{
+	Pool moves;
+	Pool boards[POOL_MAX_GEOMETRIES];
+	int boardN[POOL_MAX_GEOMETRIES];
+	int boardM[POOL_MAX_GEOMETRIES];
+	int numBoardPools;
+}GamePools;
+
+/* initialize an empty pool of objects of objectSize bytes */
+void initPool(Pool *pool, size_t objectSize);
+
+/* a zeroed object, NULL on a memory error */
+void* poolAlloc(Pool *pool);
+
+/* give an object of the pool back to it */
+void poolFree(Pool *pool, void *object);
+
+/* free the slabs of the pool, the objects still in use go with them */
+void destroyPool(Pool *pool);
+
+/* the bytes the pool took from the system */
+size_t poolBytes(const Pool *pool);
+
+void initGamePools(GamePools *pools);
+
+void destroyGamePools(GamePools *pools);
+
+/* a zeroed board of the geometry, from the pools or from the heap if pools is NULL. NULL on a memory error */
+Cell** allocBoard(GamePools *pools, int n, int m);
+
+/* give back a board made by allocBoard with the same pools and geometry */
+void releaseBoard(GamePools *pools, Cell **board, int n, int m);
+
+/* a zeroed move, from the pools or from the heap if pools is NULL. NULL on a memory error */
+Move* allocMove(GamePools *pools);
+
+void releaseMove(GamePools *pools, Move *move);
+
+#endif /* POOL_H_ */
@@ -0,0 +1,183 @@
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "portfolio.h"
+#include "solver.h"
+#include "sat.h"
+#include "geometry.h"
+
+/* Portfolio Module
+ * every solver of the race reads the board of the game, which doesn't change while the race runs, and writes its own
+ * solution buffer. the calling thread waits for the race and watches the outer control, and cancels the losers through their
+ * controls once a winner is known. the race ends only when all the threads have been joined, so nothing outlives it.
+ */
+
+#define POLL_NANOSECONDS 2000000L
+
+static const char *solverNames[PORTFOLIO_SOLVERS] = {"backtrack", "ilp", "sat"};
+
+/* the wins of every solver by geometry and fill ratio, kept for the whole session */
+static long wins[GEOMETRY_MAX_N+1][GEOMETRY_MAX_N+1][PORTFOLIO_FILL_BUCKETS][PORTFOLIO_SOLVERS];
+static pthread_mutex_t winsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* shared by the threads of one race */
+typedef struct Race{
+	Game *game;
+	pthread_mutex_t lock; /* protects winner, result and finished */
+	pthread_cond_t changed; /* signalled when a solver returns */
+	int winner; /* the solver that answered first, -1 until one did */
+	int result;
+	int finished; /* the number of solvers that returned */
+}Race;
+
+typedef struct Runner{
+	pthread_t thread;
+	Race *race;
+	int solver;
+	SolveControl control;
+	int *solution;
+	int result;
+}Runner;
+
+static void* runSolver(void *arg){
+	Runner *runner = (Runner*)arg;
+	Race *race = runner->race;
+	switch(runner->solver){
+	case PORTFOLIO_BACKTRACK:
+		runner->result = backtrackSolve(race->game, &runner->control, runner->solution);
+		break;
+	case PORTFOLIO_ILP:
+		runner->result = ilpSolveBoard(race->game, &runner->control, runner->solution);
+		break;
+	default:
+		runner->result = satSolveBoard(race->game, &runner->control, runner->solution);
+		break;
+	}
+	pthread_mutex_lock(&race->lock);
+	/* only a definite answer wins, a solver that was stopped or failed leaves the race to the others */
+	if(race->winner < 0 && (runner->result == 0 || runner->result == 1)){
+		race->winner = runner->solver;
+		race->result = runner->result;
+	}
+	race->finished++;
+	pthread_cond_signal(&race->changed);
+	pthread_mutex_unlock(&race->lock);
+	return NULL;
+}
+
+/* shouldStop reads the clock only once in many calls, and the race looks at its control only once per wakeup */
+static int raceShouldStop(SolveControl *control){
+	return shouldStop(control) || deadlinePassed(control);
+}
+
+static int fillBucket(Game *game){
+	int N = game->n*game->m, row, col, filled = 0, bucket;
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			if(game->board[row][col].value != 0)
+				filled++;
+		}
+	}
+	bucket = filled*PORTFOLIO_FILL_BUCKETS/(N*N);
+	return bucket < PORTFOLIO_FILL_BUCKETS ? bucket : PORTFOLIO_FILL_BUCKETS-1;
+}
+
+int portfolioSolve(Game *game, SolveControl *control, int *solution, int *winner){
+	Race race;
+	Runner runners[PORTFOLIO_SOLVERS];
+	struct timespec wake;
+	int started, i, stopped = 0, N = game->n*game->m;
+	race.game = game;
+	race.winner = -1;
+	race.result = -1;
+	race.finished = 0;
+	pthread_mutex_init(&race.lock, NULL);
+	pthread_cond_init(&race.changed, NULL);
+	for(started = 0; started < PORTFOLIO_SOLVERS; started++){
+		runners[started].race = &race;
+		runners[started].solver = started;
+		/* every solver gets the time budget of the race, and is cancelled on its own */
+		initControl(&runners[started].control, 0);
+		if(control != NULL)
+			runners[started].control.deadline = control->deadline;
+		runners[started].solution = (int*)calloc(N*N, sizeof(int));
+		if(runners[started].solution == NULL)
+			break;
+		if(pthread_create(&runners[started].thread, NULL, runSolver, &runners[started]) != 0){
+			free(runners[started].solution);
+			break;
+		}
+	}
+	if(started == 0)
+		printf("Error: could not start the solvers\n");
+	/* wait for a winner. the wait wakes up every POLL_NANOSECONDS to look at the outer control, which has nothing to signal */
+	pthread_mutex_lock(&race.lock);
+	while(race.winner < 0 && race.finished < started){
+		clock_gettime(CLOCK_REALTIME, &wake);
+		wake.tv_nsec += POLL_NANOSECONDS;
+		if(wake.tv_nsec >= 1000000000L){
+			wake.tv_sec++;
+			wake.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait(&race.changed, &race.lock, &wake);
+		if(race.winner < 0 && raceShouldStop(control)){
+			stopped = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&race.lock);
+	for(i = 0; i < started; i++)
+		runners[i].control.cancelled = 1;
+	for(i = 0; i < started; i++)
+		pthread_join(runners[i].thread, NULL);
+	if(race.winner >= 0){
+		if(race.result == 1 && solution != NULL){
+			for(i = 0; i < N*N; i++)
+				solution[i] = runners[race.winner].solution[i];
+		}
+		if(N <= GEOMETRY_MAX_N){
+			pthread_mutex_lock(&winsLock);
+			wins[game->n][game->m][fillBucket(game)][race.winner]++;
+			pthread_mutex_unlock(&winsLock);
+		}
+	}
+	else if(!stopped){
+		/* every solver gave up. if any of them was stopped by the time budget the race was stopped, otherwise they all failed */
+		for(i = 0; i < started; i++){
+			if(runners[i].result == 2){
+				if(control != NULL)
+					control->stopReason = STOP_TIMEOUT;
+				race.result = 2;
+			}
+		}
+	}
+	for(i = 0; i < started; i++)
+		free(runners[i].solution);
+	if(winner != NULL)
+		*winner = race.winner;
+	pthread_cond_destroy(&race.changed);
+	pthread_mutex_destroy(&race.lock);
+	/* an answer that came in while the race was being stopped is still an answer */
+	return (stopped && race.winner < 0) ? 2 : race.result;
+}
+
+void printPortfolioWins(int n, int m){
+	int bucket, solver, any = 0;
+	if(n*m > GEOMETRY_MAX_N)
+		return;
+	pthread_mutex_lock(&winsLock);
+	for(bucket = 0; bucket < PORTFOLIO_FILL_BUCKETS; bucket++){
+		for(solver = 0; solver < PORTFOLIO_SOLVERS; solver++){
+			if(wins[n][m][bucket][solver] == 0)
+				continue;
+			if(!any)
+				printf("Portfolio wins on %dx%d boards by fill ratio:\n", n, m);
+			any = 1;
+			printf("  %3d%%-%3d%% %-10s %ld\n", bucket*100/PORTFOLIO_FILL_BUCKETS, (bucket+1)*100/PORTFOLIO_FILL_BUCKETS,
+					solverNames[solver], wins[n][m][bucket][solver]);
+		}
+	}
+	pthread_mutex_unlock(&winsLock);
+}
@@ -0,0 +1,30 @@
+/* Header file of the portfolio module. Races the solvers on the same board: the back-tracking of the solver module,
+ * the Gurobi ILP and the SAT solver each run on their own thread with their own SolveControl. The first one to find
+ * out whether the board is solvable wins, and the others are cancelled. No single solver wins on every board - the
+ * back-tracking finishes easy 9x9 boards before the ILP has built its model, the SAT solver wins on large boards -
+ * so the race bounds the time of a board by the best solver for it.
+ * The winners are recorded by the geometry and the fill ratio of the board, for the engine command to show.*/
+
+#ifndef PORTFOLIO_H_
+#define PORTFOLIO_H_
+#include "game.h"
+#include "control.h"
+
+#define PORTFOLIO_BACKTRACK 0
+#define PORTFOLIO_ILP 1
+#define PORTFOLIO_SAT 2
+#define PORTFOLIO_SOLVERS 3
+
+/* the fill ratio of a board is recorded in buckets of 10% */
+#define PORTFOLIO_FILL_BUCKETS 10
+
+/* races the solvers on the board and puts the solution of the winner in solution (N*N, row by row) if it isn't NULL.
+ * the winner (PORTFOLIO_BACKTRACK, PORTFOLIO_ILP or PORTFOLIO_SAT, -1 if none) is put in *winner if it isn't NULL.
+ * the control (may be NULL) stops the whole race. returns 1 if solved, 0 if the board has no solution,
+ * 2 if the control stopped the race and -1 if every solver failed */
+int portfolioSolve(Game *game, SolveControl *control, int *solution, int *winner);
+
+/* prints how many races every solver won on boards of the geometry n x m, by fill ratio */
+void printPortfolioWins(int n, int m);
+
+#endif /* PORTFOLIO_H_ */
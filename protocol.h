@@ -0,0 +1,49 @@
+/* Header file of the wire protocol of the solver daemon (see server.h). It is shared by the daemon and the client tool.
+ * Every message on the socket is a frame: a 32 bit length (host byte order, the socket is local) followed by that many bytes.
+ * A request frame is a RequestHeader followed by the board, N*N bytes row by row (0 for an empty cell).
+ * A response frame is a ResponseHeader, followed by the board in the same layout when hasGrid is 1.
+ * Responses carry the id of their request. A connection may send many requests without waiting, and responses of
+ * requests of different geometries may come back in a different order than the requests were sent.*/
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+#include <stdint.h>
+
+#define PROTOCOL_MAX_N 64 /* largest board side (n*m) the daemon accepts */
+#define PROTOCOL_MAX_FRAME (20 + PROTOCOL_MAX_N*PROTOCOL_MAX_N) /* largest legal frame, longer frames close the connection */
+
+/* request operations */
+#define OP_SOLVE 1 /* response: the solved board */
+#define OP_VALIDATE 2 /* response: value 1 if the board is solvable */
+#define OP_HINT 3 /* args: row, col. response: value is the value of the cell in a solution */
+#define OP_COUNT 4 /* response: value is the number of solutions (a lower bound if the status is STATUS_STOPPED) */
+#define OP_GENERATE 5 /* args: x, y as in the generate command. response: the generated board */
+
+/* response statuses */
+#define STATUS_OK 0
+#define STATUS_UNSOLVABLE 1 /* the board has no solution */
+#define STATUS_ERRONEOUS 2 /* the board breaks the sudoku rules */
+#define STATUS_BAD_REQUEST 3 /* unknown op, illegal geometry, values or arguments */
+#define STATUS_ERROR 4 /* the solver failed (memory or gurobi error) */
+#define STATUS_STOPPED 5 /* the time budget ran out or the daemon is shutting down */
+
+typedef struct RequestHeader{
+	uint32_t id; /* chosen by the client, copied to the response */
+	uint8_t op; /* one of the OP_ values */
+	uint8_t n; /* rows in a block */
+	uint8_t m; /* columns in a block */
+	uint8_t reserved; /* must be 0 */
+	int32_t args[2]; /* arguments of the op, 0 if it has none */
+	uint32_t timeoutMs; /* time budget of the request, 0 for the daemon default */
+}RequestHeader;
+
+typedef struct ResponseHeader{
+	uint32_t id;
+	uint8_t status; /* one of the STATUS_ values */
+	uint8_t n;
+	uint8_t m;
+	uint8_t hasGrid; /* 1 if a board follows the header */
+	int64_t value; /* the result of ops that return a number */
+}ResponseHeader;
+
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "results.h"
+#include "solCache.h"
+#include "catalogue.h"
+
+/* Results Module
+ * an open addressing hash table keyed by the canonical hash. every entry keeps its canonical grid
+ * to tell real hits from hash collisions. solutions are stored in the canonical orientation.
+ * the table is shared by all the threads, so every access takes its lock. when it fills up it is simply cleared.
+ * when the persistent solution cache is open, the table is its in-memory front: misses are looked up on disk,
+ * and every new result is appended to disk (outside the lock, appends are synced).
+ */
+
+typedef struct ResultEntry{
+	uint64_t hash;
+	int n;
+	int m;
+	int *canonical; /* NULL for a free slot */
+	int *solution; /* canonical solution, NULL if unknown */
+	long count;
+	int countKnown;
+	int countExact;
+	double seconds; /* solver time of the newest result */
+	char engine[CACHE_ENGINE_LEN]; /* the solver that produced it */
+}ResultEntry;
+
+static ResultEntry *table = NULL;
+static int capacity = 0;
+static int numEntries = 0;
+static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
+
+int makeBoardKey(Game *game, BoardKey *key, SolveControl *control){
+	int N = game->n*game->m, row, col;
+	int *grid;
+	/* the catalogue answers faster than a canonical form is computed */
+	if(hasCatalogue(game->n, game->m))
+		return 0;
+	key->n = game->n;
+	key->m = game->m;
+	grid = (int*)calloc(N*N, sizeof(int));
+	key->canonical = (int*)calloc(N*N, sizeof(int));
+	if(grid == NULL || key->canonical == NULL){
+		free(grid);
+		free(key->canonical);
+		key->canonical = NULL;
+		return 0;
+	}
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++)
+			grid[row*N+col] = game->board[row][col].value;
+	}
+	if(!canonicalize(game->n, game->m, grid, key->canonical, &key->transform, control)){
+		free(grid);
+		free(key->canonical);
+		key->canonical = NULL;
+		return 0;
+	}
+	key->hash = canonicalHash(game->n, game->m, key->canonical);
+	free(grid);
+	return 1;
+}
+
+void freeBoardKey(BoardKey *key){
+	free(key->canonical);
+	key->canonical = NULL;
+}
+
+static void clearTable(){
+	int i;
+	for(i = 0; i < capacity; i++){
+		free(table[i].canonical);
+		free(table[i].solution);
+	}
+	free(table);
+	table = NULL;
+	capacity = 0;
+	numEntries = 0;
+}
+
+/* the slot of the key: its entry if it is in the table, otherwise the free slot where it belongs. NULL if there is no table */
+static ResultEntry* findSlot(BoardKey *key){
+	int N = key->n*key->m, i;
+	ResultEntry *entry;
+	if(table == NULL)
+		return NULL;
+	for(i = (int)(key->hash & (uint64_t)(capacity-1)); ; i = (i+1) & (capacity-1)){
+		entry = &table[i];
+		if(entry->canonical == NULL)
+			return entry;
+		if(entry->hash == key->hash && entry->n == key->n && entry->m == key->m
+				&& memcmp(entry->canonical, key->canonical, N*N*sizeof(int)) == 0)
+			return entry;
+	}
+}
+
+/* the entry of the key, added if it isn't in the table yet. NULL on a memory error */
+static ResultEntry* getEntry(BoardKey *key){
+	ResultEntry *entry, *oldTable;
+	int oldCapacity, i, N = key->n*key->m;
+	if(numEntries >= RESULTS_MAX_ENTRIES)
+		clearTable();
+	/* keep the table at most half full */
+	if(2*(numEntries+1) > capacity){
+		oldTable = table;
+		oldCapacity = capacity;
+		capacity = capacity == 0 ? 64 : 2*capacity;
+		table = (ResultEntry*)calloc(capacity, sizeof(ResultEntry));
+		if(table == NULL){
+			table = oldTable;
+			capacity = oldCapacity;
+			return NULL;
+		}
+		for(i = 0; i < oldCapacity; i++){
+			if(oldTable[i].canonical != NULL){
+				BoardKey moved;
+				moved.n = oldTable[i].n;
+				moved.m = oldTable[i].m;
+				moved.hash = oldTable[i].hash;
+				moved.canonical = oldTable[i].canonical;
+				*findSlot(&moved) = oldTable[i];
+			}
+		}
+		free(oldTable);
+	}
+	entry = findSlot(key);
+	if(entry->canonical == NULL){
+		entry->canonical = (int*)malloc(N*N*sizeof(int));
+		if(entry->canonical == NULL)
+			return NULL;
+		memcpy(entry->canonical, key->canonical, N*N*sizeof(int));
+		entry->hash = key->hash;
+		entry->n = key->n;
+		entry->m = key->m;
+		numEntries++;
+	}
+	return entry;
+}
+
+/* the entry of the key, loaded from the solution cache if it isn't in memory. NULL if the board is unknown.
+ * the caller holds the table lock */
+static ResultEntry* findEntry(BoardKey *key){
+	ResultEntry *entry = findSlot(key);
+	CacheRecord record;
+	if(entry != NULL && entry->canonical != NULL)
+		return entry;
+	if(!cacheLookup(key->hash, key->n, key->m, key->canonical, &record))
+		return NULL;
+	entry = getEntry(key);
+	if(entry != NULL){
+		if(record.hasSolution && entry->solution == NULL){
+			entry->solution = record.solution;
+			record.solution = NULL;
+		}
+		entry->count = record.count;
+		entry->countKnown = record.countKnown;
+		entry->countExact = record.countExact;
+		entry->seconds = record.seconds;
+		memcpy(entry->engine, record.engine, CACHE_ENGINE_LEN);
+	}
+	free(record.solution);
+	return entry;
+}
+
+/* copies the entry for the solution cache. the caller holds the table lock, the copy lets it append after releasing it.
+ * returns 1 if there is something to append */
+static int copyForCache(ResultEntry *entry, CacheRecord *record){
+	int N = entry->n*entry->m;
+	if(!solutionCacheOpen())
+		return 0;
+	record->n = entry->n;
+	record->m = entry->m;
+	record->hasSolution = entry->solution != NULL;
+	record->solution = NULL;
+	if(record->hasSolution){
+		record->solution = (int*)malloc(N*N*sizeof(int));
+		if(record->solution == NULL)
+			return 0;
+		memcpy(record->solution, entry->solution, N*N*sizeof(int));
+	}
+	record->countKnown = entry->countKnown;
+	record->countExact = entry->countExact;
+	record->count = entry->count;
+	record->seconds = entry->seconds;
+	memcpy(record->engine, entry->engine, CACHE_ENGINE_LEN);
+	return 1;
+}
+
+static void appendToCache(BoardKey *key, CacheRecord *record){
+	cacheAppend(key->hash, key->n, key->m, key->canonical, record);
+	free(record->solution);
+}
+
+int lookupSolution(BoardKey *key, int *solution){
+	ResultEntry *entry;
+	int found = 0;
+	pthread_mutex_lock(&tableLock);
+	entry = findEntry(key);
+	if(entry != NULL && entry->solution != NULL){
+		undoTransform(&key->transform, entry->solution, solution);
+		found = 1;
+	}
+	pthread_mutex_unlock(&tableLock);
+	return found;
+}
+
+void storeSolution(BoardKey *key, const int *solution, const char *engine, double seconds){
+	ResultEntry *entry;
+	CacheRecord record;
+	int N = key->n*key->m, changed = 0;
+	pthread_mutex_lock(&tableLock);
+	entry = findEntry(key);
+	if(entry == NULL)
+		entry = getEntry(key);
+	if(entry != NULL && entry->solution == NULL){
+		entry->solution = (int*)malloc(N*N*sizeof(int));
+		if(entry->solution != NULL){
+			applyTransform(&key->transform, solution, entry->solution);
+			entry->seconds = seconds;
+			strncpy(entry->engine, engine, CACHE_ENGINE_LEN-1);
+			changed = copyForCache(entry, &record);
+		}
+	}
+	pthread_mutex_unlock(&tableLock);
+	if(changed)
+		appendToCache(key, &record);
+}
+
+int lookupCount(BoardKey *key, long *count, int *exact){
+	ResultEntry *entry;
+	int found = 0;
+	pthread_mutex_lock(&tableLock);
+	entry = findEntry(key);
+	if(entry != NULL && entry->countKnown){
+		*count = entry->count;
+		*exact = entry->countExact;
+		found = 1;
+	}
+	pthread_mutex_unlock(&tableLock);
+	return found;
+}
+
+void storeCount(BoardKey *key, long count, int exact, const char *engine, double seconds){
+	ResultEntry *entry;
+	CacheRecord record;
+	int changed = 0;
+	pthread_mutex_lock(&tableLock);
+	entry = findEntry(key);
+	if(entry == NULL)
+		entry = getEntry(key);
+	/* an exact count is never replaced, a lower bound only by a better one */
+	if(entry != NULL && !(entry->countKnown && entry->countExact) && (exact || !entry->countKnown || count > entry->count)){
+		entry->count = count;
+		entry->countKnown = 1;
+		entry->countExact = exact;
+		entry->seconds = seconds;
+		strncpy(entry->engine, engine, CACHE_ENGINE_LEN-1);
+		changed = copyForCache(entry, &record);
+	}
+	pthread_mutex_unlock(&tableLock);
+	if(changed)
+		appendToCache(key, &record);
+}
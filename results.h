@@ -0,0 +1,45 @@
+/* Header file of the results module. Remembers the solutions and the solution counts found during the session, keyed by the
+ * canonical form of the board (see canon.h). A board isomorphic to one already solved - the same puzzle with its digits relabeled,
+ * its rows, columns, bands or stacks shuffled, or transposed - is answered from the table, and the stored canonical solution
+ * is mapped back to the orientation of the board that asked for it.
+ * When the persistent solution cache is open (see solCache.h) the results also survive the session.*/
+
+#ifndef RESULTS_H_
+#define RESULTS_H_
+#include <stdint.h>
+#include "game.h"
+#include "canon.h"
+
+#define RESULTS_MAX_ENTRIES 4096
+
+/* the canonical identity of a board */
+typedef struct BoardKey{
+	int n;
+	int m;
+	uint64_t hash;
+	int *canonical; /* the canonical grid, N*N values */
+	Transform transform; /* maps the board to the canonical grid */
+}BoardKey;
+
+/* computes the key of the board of the game, control (may be NULL) stops the search of its canonical form.
+ * returns 1 on success, 0 if the board can't be keyed (too large, too sparse, out of its search budget, stopped, memory)
+ * or needn't be (its geometry has a catalogue, see catalogue.h) */
+int makeBoardKey(Game *game, BoardKey *key, SolveControl *control);
+
+void freeBoardKey(BoardKey *key);
+
+/* puts a known solution of the board in solution (N*N values, row major, in the orientation of the board).
+ * returns 1 if a solution was known, 0 otherwise */
+int lookupSolution(BoardKey *key, int *solution);
+
+/* remembers solution (in the orientation of the board) as a solution of the board, found by engine in seconds */
+void storeSolution(BoardKey *key, const int *solution, const char *engine, double seconds);
+
+/* puts the known number of solutions of the board in count, exact is 0 if it is only a lower bound.
+ * returns 1 if a count was known, 0 otherwise */
+int lookupCount(BoardKey *key, long *count, int *exact);
+
+/* remembers the number of solutions of the board, exact is 0 if count is only a lower bound. engine and seconds tell how it was found */
+void storeCount(BoardKey *key, long count, int exact, const char *engine, double seconds);
+
+#endif /* RESULTS_H_ */
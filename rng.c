@@ -0,0 +1,98 @@
+#include "rng.h"
+
+/* Rng Module
+ * xoshiro256** and its jump polynomial, by Blackman and Vigna, seeded with splitmix64.
+ */
+
+static uint64_t seedOfSession = 0;
+
+static uint64_t rotl(uint64_t x, int k){
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x){
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+void rngSeed(Rng *rng, uint64_t seed){
+	int i;
+	/* splitmix64 never gives four zeros, the one state xoshiro can't leave */
+	for(i = 0; i < 4; i++)
+		rng->s[i] = splitmix64(&seed);
+}
+
+uint64_t rngNext(Rng *rng){
+	uint64_t *s = rng->s;
+	uint64_t result = rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return result;
+}
+
+int rngBelow(Rng *rng, int bound){
+	uint32_t range = (uint32_t)bound, threshold;
+	uint64_t product = (rngNext(rng) >> 32) * range;
+	/* the low half of the product falls under 2^32 mod range for the values that would bias the result, draw again */
+	if((uint32_t)product < range){
+		threshold = (uint32_t)(-range) % range;
+		while((uint32_t)product < threshold)
+			product = (rngNext(rng) >> 32) * range;
+	}
+	return (int)(product >> 32);
+}
+
+double rngDouble(Rng *rng){
+	return (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void rngJump(Rng *rng){
+	static const uint64_t jump[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+	uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	int i, b;
+	for(i = 0; i < 4; i++){
+		for(b = 0; b < 64; b++){
+			if(jump[i] & (1ULL << b)){
+				s0 ^= rng->s[0];
+				s1 ^= rng->s[1];
+				s2 ^= rng->s[2];
+				s3 ^= rng->s[3];
+			}
+			rngNext(rng);
+		}
+	}
+	rng->s[0] = s0;
+	rng->s[1] = s1;
+	rng->s[2] = s2;
+	rng->s[3] = s3;
+}
+
+void rngSplit(Rng *parent, Rng *child){
+	*child = *parent;
+	rngJump(parent);
+}
+
+void rngShuffle(Rng *rng, int *array, int len){
+	int i, j, tmp;
+	for(i = len - 1; i > 0; i--){
+		j = rngBelow(rng, i + 1);
+		tmp = array[i];
+		array[i] = array[j];
+		array[j] = tmp;
+	}
+}
+
+void setSessionSeed(uint64_t seed){
+	seedOfSession = seed;
+}
+
+uint64_t sessionSeed(){
+	return seedOfSession;
+}
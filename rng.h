@@ -0,0 +1,42 @@
+/* Header file of the rng module. A small random number generator with explicit state (xoshiro256**), so every
+ * randomized part of the program - generation, the randomized searches, the probes of the estimator, the weights of the
+ * LP relaxation - draws from a stream it owns instead of the global, non-reentrant rand().
+ * A stream is seeded through splitmix64, so any 64 bit seed gives a well mixed state. rngSplit hands out independent
+ * streams for threads: the child takes the current state and the parent jumps 2^128 values ahead, past everything
+ * the child will ever draw. Bounded values are unbiased (Lemire's multiply and reject), unlike rand()%N.*/
+
+#ifndef RNG_H_
+#define RNG_H_
+#include <stdint.h>
+
+typedef struct Rng{
+	uint64_t s[4];
+}Rng;
+
+/* seeds the stream */
+void rngSeed(Rng *rng, uint64_t seed);
+
+/* the next 64 random bits */
+uint64_t rngNext(Rng *rng);
+
+/* a uniform integer in [0, bound), bound must be positive */
+int rngBelow(Rng *rng, int bound);
+
+/* a uniform double in [0, 1) */
+double rngDouble(Rng *rng);
+
+/* moves the stream 2^128 values ahead */
+void rngJump(Rng *rng);
+
+/* makes child a stream independent of parent and of every other child split from it */
+void rngSplit(Rng *parent, Rng *child);
+
+/* puts the len ints of array in a uniformly random order (Fisher-Yates) */
+void rngShuffle(Rng *rng, int *array, int len);
+
+/* the seed of the session, given on the command line. games and server workers seed their streams from it */
+void setSessionSeed(uint64_t seed);
+
+uint64_t sessionSeed();
+
+#endif /* RNG_H_ */
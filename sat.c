@@ -0,0 +1,790 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sat.h"
+#include "geometry.h"
+#include "trace.h"
+
+/* SAT Module
+ * the solver keeps its clauses in one arena of ints: a clause is [size, flags, lit0, lit1, ...] and is referred to by its offset.
+ * internally a literal of the variable v (0 based) is 2v when positive and 2v+1 when negative.
+ * the first two literals of a clause are the watched ones, and the implied literal of a reason clause is always its first.
+ * a variable is assigned -1 (unassigned), 0 (false) or 1 (true).
+ */
+
+#define CLAUSE_LEARNT 1
+#define CLAUSE_DELETED 2
+#define LBD_SHIFT 2
+#define RESTART_UNIT 100 /* conflicts in the first restart interval, the next ones follow the Luby sequence */
+#define VAR_DECAY 0.95
+#define MIN_MAX_LEARNTS 2000
+#define NO_REASON -1
+
+typedef struct Watchers{
+	int *refs;
+	int len;
+	int cap;
+}Watchers;
+
+struct SatSolver{
+	int numVars;
+	int *arena;
+	int arenaLen;
+	int arenaCap;
+	int numClauses; /* problem clauses of two literals or more */
+	int *learnts; /* refs of the learnt clauses that weren't deleted */
+	int numLearnts;
+	int capLearnts;
+	int maxLearnts;
+	Watchers *watches; /* watches[l] - the clauses that watch the literal l */
+	signed char *assign;
+	char *polarity; /* the saved phase of every variable */
+	int *level;
+	int *reason;
+	int *trail;
+	int trailLen;
+	int qhead;
+	int *trailLim; /* where every decision level starts in the trail */
+	int decisionLevel;
+	double *activity;
+	double varInc;
+	int *heap; /* the unassigned variables (and some assigned ones) ordered by activity */
+	int heapLen;
+	int *heapIndex;
+	char *seen;
+	int *learntBuf;
+	int *toClear;
+	int *levelStamp;
+	int stamp;
+	char *litSeen; /* used while adding a clause, by literal */
+	signed char *model;
+	int unsat;
+	long conflicts;
+};
+
+/* ---------------------------------------- helpers ---------------------------------------- */
+
+static int toLit(int dimacs){
+	return dimacs > 0 ? 2*(dimacs-1) : 2*(-dimacs-1) + 1;
+}
+
+/* 1 if the literal is true, 0 if false, -1 if unassigned */
+static int litValue(SatSolver *s, int lit){
+	int value = s->assign[lit >> 1];
+	if(value < 0)
+		return -1;
+	return value ^ (lit & 1);
+}
+
+static int pushWatch(Watchers *ws, int ref){
+	int *grown;
+	if(ws->len == ws->cap){
+		grown = (int*) realloc(ws->refs, (ws->cap > 0 ? 2*ws->cap : 4) * sizeof(int));
+		if(grown == NULL)
+			return 0;
+		ws->refs = grown;
+		ws->cap = ws->cap > 0 ? 2*ws->cap : 4;
+	}
+	ws->refs[ws->len++] = ref;
+	return 1;
+}
+
+/* ---------------------------------------- the activity heap ---------------------------------------- */
+
+static void heapSwap(SatSolver *s, int i, int j){
+	int tmp = s->heap[i];
+	s->heap[i] = s->heap[j];
+	s->heap[j] = tmp;
+	s->heapIndex[s->heap[i]] = i;
+	s->heapIndex[s->heap[j]] = j;
+}
+
+static void heapUp(SatSolver *s, int i){
+	while(i > 0 && s->activity[s->heap[(i-1)/2]] < s->activity[s->heap[i]]){
+		heapSwap(s, i, (i-1)/2);
+		i = (i-1)/2;
+	}
+}
+
+static void heapDown(SatSolver *s, int i){
+	int child;
+	for(;;){
+		child = 2*i + 1;
+		if(child >= s->heapLen)
+			return;
+		if(child + 1 < s->heapLen && s->activity[s->heap[child+1]] > s->activity[s->heap[child]])
+			child++;
+		if(s->activity[s->heap[child]] <= s->activity[s->heap[i]])
+			return;
+		heapSwap(s, i, child);
+		i = child;
+	}
+}
+
+static void heapInsert(SatSolver *s, int var){
+	if(s->heapIndex[var] >= 0)
+		return;
+	s->heap[s->heapLen] = var;
+	s->heapIndex[var] = s->heapLen++;
+	heapUp(s, s->heapIndex[var]);
+}
+
+static int heapPop(SatSolver *s){
+	int var = s->heap[0];
+	heapSwap(s, 0, --s->heapLen);
+	s->heapIndex[var] = -1;
+	heapDown(s, 0);
+	return var;
+}
+
+static void bumpVar(SatSolver *s, int var){
+	int i;
+	s->activity[var] += s->varInc;
+	if(s->activity[var] > 1e100){
+		for(i = 0; i < s->numVars; i++)
+			s->activity[i] *= 1e-100;
+		s->varInc *= 1e-100;
+	}
+	if(s->heapIndex[var] >= 0)
+		heapUp(s, s->heapIndex[var]);
+}
+
+/* ---------------------------------------- the solver ---------------------------------------- */
+
+SatSolver* createSat(int numVars){
+	SatSolver *s = (SatSolver*) calloc(1, sizeof(SatSolver));
+	int i, n = numVars > 0 ? numVars : 1;
+	if(s == NULL)
+		return NULL;
+	s->numVars = numVars;
+	s->watches = (Watchers*) calloc(2*n, sizeof(Watchers));
+	s->assign = (signed char*) malloc(n);
+	s->polarity = (char*) calloc(n, 1);
+	s->level = (int*) calloc(n, sizeof(int));
+	s->reason = (int*) calloc(n, sizeof(int));
+	s->trail = (int*) calloc(n, sizeof(int));
+	s->trailLim = (int*) calloc(n, sizeof(int));
+	s->activity = (double*) calloc(n, sizeof(double));
+	s->heap = (int*) calloc(n, sizeof(int));
+	s->heapIndex = (int*) calloc(n, sizeof(int));
+	s->seen = (char*) calloc(n, 1);
+	s->learntBuf = (int*) calloc(n, sizeof(int));
+	s->toClear = (int*) calloc(n, sizeof(int));
+	s->levelStamp = (int*) calloc(n + 1, sizeof(int));
+	s->litSeen = (char*) calloc(2*n, 1);
+	s->model = (signed char*) calloc(n, 1);
+	if(s->watches == NULL || s->assign == NULL || s->polarity == NULL || s->level == NULL || s->reason == NULL
+			|| s->trail == NULL || s->trailLim == NULL || s->activity == NULL || s->heap == NULL || s->heapIndex == NULL
+			|| s->seen == NULL || s->learntBuf == NULL || s->toClear == NULL || s->levelStamp == NULL
+			|| s->litSeen == NULL || s->model == NULL){
+		freeSat(s);
+		return NULL;
+	}
+	s->varInc = 1;
+	s->maxLearnts = MIN_MAX_LEARNTS;
+	for(i = 0; i < numVars; i++){
+		s->assign[i] = -1;
+		s->reason[i] = NO_REASON;
+		s->heapIndex[i] = -1;
+		heapInsert(s, i);
+	}
+	return s;
+}
+
+void freeSat(SatSolver *s){
+	int i;
+	if(s == NULL)
+		return;
+	if(s->watches != NULL){
+		for(i = 0; i < 2*(s->numVars > 0 ? s->numVars : 1); i++)
+			free(s->watches[i].refs);
+	}
+	free(s->watches);
+	free(s->arena);
+	free(s->learnts);
+	free(s->assign);
+	free(s->polarity);
+	free(s->level);
+	free(s->reason);
+	free(s->trail);
+	free(s->trailLim);
+	free(s->activity);
+	free(s->heap);
+	free(s->heapIndex);
+	free(s->seen);
+	free(s->learntBuf);
+	free(s->toClear);
+	free(s->levelStamp);
+	free(s->litSeen);
+	free(s->model);
+	free(s);
+}
+
+long satConflicts(SatSolver *s){
+	return s->conflicts;
+}
+
+int satValue(SatSolver *s, int var){
+	return s->model[var-1];
+}
+
+static void enqueue(SatSolver *s, int lit, int reason){
+	int var = lit >> 1;
+	s->assign[var] = (signed char)((lit & 1) ^ 1);
+	s->level[var] = s->decisionLevel;
+	s->reason[var] = reason;
+	s->trail[s->trailLen++] = lit;
+}
+
+/* store the clause in the arena and watch its first two literals. returns the ref, or -1 on a memory error */
+static int newClause(SatSolver *s, const int *lits, int len, int learnt, int lbd){
+	int ref, *grown, newCap;
+	if(s->arenaLen + len + 2 > s->arenaCap){
+		newCap = s->arenaCap > 0 ? s->arenaCap : 1024;
+		while(newCap < s->arenaLen + len + 2)
+			newCap *= 2;
+		grown = (int*) realloc(s->arena, newCap * sizeof(int));
+		if(grown == NULL)
+			return -1;
+		s->arena = grown;
+		s->arenaCap = newCap;
+	}
+	ref = s->arenaLen;
+	s->arena[ref] = len;
+	s->arena[ref+1] = (learnt ? CLAUSE_LEARNT : 0) | (lbd << LBD_SHIFT);
+	memcpy(s->arena + ref + 2, lits, len * sizeof(int));
+	s->arenaLen += len + 2;
+	if(!pushWatch(&s->watches[lits[0]], ref) || !pushWatch(&s->watches[lits[1]], ref))
+		return -1;
+	if(learnt){
+		if(s->numLearnts == s->capLearnts){
+			newCap = s->capLearnts > 0 ? 2*s->capLearnts : 256;
+			grown = (int*) realloc(s->learnts, newCap * sizeof(int));
+			if(grown == NULL)
+				return -1;
+			s->learnts = grown;
+			s->capLearnts = newCap;
+		}
+		s->learnts[s->numLearnts++] = ref;
+	}
+	else
+		s->numClauses++;
+	return ref;
+}
+
+/* undo the assignments of the levels above level, saving their phases */
+static void cancelUntil(SatSolver *s, int level){
+	int i, var;
+	if(s->decisionLevel <= level)
+		return;
+	for(i = s->trailLen - 1; i >= s->trailLim[level]; i--){
+		var = s->trail[i] >> 1;
+		s->polarity[var] = (char)s->assign[var];
+		s->assign[var] = -1;
+		s->reason[var] = NO_REASON;
+		heapInsert(s, var);
+	}
+	s->trailLen = s->trailLim[level];
+	s->qhead = s->trailLen;
+	s->decisionLevel = level;
+}
+
+/* unit propagation over the watch lists. returns the ref of a conflicting clause, or -1 */
+static int propagate(SatSolver *s){
+	Watchers *ws;
+	int p, falseLit, i, j, k, ref, size, first, found, *lits;
+	while(s->qhead < s->trailLen){
+		p = s->trail[s->qhead++];
+		falseLit = p ^ 1;
+		ws = &s->watches[falseLit];
+		i = j = 0;
+		while(i < ws->len){
+			ref = ws->refs[i++];
+			if(s->arena[ref+1] & CLAUSE_DELETED)
+				continue;/* dropped from the list on the way */
+			size = s->arena[ref];
+			lits = s->arena + ref + 2;
+			if(lits[0] == falseLit){
+				lits[0] = lits[1];
+				lits[1] = falseLit;
+			}
+			first = lits[0];
+			if(litValue(s, first) == 1){
+				ws->refs[j++] = ref;
+				continue;
+			}
+			/* look for another literal to watch */
+			found = 0;
+			for(k = 2; k < size && !found; k++){
+				if(litValue(s, lits[k]) != 0){
+					lits[1] = lits[k];
+					lits[k] = falseLit;
+					if(!pushWatch(&s->watches[lits[1]], ref))
+						ws->refs[j++] = ref;/* out of memory - keep watching the false literal, still correct */
+					found = 1;
+				}
+			}
+			if(found)
+				continue;
+			ws->refs[j++] = ref;
+			if(litValue(s, first) == 0){
+				while(i < ws->len)
+					ws->refs[j++] = ws->refs[i++];
+				ws->len = j;
+				s->qhead = s->trailLen;
+				return ref;
+			}
+			enqueue(s, first, ref);
+		}
+		ws->len = j;
+	}
+	return -1;
+}
+
+/* first-UIP conflict analysis. puts the learnt clause in learntBuf (the asserting literal first, a literal of the
+ * backjump level second) and returns its length, *btLevel gets the backjump level and *lbd the number of levels in it */
+static int analyze(SatSolver *s, int conflict, int *btLevel, int *lbd){
+	int pathC = 0, p = -1, idx = s->trailLen - 1, len = 1, numClear, i, j, k, var, size, ref = conflict, keep, max;
+	int *lits;
+	do{
+		size = s->arena[ref];
+		lits = s->arena + ref + 2;
+		for(k = (p == -1) ? 0 : 1; k < size; k++){
+			var = lits[k] >> 1;
+			if(!s->seen[var] && s->level[var] > 0){
+				s->seen[var] = 1;
+				bumpVar(s, var);
+				if(s->level[var] >= s->decisionLevel)
+					pathC++;
+				else
+					s->learntBuf[len++] = lits[k];
+			}
+		}
+		/* the next literal of the current level on the trail */
+		while(!s->seen[s->trail[idx] >> 1])
+			idx--;
+		p = s->trail[idx--];
+		ref = s->reason[p >> 1];
+		s->seen[p >> 1] = 0;
+		pathC--;
+	}while(pathC > 0);
+	s->learntBuf[0] = p ^ 1;
+	/* drop the literals implied by the other literals of the clause */
+	numClear = len;
+	memcpy(s->toClear, s->learntBuf, len * sizeof(int));
+	for(i = k = 1; i < len; i++){
+		var = s->learntBuf[i] >> 1;
+		ref = s->reason[var];
+		keep = 1;
+		if(ref != NO_REASON){
+			keep = 0;
+			size = s->arena[ref];
+			lits = s->arena + ref + 2;
+			for(j = 1; j < size && !keep; j++){
+				if(!s->seen[lits[j] >> 1] && s->level[lits[j] >> 1] > 0)
+					keep = 1;
+			}
+		}
+		if(keep)
+			s->learntBuf[k++] = s->learntBuf[i];
+	}
+	len = k;
+	for(i = 1; i < numClear; i++)
+		s->seen[s->toClear[i] >> 1] = 0;
+	/* the backjump level is the highest level below the current one, its literal is watched second */
+	*btLevel = 0;
+	max = 1;
+	for(i = 1; i < len; i++){
+		if(s->level[s->learntBuf[i] >> 1] > *btLevel){
+			*btLevel = s->level[s->learntBuf[i] >> 1];
+			max = i;
+		}
+	}
+	if(len > 1){
+		k = s->learntBuf[1];
+		s->learntBuf[1] = s->learntBuf[max];
+		s->learntBuf[max] = k;
+	}
+	s->stamp++;
+	*lbd = 0;
+	for(i = 0; i < len; i++){
+		if(s->levelStamp[s->level[s->learntBuf[i] >> 1]] != s->stamp){
+			s->levelStamp[s->level[s->learntBuf[i] >> 1]] = s->stamp;
+			(*lbd)++;
+		}
+	}
+	return len;
+}
+
+/* 1 if the clause is the reason of its first literal */
+static int locked(SatSolver *s, int ref){
+	int first = s->arena[ref+2];
+	return s->reason[first >> 1] == ref && litValue(s, first) == 1;
+}
+
+/* a learnt clause as reduceLearnts orders them */
+typedef struct LearntKey{
+	int lbd;
+	int size;
+	int ref;
+}LearntKey;
+
+static int compareLearnts(const void *a, const void *b){
+	const LearntKey *ka = (const LearntKey*)a, *kb = (const LearntKey*)b;
+	if(ka->lbd != kb->lbd)
+		return kb->lbd - ka->lbd;/* worst first */
+	return kb->size - ka->size;
+}
+
+/* move the clauses that weren't deleted to a new arena and point the watches, the learnts and the reasons at their new refs.
+ * the new ref of a moved clause is left in the size of its old copy until everything is remapped.
+ * without memory for the new arena the deleted clauses simply stay, propagate skips them */
+static void compactArena(SatSolver *s){
+	int *old = s->arena, *arena;
+	int ref, size, newLen = 0, lit, var, i, j;
+	Watchers *ws;
+	for(ref = 0; ref < s->arenaLen; ref += old[ref] + 2){
+		if(!(old[ref+1] & CLAUSE_DELETED))
+			newLen += old[ref] + 2;
+	}
+	arena = (int*) malloc((newLen > 0 ? newLen : 1) * sizeof(int));
+	if(arena == NULL)
+		return;
+	newLen = 0;
+	for(ref = 0; ref < s->arenaLen; ref += size + 2){
+		size = old[ref];
+		if(old[ref+1] & CLAUSE_DELETED)
+			continue;
+		memcpy(arena + newLen, old + ref, (size + 2) * sizeof(int));
+		old[ref] = newLen;
+		newLen += size + 2;
+	}
+	for(lit = 0; lit < 2*s->numVars; lit++){
+		ws = &s->watches[lit];
+		for(i = j = 0; i < ws->len; i++){
+			if(!(old[ws->refs[i]+1] & CLAUSE_DELETED))
+				ws->refs[j++] = old[ws->refs[i]];
+		}
+		ws->len = j;
+	}
+	for(i = 0; i < s->numLearnts; i++)
+		s->learnts[i] = old[s->learnts[i]];
+	/* only assigned variables have reasons, and those are locked, never deleted */
+	for(var = 0; var < s->numVars; var++){
+		if(s->reason[var] != NO_REASON)
+			s->reason[var] = old[s->reason[var]];
+	}
+	free(old);
+	s->arena = arena;
+	s->arenaLen = newLen;
+	s->arenaCap = newLen;
+}
+
+/* delete the worse half of the learnt clauses, keeping the ones with an lbd of 2 and the reasons of assignments,
+ * and compact the arena they leave */
+static void reduceLearnts(SatSolver *s){
+	int i, j, ref, half = s->numLearnts / 2;
+	LearntKey *keys = (LearntKey*) malloc(s->numLearnts * sizeof(LearntKey));
+	if(keys == NULL)
+		return;
+	for(i = 0; i < s->numLearnts; i++){
+		keys[i].ref = s->learnts[i];
+		keys[i].lbd = s->arena[keys[i].ref+1] >> LBD_SHIFT;
+		keys[i].size = s->arena[keys[i].ref];
+	}
+	qsort(keys, s->numLearnts, sizeof(LearntKey), compareLearnts);
+	for(i = j = 0; i < s->numLearnts; i++){
+		ref = keys[i].ref;
+		if(i < half && keys[i].lbd > 2 && !locked(s, ref))
+			s->arena[ref+1] |= CLAUSE_DELETED;
+		else
+			s->learnts[j++] = ref;
+	}
+	free(keys);
+	s->numLearnts = j;
+	s->maxLearnts += s->maxLearnts / 10;
+	compactArena(s);
+}
+
+int satAddClause(SatSolver *s, const int *lits, int len){
+	int i, k, lit, satisfied = 0, *clause;
+	if(s->unsat)
+		return 0;
+	cancelUntil(s, 0);
+	clause = s->learntBuf;
+	/* drop duplicates and literals false at level 0, skip tautologies and satisfied clauses */
+	for(i = k = 0; i < len && !satisfied; i++){
+		lit = toLit(lits[i]);
+		if(s->litSeen[lit ^ 1] || litValue(s, lit) == 1)
+			satisfied = 1;
+		if(satisfied || s->litSeen[lit] || litValue(s, lit) == 0)
+			continue;
+		s->litSeen[lit] = 1;
+		clause[k++] = lit;
+	}
+	for(i = 0; i < k; i++)
+		s->litSeen[clause[i]] = 0;
+	if(satisfied)
+		return 1;
+	if(k == 0){
+		s->unsat = 1;
+		return 0;
+	}
+	if(k == 1){
+		enqueue(s, clause[0], NO_REASON);
+		if(propagate(s) != -1){
+			s->unsat = 1;
+			return 0;
+		}
+		return 1;
+	}
+	return newClause(s, clause, k, 0, 0) < 0 ? -1 : 1;
+}
+
+int satSolve(SatSolver *s, SolveControl *control){
+	int conflict, len, btLevel, lbd, var, ref, i;
+	long restarts = 0, conflictsLeft;
+	if(s->unsat)
+		return 0;
+	cancelUntil(s, 0);
+	if(propagate(s) != -1){
+		s->unsat = 1;
+		return 0;
+	}
+	if(s->maxLearnts < s->numClauses / 3)
+		s->maxLearnts = s->numClauses / 3;
+	for(;;){
+		conflictsLeft = luby(restarts++) * RESTART_UNIT;
+		while(conflictsLeft > 0){
+			conflict = propagate(s);
+			if(conflict != -1){
+				s->conflicts++;
+				conflictsLeft--;
+				if(s->decisionLevel == 0){
+					s->unsat = 1;
+					return 0;
+				}
+				len = analyze(s, conflict, &btLevel, &lbd);
+				cancelUntil(s, btLevel);
+				if(len == 1)
+					enqueue(s, s->learntBuf[0], NO_REASON);
+				else{
+					ref = newClause(s, s->learntBuf, len, 1, lbd);
+					if(ref < 0)
+						return -1;
+					enqueue(s, s->learntBuf[0], ref);
+				}
+				s->varInc /= VAR_DECAY;
+				if(shouldStop(control)){
+					cancelUntil(s, 0);
+					return 2;
+				}
+				continue;
+			}
+			if(s->numLearnts - s->trailLen >= s->maxLearnts)
+				reduceLearnts(s);
+			/* decide: the most active unassigned variable, in its saved phase */
+			var = -1;
+			while(s->heapLen > 0 && var < 0){
+				var = heapPop(s);
+				if(s->assign[var] >= 0)
+					var = -1;
+			}
+			if(var < 0){
+				for(i = 0; i < s->numVars; i++)
+					s->model[i] = s->assign[i];
+				return 1;
+			}
+			s->trailLim[s->decisionLevel++] = s->trailLen;
+			enqueue(s, 2*var + (s->polarity[var] ? 0 : 1), NO_REASON);
+		}
+		cancelUntil(s, 0);
+	}
+}
+
+/* ---------------------------------------- sudoku encoding ---------------------------------------- */
+
+/* the CNF of a board, varOf[cell*N + value-1] is the variable of the pair or 0 if the given cells rule it out */
+typedef struct BoardFormula{
+	const Geometry *geo;
+	int *grid;
+	int *varOf;
+	int numVars;
+	SatSolver *solver;
+}BoardFormula;
+
+static void freeFormula(BoardFormula *f){
+	free(f->grid);
+	free(f->varOf);
+	freeSat(f->solver);
+}
+
+/* add the at-least-one clause of the variables and the at-most-one clauses of every pair of them.
+ * returns the result of satAddClause that failed, or 1 */
+static int addExactlyOne(SatSolver *solver, int *vars, int len){
+	int i, j, pair[2], res;
+	res = satAddClause(solver, vars, len);
+	for(i = 0; i < len && res == 1; i++){
+		for(j = i+1; j < len && res == 1; j++){
+			pair[0] = -vars[i];
+			pair[1] = -vars[j];
+			res = satAddClause(solver, pair, 2);
+		}
+	}
+	return res;
+}
+
+/* build the formula of the board. returns 1 if built, 0 if the given cells already contradict and -1 on a memory error */
+static int encodeBoard(Game *game, BoardFormula *f){
+	const Geometry *geo;
+	int N, cell, unit, i, v, len, res = 1, *vars;
+	unsigned long *used;
+	memset(f, 0, sizeof(BoardFormula));
+	geo = getGeometry(game->n, game->m);
+	if(geo == NULL)
+		return -1;
+	N = geo->N;
+	f->geo = geo;
+	f->grid = (int*) calloc(N*N, sizeof(int));
+	f->varOf = (int*) calloc(N*N*N, sizeof(int));
+	used = (unsigned long*) calloc(geo->numUnits, sizeof(unsigned long));
+	vars = (int*) calloc(N, sizeof(int));
+	if(f->grid == NULL || f->varOf == NULL || used == NULL || vars == NULL){
+		free(used);
+		free(vars);
+		freeFormula(f);
+		return -1;
+	}
+	/* the values the given cells take from every unit */
+	for(cell = 0; cell < N*N && res == 1; cell++){
+		v = game->board[geo->rowOf[cell]][geo->colOf[cell]].value;
+		f->grid[cell] = v;
+		if(v == 0)
+			continue;
+		if((used[geo->rowOf[cell]] | used[N + geo->colOf[cell]] | used[2*N + geo->boxOf[cell]]) & (1UL << (v-1)))
+			res = 0;
+		used[geo->rowOf[cell]] |= 1UL << (v-1);
+		used[N + geo->colOf[cell]] |= 1UL << (v-1);
+		used[2*N + geo->boxOf[cell]] |= 1UL << (v-1);
+	}
+	/* a variable for every pair the given cells allow */
+	for(cell = 0; cell < N*N && res == 1; cell++){
+		if(f->grid[cell] != 0)
+			continue;
+		for(v = 1; v <= N; v++){
+			if(!((used[geo->rowOf[cell]] | used[N + geo->colOf[cell]] | used[2*N + geo->boxOf[cell]]) & (1UL << (v-1))))
+				f->varOf[cell*N + v-1] = ++f->numVars;
+		}
+	}
+	if(res == 1){
+		f->solver = createSat(f->numVars);
+		if(f->solver == NULL)
+			res = -1;
+	}
+	/* every empty cell takes exactly one value */
+	for(cell = 0; cell < N*N && res == 1; cell++){
+		if(f->grid[cell] != 0)
+			continue;
+		for(v = 1, len = 0; v <= N; v++){
+			if(f->varOf[cell*N + v-1] != 0)
+				vars[len++] = f->varOf[cell*N + v-1];
+		}
+		res = addExactlyOne(f->solver, vars, len);
+	}
+	/* every value missing from a unit goes to exactly one of its empty cells */
+	for(unit = 0; unit < geo->numUnits && res == 1; unit++){
+		for(v = 1; v <= N && res == 1; v++){
+			if(used[unit] & (1UL << (v-1)))
+				continue;
+			for(i = 0, len = 0; i < N; i++){
+				cell = geo->unitCells[unit*N + i];
+				if(f->varOf[cell*N + v-1] != 0)
+					vars[len++] = f->varOf[cell*N + v-1];
+			}
+			res = addExactlyOne(f->solver, vars, len);
+		}
+	}
+	free(used);
+	free(vars);
+	if(res != 1)
+		freeFormula(f);
+	return res;
+}
+
+/* put the solution of the model in the grid of the formula */
+static void decodeModel(BoardFormula *f){
+	int N = f->geo->N, cell, v;
+	for(cell = 0; cell < N*N; cell++){
+		for(v = 1; v <= N; v++){
+			if(f->varOf[cell*N + v-1] != 0 && satValue(f->solver, f->varOf[cell*N + v-1]))
+				f->grid[cell] = v;
+		}
+	}
+}
+
+int satSolveBoard(Game *game, SolveControl *control, int *solution){
+	BoardFormula f;
+	int res, N = game->n*game->m;
+	TRACE_BEGIN("encode");
+	res = encodeBoard(game, &f);
+	TRACE_END("encode");
+	if(res == 0)
+		return 0;
+	if(res < 0){
+		printf("Error: calloc has failed\n");
+		return -1;
+	}
+	TRACE_BEGIN("cdcl");
+	res = satSolve(f.solver, control);
+	TRACE_END("cdcl");
+	if(res == 1 && solution != NULL){
+		decodeModel(&f);
+		memcpy(solution, f.grid, N*N*sizeof(int));
+	}
+	freeFormula(&f);
+	return res;
+}
+
+int satCountSolutions(Game *game, SolveControl *control, long limit, long *count){
+	BoardFormula f;
+	int res, N = game->n*game->m, cell, len, limited = 0, *block;
+	*count = 0;
+	res = encodeBoard(game, &f);
+	if(res == 0)
+		return 1;
+	if(res < 0){
+		printf("Error: calloc has failed\n");
+		return -1;
+	}
+	block = (int*) calloc(N*N, sizeof(int));
+	if(block == NULL){
+		freeFormula(&f);
+		return -1;
+	}
+	for(;;){
+		res = satSolve(f.solver, control);
+		if(res != 1)
+			break;
+		(*count)++;
+		if(control != NULL)
+			control->progress = *count;
+		if(*count >= limit){
+			limited = 1;
+			break;
+		}
+		/* block the solution just found: some empty cell must take another value */
+		decodeModel(&f);
+		for(cell = 0, len = 0; cell < N*N; cell++){
+			if(game->board[f.geo->rowOf[cell]][f.geo->colOf[cell]].value == 0)
+				block[len++] = -f.varOf[cell*N + f.grid[cell]-1];
+		}
+		res = satAddClause(f.solver, block, len);
+		if(res != 1)
+			break;
+	}
+	free(block);
+	freeFormula(&f);
+	if(res < 0)
+		return -1;
+	return (res == 2 || limited) ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+/* Header file of the SAT module. A self-contained CDCL SAT solver (two watched literals, VSIDS, first-UIP clause learning,
+ * Luby restarts, phase saving and clause database reduction) and the encoding of a board as a CNF formula.
+ * The encoding has a variable only for the (cell, value) pairs the given cells allow, and for every empty cell and every
+ * value missing from a unit an at-least-one clause and pairwise at-most-one clauses.
+ * Variables are numbered from 1, a literal is +v or -v as in DIMACS.*/
+
+#ifndef SAT_H_
+#define SAT_H_
+#include "game.h"
+#include "control.h"
+
+typedef struct SatSolver SatSolver;
+
+/* a solver with numVars variables and no clauses, or NULL on a memory error */
+SatSolver* createSat(int numVars);
+
+void freeSat(SatSolver *solver);
+
+/* add the clause of len literals. may be called again after satSolve, to add blocking clauses.
+ * returns 0 if the formula became unsatisfiable, -1 on a memory error and 1 otherwise */
+int satAddClause(SatSolver *solver, const int *lits, int len);
+
+/* returns 1 if the formula is satisfiable (the model is then read with satValue), 0 if it isn't,
+ * 2 if the control stopped the search and -1 on a memory error */
+int satSolve(SatSolver *solver, SolveControl *control);
+
+/* the value (0 or 1) of the variable in the model of the last satSolve that returned 1 */
+int satValue(SatSolver *solver, int var);
+
+/* the number of conflicts the solver ran into so far */
+long satConflicts(SatSolver *solver);
+
+/* solves the board with the SAT solver and puts the value of every cell in solution (N*N, row by row) if it isn't NULL.
+ * returns 1 if solved, 0 if the board has no solution, 2 if the control stopped the search and -1 on an error */
+int satSolveBoard(Game *game, SolveControl *control, int *solution);
+
+/* counts the solutions of the board by solving it again with every solution found blocked, up to limit solutions.
+ * meant for uniqueness checks and boards with few solutions. returns 1 if *count is exact, 0 if the control
+ * stopped it or limit was reached (*count is then a lower bound) and -1 on an error */
+int satCountSolutions(Game *game, SolveControl *control, long limit, long *count);
+
+#endif /* SAT_H_ */
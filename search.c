@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "search.h"
+#include "geometry.h"
+#include "rng.h"
+#include "trace.h"
+
+/* Search Module
+ * the stack holds the cells that were given a value, with the values still to try for each of them.
+ * the open cells - empty and not on the stack - are linked into buckets by their number of candidates.
+ * every change of the state - a value, a unit mask, an empty-peer counter, a bucket move, a cell leaving the open
+ * cells - is recorded on one trail, allocated with the state for the deepest possible search. every stack entry
+ * remembers where the trail was before its value went in, and going back pops the trail to that mark in reverse,
+ * so taking a value back costs what putting it in did, and the search neither allocates nor copies the board.
+ * the randomized search runs the same loop with random tie-breaks and value orders and a node budget. when the budget
+ * runs out the stack is unwound and the search starts over with the next budget of the schedule. the failures of every
+ * (cell, value) pair are counted and decay by half at every restart, and the values that failed least are tried first.
+ */
+
+#define TRAIL_VALUE 0 /* a cell got a value, it was empty. its peers get their empty peer back when it is undone */
+#define TRAIL_USED 1 /* a unit mask changed, old is the mask before */
+#define TRAIL_MOVE 2 /* an open peer lost a candidate and moved down a bucket */
+#define TRAIL_OPEN 3 /* a cell went on the stack, old is the bucket it left (-1 if the buckets aren't kept) */
+
+typedef struct TrailEntry{
+	int kind;
+	int index; /* the cell or the unit that changed */
+	unsigned long old;
+}TrailEntry;
+
+typedef struct SearchState{
+	const Geometry *geo;
+	int N;
+	int options;
+	int *grid;
+	unsigned long *used; /* 3N masks, bit v-1 is set if value v is in the unit */
+	int *bucketHead; /* N+1 buckets by the number of candidates, -1 if empty */
+	int *next; /* the links of the buckets, by cell */
+	int *prev;
+	int *bucketOf; /* the bucket of an open cell, -1 if the cell isn't open */
+	int minBucket; /* no bucket below it has a cell */
+	int *emptyPeers; /* the number of empty peers of every cell */
+	int *emptyCells; /* the empty cells in row-major order */
+	int numEmpty;
+	int numOpen;
+	int *stackCell;
+	int *stackValues; /* N values per stack entry, in the order they are tried */
+	int *stackLen;
+	int *stackNext;
+	int *stackMark; /* the length of the trail before the value of the stack entry went in */
+	int top; /* the top of the stack, -1 when it is empty */
+	TrailEntry *trail;
+	int trailLen;
+	Rng *rng; /* the stream of the randomized search, NULL for the deterministic search */
+	double *failures; /* N per cell, the decayed number of times each value failed in the cell, NULL if not learned */
+}SearchState;
+
+static unsigned long candidateMask(SearchState *state, int cell){
+	const Geometry *geo = state->geo;
+	int N = state->N;
+	unsigned long all = N == 64 ? ~0UL : (1UL << N) - 1;
+	return all & ~(state->used[geo->rowOf[cell]] | state->used[N + geo->colOf[cell]] | state->used[2*N + geo->boxOf[cell]]);
+}
+
+static int countMask(unsigned long mask){
+	int count = 0;
+	while(mask){
+		mask &= mask - 1;
+		count++;
+	}
+	return count;
+}
+
+static void bucketInsert(SearchState *state, int cell, int bucket){
+	state->bucketOf[cell] = bucket;
+	state->prev[cell] = -1;
+	state->next[cell] = state->bucketHead[bucket];
+	if(state->bucketHead[bucket] >= 0)
+		state->prev[state->bucketHead[bucket]] = cell;
+	state->bucketHead[bucket] = cell;
+	if(bucket < state->minBucket)
+		state->minBucket = bucket;
+}
+
+static void bucketRemove(SearchState *state, int cell){
+	if(state->prev[cell] >= 0)
+		state->next[state->prev[cell]] = state->next[cell];
+	else
+		state->bucketHead[state->bucketOf[cell]] = state->next[cell];
+	if(state->next[cell] >= 0)
+		state->prev[state->next[cell]] = state->prev[cell];
+	state->bucketOf[cell] = -1;
+}
+
+static void bucketMove(SearchState *state, int cell, int bucket){
+	bucketRemove(state, cell);
+	bucketInsert(state, cell, bucket);
+}
+
+static void record(SearchState *state, int kind, int index, unsigned long old){
+	TrailEntry *entry = &state->trail[state->trailLen++];
+	entry->kind = kind;
+	entry->index = index;
+	entry->old = old;
+}
+
+/* put val in the cell and take it from the candidates of the open peers, recording every change on the trail */
+static void assign(SearchState *state, int cell, int val){
+	const Geometry *geo = state->geo;
+	const int *peers = geo->peers + cell*geo->numPeers;
+	unsigned long bit = 1UL << (val-1);
+	int N = state->N, i, peer, unit[3];
+	/* the row-major order needs neither the buckets nor the empty peers */
+	if(!(state->options & SEARCH_ROW_ORDER)){
+		for(i = 0; i < geo->numPeers; i++){
+			peer = peers[i];
+			state->emptyPeers[peer]--;
+			if(state->bucketOf[peer] >= 0 && (candidateMask(state, peer) & bit)){
+				bucketMove(state, peer, state->bucketOf[peer] - 1);
+				record(state, TRAIL_MOVE, peer, 0);
+			}
+		}
+	}
+	unit[0] = geo->rowOf[cell];
+	unit[1] = N + geo->colOf[cell];
+	unit[2] = 2*N + geo->boxOf[cell];
+	for(i = 0; i < 3; i++){
+		record(state, TRAIL_USED, unit[i], state->used[unit[i]]);
+		state->used[unit[i]] |= bit;
+	}
+	record(state, TRAIL_VALUE, cell, 0);
+	state->grid[cell] = val;
+}
+
+/* take the cell off the open cells */
+static void closeCell(SearchState *state, int cell){
+	record(state, TRAIL_OPEN, cell, (unsigned long)state->bucketOf[cell]);
+	if(state->bucketOf[cell] >= 0)
+		bucketRemove(state, cell);
+	state->numOpen--;
+}
+
+/* undo the changes on the trail back to mark, newest first */
+static void undoTo(SearchState *state, int mark){
+	const Geometry *geo = state->geo;
+	const int *peers;
+	TrailEntry *entry;
+	int i;
+	while(state->trailLen > mark){
+		entry = &state->trail[--state->trailLen];
+		switch(entry->kind){
+		case TRAIL_VALUE:
+			state->grid[entry->index] = (int)entry->old;
+			if(!(state->options & SEARCH_ROW_ORDER)){
+				peers = geo->peers + entry->index*geo->numPeers;
+				for(i = 0; i < geo->numPeers; i++)
+					state->emptyPeers[peers[i]]++;
+			}
+			break;
+		case TRAIL_USED:
+			state->used[entry->index] = entry->old;
+			break;
+		case TRAIL_MOVE:
+			bucketMove(state, entry->index, state->bucketOf[entry->index] + 1);
+			break;
+		default:
+			if((long)entry->old >= 0)
+				bucketInsert(state, entry->index, (int)(long)entry->old);
+			state->numOpen++;
+			break;
+		}
+	}
+}
+
+/* the cell to branch on at stack depth top, or -1 if an open cell has no candidates left */
+static int pickCell(SearchState *state, int top){
+	int bucket, cell, best, scanned, ties;
+	if(state->options & SEARCH_ROW_ORDER)
+		return state->emptyCells[top];
+	for(bucket = state->minBucket; state->bucketHead[bucket] < 0; bucket++);
+	state->minBucket = bucket;
+	if(bucket == 0)
+		return -1;
+	/* a forced cell needs no tie-break */
+	best = state->bucketHead[bucket];
+	if(bucket == 1)
+		return best;
+	ties = 1;
+	for(cell = state->next[best], scanned = 1; cell >= 0 && scanned < SEARCH_TIE_SCAN; cell = state->next[cell], scanned++){
+		if(state->emptyPeers[cell] > state->emptyPeers[best]){
+			best = cell;
+			ties = 1;
+		}
+		/* the randomized search picks one of the equal cells uniformly, as a reservoir of one */
+		else if(state->rng != NULL && state->emptyPeers[cell] == state->emptyPeers[best] && rngBelow(state->rng, ++ties) == 0)
+			best = cell;
+	}
+	return best;
+}
+
+/* push the cell with its values in the order they will be tried */
+static void push(SearchState *state, int top, int cell){
+	const Geometry *geo = state->geo;
+	const int *peers = geo->peers + cell*geo->numPeers;
+	int N = state->N, *values = state->stackValues + top*N, len = 0, val, i, j, score[64];
+	unsigned long mask = candidateMask(state, cell);
+	for(val = 1; val <= N; val++){
+		if(mask & (1UL << (val-1)))
+			values[len++] = val;
+	}
+	if(state->rng != NULL && len > 1){
+		/* a random order, then the values that failed least in the cell first. the sort is stable, so ties stay random */
+		rngShuffle(state->rng, values, len);
+		if(state->failures != NULL){
+			for(i = 1; i < len; i++){
+				for(j = i; j > 0 && state->failures[cell*N + values[j-1]-1] > state->failures[cell*N + values[j]-1]; j--){
+					val = values[j]; values[j] = values[j-1]; values[j-1] = val;
+				}
+			}
+		}
+	}
+	else if((state->options & SEARCH_LCV) && len > 1){
+		/* the score of a value is the number of open peers that would lose it */
+		for(i = 0; i < len; i++){
+			score[i] = 0;
+			for(j = 0; j < geo->numPeers; j++){
+				if(state->grid[peers[j]] == 0 && (candidateMask(state, peers[j]) & (1UL << (values[i]-1))))
+					score[i]++;
+			}
+		}
+		/* an insertion sort keeps equal scores in ascending order of the values */
+		for(i = 1; i < len; i++){
+			for(j = i; j > 0 && score[j-1] > score[j]; j--){
+				val = score[j]; score[j] = score[j-1]; score[j-1] = val;
+				val = values[j]; values[j] = values[j-1]; values[j-1] = val;
+			}
+		}
+	}
+	state->stackCell[top] = cell;
+	state->stackLen[top] = len;
+	state->stackNext[top] = 0;
+	closeCell(state, cell);
+	state->stackMark[top] = state->trailLen;
+}
+
+static void freeSearchState(SearchState *state){
+	free(state->grid);
+	free(state->used);
+	free(state->bucketHead);
+	free(state->next);
+	free(state->prev);
+	free(state->bucketOf);
+	free(state->emptyPeers);
+	free(state->emptyCells);
+	free(state->stackCell);
+	free(state->stackValues);
+	free(state->stackLen);
+	free(state->stackNext);
+	free(state->stackMark);
+	free(state->trail);
+	free(state->failures);
+}
+
+/* set up the state of the board of the game. returns 1 on success, 0 if two given cells clash and -1 on an error */
+static int initSearchState(SearchState *state, Game *game, int options){
+	int N = game->n*game->m, cell, val, i;
+	unsigned long bit, *unit[3];
+	memset(state, 0, sizeof(*state));
+	state->geo = getGeometry(game->n, game->m);
+	if(state->geo == NULL)
+		return -1;
+	state->N = N;
+	state->options = options;
+	state->grid = (int*)calloc(N*N, sizeof(int));
+	state->used = (unsigned long*)calloc(3*N, sizeof(unsigned long));
+	state->bucketHead = (int*)malloc((N+1)*sizeof(int));
+	state->next = (int*)calloc(N*N, sizeof(int));
+	state->prev = (int*)calloc(N*N, sizeof(int));
+	state->bucketOf = (int*)malloc(N*N*sizeof(int));
+	state->emptyPeers = (int*)calloc(N*N, sizeof(int));
+	state->emptyCells = (int*)calloc(N*N, sizeof(int));
+	state->stackCell = (int*)calloc(N*N, sizeof(int));
+	state->stackValues = (int*)calloc(N*N*N, sizeof(int));
+	state->stackLen = (int*)calloc(N*N, sizeof(int));
+	state->stackNext = (int*)calloc(N*N, sizeof(int));
+	state->stackMark = (int*)calloc(N*N, sizeof(int));
+	if(state->grid == NULL || state->used == NULL || state->bucketHead == NULL || state->next == NULL || state->prev == NULL
+			|| state->bucketOf == NULL || state->emptyPeers == NULL || state->emptyCells == NULL || state->stackCell == NULL
+			|| state->stackValues == NULL || state->stackLen == NULL || state->stackNext == NULL || state->stackMark == NULL){
+		printf("Error: calloc has failed\n");
+		freeSearchState(state);
+		return -1;
+	}
+	for(cell = 0; cell < N*N; cell++){
+		val = game->board[cell/N][cell%N].value;
+		state->grid[cell] = val;
+		state->bucketOf[cell] = -1;
+		if(val == 0){
+			state->emptyCells[state->numEmpty++] = cell;
+			continue;
+		}
+		bit = 1UL << (val-1);
+		unit[0] = &state->used[state->geo->rowOf[cell]];
+		unit[1] = &state->used[N + state->geo->colOf[cell]];
+		unit[2] = &state->used[2*N + state->geo->boxOf[cell]];
+		for(i = 0; i < 3; i++){
+			if(*unit[i] & bit){
+				freeSearchState(state);
+				return 0;
+			}
+			*unit[i] |= bit;
+		}
+	}
+	for(i = 0; i <= N; i++)
+		state->bucketHead[i] = -1;
+	state->minBucket = N;
+	for(i = 0; i < state->numEmpty; i++){
+		cell = state->emptyCells[i];
+		if(!(options & SEARCH_ROW_ORDER))
+			bucketInsert(state, cell, countMask(candidateMask(state, cell)));
+		for(val = 0; val < state->geo->numPeers; val++){
+			if(state->grid[state->geo->peers[cell*state->geo->numPeers + val]] == 0)
+				state->emptyPeers[cell]++;
+		}
+	}
+	state->numOpen = state->numEmpty;
+	state->top = -1;
+	/* every cell on the stack records its closing, at most one move of each peer, three unit masks and its value */
+	state->trail = (TrailEntry*)malloc((size_t)state->numEmpty*(state->geo->numPeers + 5)*sizeof(TrailEntry) + sizeof(TrailEntry));
+	if(state->trail == NULL){
+		printf("Error: calloc has failed\n");
+		freeSearchState(state);
+		return -1;
+	}
+	state->trailLen = 0;
+	return 1;
+}
+
+/* takes back every value on the stack, leaving the board as it was given */
+static void unwind(SearchState *state){
+	undoTo(state, 0);
+	state->top = -1;
+}
+
+/* runs the search from where the stack is until limit solutions (0 for no limit) were found, the search space ran out,
+ * the control stopped it or budget (0 for none) values were tried. *tried counts the values tried.
+ * returns 1 if the search ended by itself or by the limit, 0 if the control stopped it and 2 if the budget ran out */
+static int runSearch(SearchState *state, SolveControl *control, long limit, long *count, int *solution, long *tried, long budget){
+	int N = state->N, cell, val;
+	long start = *tried;
+	for(;;){
+		if(shouldStop(control))
+			return 0;
+		if(budget > 0 && *tried - start >= budget)
+			return 2;
+		if(state->numOpen == 0){
+			/* every empty cell has a value - a solution. go back to find the next one */
+			(*count)++;
+			if(control != NULL)
+				control->progress = *count;
+			if(*count == 1 && solution != NULL)
+				memcpy(solution, state->grid, N*N*sizeof(int));
+			if(*count == limit)
+				return 1;
+		}
+		else if((cell = pickCell(state, state->top+1)) >= 0){
+			push(state, ++state->top, cell);
+		}
+		/* move the top of the stack to its next value, popping the cells that ran out of values */
+		while(state->top >= 0){
+			cell = state->stackCell[state->top];
+			val = state->grid[cell];
+			if(val != 0){
+				undoTo(state, state->stackMark[state->top]);
+				if(state->failures != NULL)
+					state->failures[cell*N + val-1] += 1;
+			}
+			if(state->stackNext[state->top] < state->stackLen[state->top]){
+				assign(state, cell, state->stackValues[state->top*N + state->stackNext[state->top]++]);
+				(*tried)++;
+				break;
+			}
+			/* the mark is just after the cell was closed, one more entry opens it again */
+			undoTo(state, state->stackMark[state->top] - 1);
+			state->top--;
+		}
+		if(state->top < 0)
+			return 1;
+	}
+}
+
+int searchBoard(Game *game, SolveControl *control, int options, long limit, long *count, int *solution, long *nodes){
+	SearchState state;
+	int res;
+	long tried = 0;
+	*count = 0;
+	if(nodes != NULL)
+		*nodes = 0;
+	res = initSearchState(&state, game, options);
+	if(res <= 0)
+		return res == 0 ? 1 : -1;
+	TRACE_BEGIN("search");
+	res = runSearch(&state, control, limit, count, solution, &tried, 0);
+	TRACE_END("search");
+	if(nodes != NULL)
+		*nodes = tried;
+	freeSearchState(&state);
+	return res;
+}
+
+int randomSearch(Game *game, SolveControl *control, Rng *rng, int options, int *solution, long *nodes, int *restarts){
+	SearchState state;
+	int res, N = game->n*game->m, run, i;
+	long tried = 0, count = 0, budget;
+	double geometric = 1;
+	if(nodes != NULL)
+		*nodes = 0;
+	if(restarts != NULL)
+		*restarts = 0;
+	/* the randomized search always branches on the most constrained cell */
+	res = initSearchState(&state, game, options & ~(SEARCH_ROW_ORDER | SEARCH_LCV));
+	if(res <= 0)
+		return res == 0 ? 0 : -1;
+	state.rng = rng;
+	if(!(options & SEARCH_NO_LEARN)){
+		state.failures = (double*)calloc(N*N*N, sizeof(double));
+		if(state.failures == NULL){
+			printf("Error: calloc has failed\n");
+			freeSearchState(&state);
+			return -1;
+		}
+	}
+	TRACE_BEGIN("randomSearch");
+	for(run = 0; ; run++){
+		if(options & SEARCH_GEOMETRIC){
+			budget = (long)(SEARCH_RESTART_NODES * N * geometric);
+			geometric *= SEARCH_GEOMETRIC_FACTOR;
+		}
+		else
+			budget = SEARCH_RESTART_NODES * N * luby(run);
+		res = runSearch(&state, control, 1, &count, solution, &tried, budget);
+		if(res != 2)
+			break;
+		/* the budget ran out - start over, remembering which values failed where */
+		unwind(&state);
+		if(state.failures != NULL){
+			for(i = 0; i < N*N*N; i++)
+				state.failures[i] /= 2;
+		}
+	}
+	TRACE_END("randomSearch");
+	if(nodes != NULL)
+		*nodes = tried;
+	if(restarts != NULL)
+		*restarts = run;
+	freeSearchState(&state);
+	/* a run that ended by itself either found a solution or searched the whole space */
+	if(res == 1)
+		return count > 0;
+	return 2;
+}
+
+void printSearchOptions(int options){
+	printf("Search: %s cells, %s values\n", (options & SEARCH_ROW_ORDER) ? "row-major" : "most constrained (mrv)",
+			(options & SEARCH_LCV) ? "least constraining (lcv)" : "ascending");
+	printf("Randomized search: %s restarts, %s\n", (options & SEARCH_GEOMETRIC) ? "geometric" : "luby",
+			(options & SEARCH_NO_LEARN) ? "no value learning (nolearn)" : "failed values tried last (learn)");
+}
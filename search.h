@@ -0,0 +1,45 @@
+/* Header file of the search module. The back-tracking search behind the back-tracking engine, countSolutions and the
+ * back-tracking racer of the portfolio. It runs on a copy of the board, with the used values of every row, column and
+ * box as bit masks (N <= 64).
+ * By default the next cell is the most constrained one (minimum remaining values), ties broken by the number of empty
+ * peers. The open cells are kept in buckets by their number of candidates, moved between buckets as values are placed
+ * and taken back, so finding that cell doesn't scan the board. A cell left with no candidate ends the branch at once.
+ * Values are tried in ascending order, or least constraining first - the value the fewest open peers could still take.
+ * The randomized search breaks ties and orders values at random, and restarts when a run uses up its node budget, so
+ * one unlucky early choice can't hold it for long: the run times of randomized back-tracking are heavy tailed, and a
+ * restart schedule cuts the tail off.*/
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+#include "game.h"
+#include "control.h"
+#include "rng.h"
+
+/* the options of a search, 0 is the default: the most constrained cell first and ascending values */
+#define SEARCH_ROW_ORDER 1 /* take the empty cells in row-major order instead */
+#define SEARCH_LCV 2 /* try the least constraining value first */
+#define SEARCH_GEOMETRIC 4 /* restart the randomized search on a geometric schedule instead of the Luby schedule */
+#define SEARCH_NO_LEARN 8 /* forget the failed values of the randomized search at every restart */
+
+#define SEARCH_TIE_SCAN 8 /* the cells of the lowest bucket compared by their empty peers */
+#define SEARCH_RESTART_NODES 64 /* the node budget of a run of the randomized search is this times N times the schedule term */
+#define SEARCH_GEOMETRIC_FACTOR 1.5
+
+/* searches the board of the game without changing it. the search ends after limit solutions (0 for no limit), the first
+ * solution is put in solution (N*N, row by row) if it isn't NULL, and the number of cells tried is put in *nodes if it
+ * isn't NULL. the count so far is published in control->progress.
+ * returns 1 if the search ended by itself or by the limit, 0 if the control stopped it (*count is then a lower bound)
+ * and -1 on an error */
+int searchBoard(Game *game, SolveControl *control, int options, long limit, long *count, int *solution, long *nodes);
+
+/* finds a random solution of the board of the game without changing it, drawing from rng, and puts it in solution
+ * (N*N, row by row) if it isn't NULL. the node budget of the runs follows the Luby sequence 1 1 2 1 1 2 4 ..., or grows
+ * geometrically with SEARCH_GEOMETRIC, and the values that failed in a cell are tried last in the next runs unless
+ * SEARCH_NO_LEARN. the total number of cells tried and of restarts are put in *nodes and *restarts if they aren't NULL.
+ * returns 1 if solved, 0 if the board has no solution, 2 if the control stopped the search and -1 on an error */
+int randomSearch(Game *game, SolveControl *control, Rng *rng, int options, int *solution, long *nodes, int *restarts);
+
+/* "mrv" or "rows", "ascending" or "lcv", "luby" or "geometric" and "learn" or "nolearn", for the options */
+void printSearchOptions(int options);
+
+#endif /* SEARCH_H_ */
@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "selector.h"
+#include "engine.h"
+#include "solver.h"
+#include "geometry.h"
+
+/* Selector Module
+ * the measured timings are kept per side N and bucket of candidate entropy, as the sum of the log of the seconds
+ * (so one pathological board doesn't swamp the mean of a bucket) and the number of solves. the table and the log are
+ * shared by the worker threads of the server, the lock protects both.
+ */
+
+#define SELECT_ENGINES (ENGINE_BACKTRACK+1) /* the table is indexed by the engine, only the real solvers are used */
+#define LOG_LINE_LEN 256
+
+typedef struct Timing{
+	double logSum;
+	long count;
+}Timing;
+
+static Timing timings[GEOMETRY_MAX_N+1][SELECT_SPACE_BUCKETS][SELECT_ENGINES];
+static FILE *timingLog = NULL;
+static pthread_mutex_t timingLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const int measuredEngines[] = {ENGINE_BACKTRACK, ENGINE_ILP, ENGINE_SAT};
+#define NUM_MEASURED ((int)(sizeof(measuredEngines)/sizeof(int)))
+
+static int spaceBucket(double entropy){
+	int bucket;
+	if(entropy < 1)
+		return 0;
+	bucket = 1 + (int)floor(log2(entropy));
+	return bucket < SELECT_SPACE_BUCKETS ? bucket : SELECT_SPACE_BUCKETS-1;
+}
+
+int extractFeatures(Game *game, BoardFeatures *features){
+	int N = game->n*game->m, cell, res, count;
+	int *grid;
+	unsigned long *cellCandidates, mask;
+	features->n = game->n;
+	features->m = game->m;
+	features->clues = 0;
+	features->emptyAfter = 0;
+	features->entropy = 0;
+	features->contradiction = 0;
+	if(N > GEOMETRY_MAX_N)
+		return 0;
+	grid = (int*)calloc(N*N, sizeof(int));
+	cellCandidates = (unsigned long*)calloc(N*N, sizeof(unsigned long));
+	if(grid == NULL || cellCandidates == NULL){
+		free(grid);
+		free(cellCandidates);
+		return 0;
+	}
+	res = propagateBoard(game, grid, cellCandidates);
+	if(res >= 0){
+		features->contradiction = res == 0;
+		for(cell = 0; cell < N*N; cell++){
+			if(game->board[cell/N][cell%N].value != 0)
+				features->clues++;
+			if(grid[cell] != 0)
+				continue;
+			features->emptyAfter++;
+			count = 0;
+			for(mask = cellCandidates[cell]; mask; mask &= mask - 1)
+				count++;
+			if(count > 1)
+				features->entropy += log2(count);
+		}
+	}
+	free(grid);
+	free(cellCandidates);
+	return res >= 0;
+}
+
+/* the mean measured seconds of the engine in the bucket, or 0 if it has too few solves there. the lock must be held */
+static double measuredSeconds(int N, int bucket, int engine){
+	Timing *timing = &timings[N][bucket][engine];
+	if(timing->count < SELECT_MIN_SAMPLES)
+		return 0;
+	return exp(timing->logSum / timing->count);
+}
+
+int selectEngine(const BoardFeatures *features, char *reason){
+	char scratch[SELECT_REASON_LEN];
+	int N = features->n*features->m, bucket = spaceBucket(features->entropy), i, best = -1, measured = 0, len;
+	double seconds, bestSeconds = 0;
+	if(reason == NULL)
+		reason = scratch;
+	if(features->contradiction){
+		strcpy(reason, "propagation already found a contradiction, the board has no solution");
+		return ENGINE_SAT;
+	}
+	/* a bucket where two engines or more were measured enough is answered by the measurements */
+	if(N <= GEOMETRY_MAX_N){
+		pthread_mutex_lock(&timingLock);
+		for(i = 0; i < NUM_MEASURED; i++){
+			seconds = measuredSeconds(N, bucket, measuredEngines[i]);
+			if(seconds <= 0)
+				continue;
+			measured++;
+			if(best < 0 || seconds < bestSeconds){
+				best = measuredEngines[i];
+				bestSeconds = seconds;
+			}
+		}
+		if(measured >= 2){
+			len = sprintf(reason, "measured on %dx%d boards of entropy bucket %d:", N, N, bucket);
+			for(i = 0; i < NUM_MEASURED; i++){
+				seconds = measuredSeconds(N, bucket, measuredEngines[i]);
+				if(seconds > 0)
+					len += sprintf(reason + len, " %s %.3g s", engineName(measuredEngines[i]), seconds);
+			}
+		}
+		pthread_mutex_unlock(&timingLock);
+		if(measured >= 2)
+			return best;
+	}
+	/* the built-in policy */
+	if(features->emptyAfter == 0){
+		strcpy(reason, "propagation alone solves the board");
+		return ENGINE_BACKTRACK;
+	}
+	if(N <= SELECT_BACKTRACK_MAX_N){
+		sprintf(reason, "a %dx%d board is back-tracked before the ILP model would be built", N, N);
+		return ENGINE_BACKTRACK;
+	}
+	if(features->entropy <= SELECT_BACKTRACK_MAX_ENTROPY){
+		sprintf(reason, "only %.1f bits of candidates are left after propagation", features->entropy);
+		return ENGINE_BACKTRACK;
+	}
+	if(N >= ENGINE_SAT_MIN_N){
+		sprintf(reason, "a %dx%d board with %.1f bits of candidates left is too large for the ILP model", N, N, features->entropy);
+		return ENGINE_SAT;
+	}
+	sprintf(reason, "a %dx%d board with %.1f bits of candidates left", N, N, features->entropy);
+	return ENGINE_ILP;
+}
+
+/* adds a timing to the table. the lock must be held */
+static void addTiming(int n, int m, double entropy, int engine, double seconds){
+	int N = n*m;
+	if(N < 1 || N > GEOMETRY_MAX_N || engine < 0 || engine >= SELECT_ENGINES || seconds < 0)
+		return;
+	/* the clock can't tell apart times under a microsecond */
+	if(seconds < 1e-6)
+		seconds = 1e-6;
+	timings[N][spaceBucket(entropy)][engine].logSum += log(seconds);
+	timings[N][spaceBucket(entropy)][engine].count++;
+}
+
+int openTimingLog(const char *path){
+	FILE *file;
+	char line[LOG_LINE_LEN], name[LOG_LINE_LEN];
+	int n, m, clues, emptyAfter, engine;
+	double entropy, seconds;
+	long loaded = 0;
+	closeTimingLog();
+	file = fopen(path, "r");
+	pthread_mutex_lock(&timingLock);
+	if(file != NULL){
+		while(fgets(line, sizeof(line), file) != NULL){
+			if(line[0] == '#')
+				continue;
+			if(sscanf(line, "%d %d %d %d %lf %s %lf", &n, &m, &clues, &emptyAfter, &entropy, name, &seconds) != 7)
+				continue;
+			engine = parseEngineName(name);
+			if(engine >= 0){
+				addTiming(n, m, entropy, engine, seconds);
+				loaded++;
+			}
+		}
+		fclose(file);
+	}
+	timingLog = fopen(path, "a");
+	if(timingLog != NULL && loaded == 0 && ftell(timingLog) == 0)
+		fprintf(timingLog, "# n m clues emptyAfter entropy engine seconds\n");
+	pthread_mutex_unlock(&timingLock);
+	if(timingLog == NULL){
+		printf("Error: could not open the timing log %s\n", path);
+		return 0;
+	}
+	return 1;
+}
+
+void closeTimingLog(){
+	pthread_mutex_lock(&timingLock);
+	if(timingLog != NULL)
+		fclose(timingLog);
+	timingLog = NULL;
+	pthread_mutex_unlock(&timingLock);
+}
+
+int timingLogOpen(){
+	int open;
+	pthread_mutex_lock(&timingLock);
+	open = timingLog != NULL;
+	pthread_mutex_unlock(&timingLock);
+	return open;
+}
+
+void recordTiming(const BoardFeatures *features, int engine, double seconds){
+	pthread_mutex_lock(&timingLock);
+	addTiming(features->n, features->m, features->entropy, engine, seconds);
+	if(timingLog != NULL){
+		/* one short line per write, so the lines of processes sharing the log don't interleave */
+		fprintf(timingLog, "%d %d %d %d %.3f %s %.9f\n", features->n, features->m, features->clues, features->emptyAfter,
+				features->entropy, engineName(engine), seconds);
+		fflush(timingLog);
+	}
+	pthread_mutex_unlock(&timingLock);
+}
+
+void explainSelection(Game *game){
+	BoardFeatures features;
+	char reason[SELECT_REASON_LEN];
+	int N = game->n*game->m, bucket, i, engine;
+	Timing timing;
+	if(!extractFeatures(game, &features)){
+		printf("Error: could not compute the features of the board\n");
+		return;
+	}
+	bucket = spaceBucket(features.entropy);
+	printf("Board: %dx%d (boxes of %dx%d), %d clues, %d cells empty after propagation%s\n", N, N, game->n, game->m,
+			features.clues, features.emptyAfter, features.contradiction ? ", contradiction found" : "");
+	printf("Candidate entropy: %.1f bits (bucket %d)\n", features.entropy, bucket);
+	for(i = 0; i < NUM_MEASURED; i++){
+		pthread_mutex_lock(&timingLock);
+		timing = timings[N][bucket][measuredEngines[i]];
+		pthread_mutex_unlock(&timingLock);
+		if(timing.count > 0)
+			printf("Measured %-9s %.3g s over %ld boards\n", engineName(measuredEngines[i]), exp(timing.logSum / timing.count), timing.count);
+	}
+	engine = selectEngine(&features, reason);
+	if(game->engine != ENGINE_AUTO)
+		printf("The engine is set to %s, auto would pick %s: %s\n", engineName(game->engine), engineName(engine), reason);
+	else
+		printf("Picked %s: %s\n", engineName(engine), reason);
+}
@@ -0,0 +1,53 @@
+/* Header file of the selector module. Picks the engine that should answer a board fastest, from features that cost a
+ * single propagation pass: the geometry, the number of clues, the cells propagation leaves empty and the log2 of the
+ * number of candidate assignments left (the candidate entropy of the board).
+ * The built-in policy sends boards that propagation solves or nearly solves and small boards to the back-tracking, which
+ * answers them before the ILP has built its model, large boards to the SAT solver and the rest to the ILP.
+ * The solves of the auto engine are timed. While a timing log is open the solves of a fixed engine and the winner of
+ * every portfolio race are timed too, so a bucket gets the timings of every engine, and all of them are appended to the
+ * log. A feature bucket that has enough measured solves of two engines or more is answered by the measurements instead
+ * of the built-in policy.
+ * A line of the timing log is "n m clues emptyAfter entropy engine seconds", lines starting with # are comments.*/
+
+#ifndef SELECTOR_H_
+#define SELECTOR_H_
+#include "game.h"
+
+#define SELECT_REASON_LEN 160
+#define SELECT_SPACE_BUCKETS 16 /* buckets of the candidate entropy, by its log2 */
+#define SELECT_MIN_SAMPLES 3 /* measured solves an engine needs in a bucket before the measurements are trusted */
+#define SELECT_BACKTRACK_MAX_N 9 /* the built-in policy back-tracks every board up to this side */
+#define SELECT_BACKTRACK_MAX_ENTROPY 40.0 /* and larger boards up to this candidate entropy */
+
+typedef struct BoardFeatures{
+	int n;
+	int m;
+	int clues; /* the filled cells of the board */
+	int emptyAfter; /* the empty cells after propagation */
+	double entropy; /* the sum of log2 of the number of candidates of the empty cells after propagation */
+	int contradiction; /* 1 if the givens clash or propagation left a cell or a value with no place: no solution */
+}BoardFeatures;
+
+/* computes the features of the board of the game. returns 1 on success and 0 on an error */
+int extractFeatures(Game *game, BoardFeatures *features);
+
+/* the engine (ENGINE_BACKTRACK, ENGINE_ILP or ENGINE_SAT) predicted to be fastest for a board with the features.
+ * reason (SELECT_REASON_LEN chars, may be NULL) gets why it was picked */
+int selectEngine(const BoardFeatures *features, char *reason);
+
+/* loads the timings of the log at path and appends the timings of this session to it. the file is created if needed.
+ * returns 1 on success, 0 on failure (a message is printed and the built-in policy is used) */
+int openTimingLog(const char *path);
+
+void closeTimingLog();
+
+/* returns 1 if a timing log is open */
+int timingLogOpen();
+
+/* records that engine answered a board with the features in seconds */
+void recordTiming(const BoardFeatures *features, int engine, double seconds);
+
+/* prints the features of the board of the game, the measured timings of its bucket and the engine the selector picks */
+void explainSelection(Game *game);
+
+#endif /* SELECTOR_H_ */
@@ -0,0 +1,700 @@
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include "server.h"
+#include "protocol.h"
+#include "game.h"
+#include "solver.h"
+#include "results.h"
+#include "catalogue.h"
+
+/* Server Module
+ * the main thread owns the sockets: it accepts clients, reads their frames into requests, and writes the
+ * responses the workers leave in the output buffers of the connections. it sleeps in epoll on the listening
+ * socket, the clients, an eventfd the workers use to wake it, and a signalfd for SIGINT/SIGTERM.
+ * the workers take requests from one FIFO queue. a worker takes the first request and then up to SERVE_BATCH-1
+ * more of the same geometry, and answers them one after the other on the same warm board.
+ * a connection is freed when it was closed by the main thread and no queued request or pending output refers to it.
+ */
+
+#define READ_CHUNK 4096
+#define MAX_EVENTS 64
+
+typedef struct Connection{
+	int fd;
+	pthread_mutex_t lock; /* protects the output buffer */
+	unsigned char *out; /* response frames not written yet, from outPos to outLen */
+	size_t outLen;
+	size_t outSize;
+	size_t outPos;
+	unsigned char *in; /* bytes read and not parsed yet (main thread only) */
+	size_t inLen;
+	size_t inSize;
+	int refs; /* the main thread while open, every queued request, and the dirty list - protected by the server lock */
+	int dirty; /* 1 while on the dirty list - protected by the server lock */
+	int watchingOut; /* 1 if epoll also waits for the socket to be writable (main thread only) */
+	int closed; /* main thread only */
+	struct Connection *nextDirty;
+	struct Connection *nextClosed;
+	struct Connection *prev; /* the list of open connections (main thread only) */
+	struct Connection *next;
+}Connection;
+
+typedef struct Request{
+	Connection *conn;
+	RequestHeader header;
+	unsigned char *grid;
+	size_t gridLen;
+	struct Request *next;
+}Request;
+
+/* a board of one geometry, kept by a worker between requests */
+typedef struct WarmGame{
+	Game *game;
+	int *solution; /* N*N values, the solution buffer of the geometry */
+	long lastUsed;
+}WarmGame;
+
+typedef struct Worker{
+	pthread_t thread;
+	WarmGame warm[SERVE_WARM_GAMES];
+	long uses;
+	SolveControl control; /* the control of the request the worker runs */
+	Rng rng; /* the warm games of the worker split their streams from it */
+}Worker;
+
+typedef struct Server{
+	pthread_mutex_t lock; /* protects the queue, the dirty list and the refs of the connections */
+	pthread_cond_t hasWork;
+	Request *head;
+	Request *tail;
+	Connection *dirty; /* connections with new output for the main thread to write */
+	volatile sig_atomic_t stopping;
+	int epollFd;
+	int wakeFd;
+	Connection *open;
+	Connection *closing; /* connections closed during the current round of events, released after it */
+	Worker *workers;
+	int numWorkers;
+}Server;
+
+static Server server;
+
+/* markers for the epoll events that don't belong to a client */
+static Connection listenTag, wakeTag, signalTag;
+
+/* drop one reference to the connection, the last one frees it. the server lock must not be held */
+static void releaseConnection(Connection *conn){
+	int refs;
+	pthread_mutex_lock(&server.lock);
+	refs = --conn->refs;
+	pthread_mutex_unlock(&server.lock);
+	if(refs > 0)
+		return;
+	pthread_mutex_destroy(&conn->lock);
+	free(conn->in);
+	free(conn->out);
+	free(conn);
+}
+
+/* make room for len more bytes in the buffer, returns 0 on a memory error */
+static int reserve(unsigned char **buf, size_t *size, size_t used, size_t len){
+	size_t newSize = *size > 0 ? *size : READ_CHUNK;
+	unsigned char *grown;
+	while(newSize < used + len)
+		newSize *= 2;
+	if(newSize == *size)
+		return 1;
+	grown = (unsigned char*) realloc(*buf, newSize);
+	if(grown == NULL)
+		return 0;
+	*buf = grown;
+	*size = newSize;
+	return 1;
+}
+
+/* ---------------------------------------- workers ---------------------------------------- */
+
+/* the board of geometry n x m of the worker, made (in place of the least recently used one) if the worker has none */
+static WarmGame* warmGame(Worker *worker, int n, int m){
+	int i, oldest = 0, N = n*m;
+	WarmGame *warm;
+	worker->uses++;
+	for(i = 0; i < SERVE_WARM_GAMES; i++){
+		warm = &worker->warm[i];
+		if(warm->game != NULL && warm->game->n == n && warm->game->m == m){
+			warm->lastUsed = worker->uses;
+			return warm;
+		}
+		if(warm->game == NULL || warm->lastUsed < worker->warm[oldest].lastUsed)
+			oldest = i;
+	}
+	warm = &worker->warm[oldest];
+	if(warm->game != NULL){
+		freeGame(warm->game);
+		free(warm->solution);
+	}
+	warm->game = (Game*) calloc(1, sizeof(Game));
+	warm->solution = (int*) calloc(N*N, sizeof(int));
+	if(warm->game == NULL || warm->solution == NULL){
+		free(warm->game);
+		free(warm->solution);
+		warm->game = NULL;
+		warm->solution = NULL;
+		return NULL;
+	}
+	warm->game->n = n;
+	warm->game->m = m;
+	warm->game->board = createBoard(warm->game);
+	rngSplit(&worker->rng, &warm->game->rng);
+	warm->lastUsed = worker->uses;
+	return warm;
+}
+
+/* put the board of the request in the game, returns 0 if it has an illegal value */
+static int loadRequestBoard(Game *game, unsigned char *grid){
+	int row, col, N = game->n*game->m, filled = 0;
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			if(grid[row*N + col] > N)
+				return 0;
+			game->board[row][col].value = grid[row*N + col];
+			game->board[row][col].fixed = 0;
+			if(grid[row*N + col] != 0)
+				filled++;
+		}
+	}
+	game->numOfFilledCells = filled;
+	return 1;
+}
+
+/* count the solutions of the board, reusing the count of an isomorphic board. returns the status of the response */
+static int countBoard(Game *game, SolveControl *control, int64_t *value){
+	BoardKey key;
+	long count = 0;
+	int exact, res, haveKey;
+	double start = monotonicSeconds();
+	if(hasCatalogue(game->n, game->m)){
+		res = catalogueCount(game, &count);
+		*value = count;
+		return res == 1 ? STATUS_OK : STATUS_ERROR;
+	}
+	haveKey = makeBoardKey(game, &key, control);
+	if(haveKey && lookupCount(&key, &count, &exact) && exact){
+		freeBoardKey(&key);
+		*value = count;
+		return STATUS_OK;
+	}
+	res = countSolutions(game, control, &count);
+	if(res == 1 && haveKey)
+		storeCount(&key, count, 1, "backtrack", monotonicSeconds() - start);
+	if(haveKey)
+		freeBoardKey(&key);
+	*value = count;
+	if(res == 1)
+		return STATUS_OK;
+	return res == 0 ? STATUS_STOPPED : STATUS_ERROR;
+}
+
+/* answer the request, the board of the response (if any) is put in grid */
+static void handleRequest(Worker *worker, Request *request, ResponseHeader *response, unsigned char *grid){
+	RequestHeader *header = &request->header;
+	int n = header->n, m = header->m, N = n*m, i, solved;
+	WarmGame *warm;
+	Game *game;
+	response->id = header->id;
+	response->status = STATUS_OK;
+	response->n = header->n;
+	response->m = header->m;
+	response->hasGrid = 0;
+	response->value = 0;
+	if(n == 0 || m == 0 || N > PROTOCOL_MAX_N || request->gridLen != (size_t)(N*N) || header->op < OP_SOLVE || header->op > OP_GENERATE){
+		response->status = STATUS_BAD_REQUEST;
+		return;
+	}
+	warm = warmGame(worker, n, m);
+	if(warm == NULL){
+		response->status = STATUS_ERROR;
+		return;
+	}
+	game = warm->game;
+	if(!loadRequestBoard(game, request->grid)){
+		response->status = STATUS_BAD_REQUEST;
+		return;
+	}
+	initControl(&worker->control, header->timeoutMs > 0 ? header->timeoutMs/1000.0 : SERVE_DEFAULT_TIMEOUT);
+	if(server.stopping)
+		worker->control.cancelled = 1;
+	if(header->op == OP_GENERATE){
+		generate(game, header->args[0], header->args[1], &worker->control);
+		for(i = 0; i < N*N; i++)
+			grid[i] = (unsigned char) game->board[i/N][i%N].value;
+		response->hasGrid = 1;
+		return;
+	}
+	if(isErrorneous(game)){
+		response->status = STATUS_ERRONEOUS;
+		return;
+	}
+	if(header->op == OP_COUNT){
+		response->status = countBoard(game, &worker->control, &response->value);
+		return;
+	}
+	if(header->op == OP_HINT && (header->args[0] < 0 || header->args[0] >= N || header->args[1] < 0 || header->args[1] >= N
+			|| game->board[header->args[0]][header->args[1]].value != 0)){
+		response->status = STATUS_BAD_REQUEST;
+		return;
+	}
+	solved = solveGame(game, &worker->control, warm->solution);
+	if(solved == 2)
+		response->status = STATUS_STOPPED;
+	else if(solved == -1)
+		response->status = STATUS_ERROR;
+	else if(header->op == OP_VALIDATE)
+		response->value = solved;/* an unsolvable board is a valid answer to validate */
+	else if(solved == 0)
+		response->status = STATUS_UNSOLVABLE;
+	else if(header->op == OP_HINT)
+		response->value = warm->solution[header->args[0]*N + header->args[1]];
+	else{
+		for(i = 0; i < N*N; i++)
+			grid[i] = (unsigned char) warm->solution[i];
+		response->hasGrid = 1;
+	}
+}
+
+/* add the response frame to the output of the connection and tell the main thread about it */
+static void reply(Connection *conn, ResponseHeader *response, unsigned char *grid){
+	uint32_t len = sizeof(ResponseHeader);
+	size_t gridLen = response->hasGrid ? (size_t)(response->n*response->m)*(response->n*response->m) : 0;
+	int wake = 0;
+	uint64_t one = 1;
+	len += gridLen;
+	pthread_mutex_lock(&conn->lock);
+	if(reserve(&conn->out, &conn->outSize, conn->outLen, sizeof(len) + len)){
+		memcpy(conn->out + conn->outLen, &len, sizeof(len));
+		memcpy(conn->out + conn->outLen + sizeof(len), response, sizeof(ResponseHeader));
+		memcpy(conn->out + conn->outLen + sizeof(len) + sizeof(ResponseHeader), grid, gridLen);
+		conn->outLen += sizeof(len) + len;
+	}
+	pthread_mutex_unlock(&conn->lock);
+	pthread_mutex_lock(&server.lock);
+	if(!conn->dirty){
+		conn->dirty = 1;
+		conn->refs++;
+		conn->nextDirty = server.dirty;
+		server.dirty = conn;
+		wake = 1;
+	}
+	pthread_mutex_unlock(&server.lock);
+	if(wake && write(server.wakeFd, &one, sizeof(one)) < 0)
+		perror("Error: could not wake the server");
+}
+
+static void* workerThread(void *arg){
+	Worker *worker = (Worker*)arg;
+	Request *batch, *last, *request, **link;
+	ResponseHeader response;
+	unsigned char grid[PROTOCOL_MAX_N*PROTOCOL_MAX_N];
+	int taken, i;
+	for(;;){
+		/* take the first request and more of the same geometry */
+		pthread_mutex_lock(&server.lock);
+		while(server.head == NULL && !server.stopping)
+			pthread_cond_wait(&server.hasWork, &server.lock);
+		if(server.stopping){
+			pthread_mutex_unlock(&server.lock);
+			break;
+		}
+		batch = last = server.head;
+		server.head = batch->next;
+		taken = 1;
+		link = &server.head;
+		while(*link != NULL && taken < SERVE_BATCH){
+			request = *link;
+			if(request->header.n == batch->header.n && request->header.m == batch->header.m){
+				*link = request->next;
+				last->next = request;
+				last = request;
+				taken++;
+			}
+			else
+				link = &request->next;
+		}
+		last->next = NULL;
+		/* the tail may have been taken */
+		server.tail = NULL;
+		for(request = server.head; request != NULL; request = request->next)
+			server.tail = request;
+		pthread_mutex_unlock(&server.lock);
+		while(batch != NULL){
+			request = batch;
+			batch = batch->next;
+			handleRequest(worker, request, &response, grid);
+			reply(request->conn, &response, grid);
+			releaseConnection(request->conn);
+			free(request->grid);
+			free(request);
+		}
+	}
+	for(i = 0; i < SERVE_WARM_GAMES; i++){
+		if(worker->warm[i].game != NULL){
+			freeGame(worker->warm[i].game);
+			free(worker->warm[i].solution);
+		}
+	}
+	return NULL;
+}
+
+/* ---------------------------------------- main thread ---------------------------------------- */
+
+static void closeConnection(Connection *conn){
+	if(conn->closed)
+		return;
+	conn->closed = 1;
+	epoll_ctl(server.epollFd, EPOLL_CTL_DEL, conn->fd, NULL);
+	close(conn->fd);
+	if(conn->prev != NULL)
+		conn->prev->next = conn->next;
+	else
+		server.open = conn->next;
+	if(conn->next != NULL)
+		conn->next->prev = conn->prev;
+	conn->nextClosed = server.closing;
+	server.closing = conn;
+}
+
+/* write as much of the output of the connection as the socket takes, and wait for it to be writable if some is left */
+static void writeClient(Connection *conn){
+	ssize_t w;
+	int pending, failed = 0;
+	struct epoll_event event;
+	pthread_mutex_lock(&conn->lock);
+	while(conn->outPos < conn->outLen){
+		w = send(conn->fd, conn->out + conn->outPos, conn->outLen - conn->outPos, MSG_NOSIGNAL);
+		if(w > 0)
+			conn->outPos += w;
+		else if(w < 0 && errno == EINTR)
+			continue;
+		else{
+			failed = !(w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+			break;
+		}
+	}
+	if(conn->outPos == conn->outLen)
+		conn->outPos = conn->outLen = 0;
+	pending = conn->outLen > 0;
+	pthread_mutex_unlock(&conn->lock);
+	if(failed){
+		closeConnection(conn);
+		return;
+	}
+	if(pending != conn->watchingOut){
+		event.events = EPOLLIN | (pending ? EPOLLOUT : 0);
+		event.data.ptr = conn;
+		epoll_ctl(server.epollFd, EPOLL_CTL_MOD, conn->fd, &event);
+		conn->watchingOut = pending;
+	}
+}
+
+/* write the output the workers left since the last wake up */
+static void flushDirty(){
+	Connection *conn, *next;
+	uint64_t count;
+	if(read(server.wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		perror("Error: could not read the wake up counter");
+	pthread_mutex_lock(&server.lock);
+	conn = server.dirty;
+	server.dirty = NULL;
+	for(next = conn; next != NULL; next = next->nextDirty)
+		next->dirty = 0;
+	pthread_mutex_unlock(&server.lock);
+	while(conn != NULL){
+		next = conn->nextDirty;
+		if(!conn->closed)
+			writeClient(conn);
+		releaseConnection(conn);
+		conn = next;
+	}
+}
+
+/* cut the complete frames in the input of the connection into requests and queue them all at once.
+ * returns 0 if the client sent a frame no request can fit in */
+static int parseRequests(Connection *conn){
+	size_t pos = 0;
+	uint32_t len;
+	Request *first = NULL, *last = NULL, *request;
+	int count = 0, ok = 1;
+	while(conn->inLen - pos >= sizeof(len)){
+		memcpy(&len, conn->in + pos, sizeof(len));
+		if(len < sizeof(RequestHeader) || len > PROTOCOL_MAX_FRAME){
+			ok = 0;
+			break;
+		}
+		if(conn->inLen - pos - sizeof(len) < len)
+			break;
+		request = (Request*) calloc(1, sizeof(Request));
+		if(request != NULL){
+			request->gridLen = len - sizeof(RequestHeader);
+			request->grid = (unsigned char*) malloc(request->gridLen + 1);
+		}
+		if(request == NULL || request->grid == NULL){
+			free(request);
+			ok = 0;
+			break;
+		}
+		memcpy(&request->header, conn->in + pos + sizeof(len), sizeof(RequestHeader));
+		memcpy(request->grid, conn->in + pos + sizeof(len) + sizeof(RequestHeader), request->gridLen);
+		request->conn = conn;
+		if(last != NULL)
+			last->next = request;
+		else
+			first = request;
+		last = request;
+		count++;
+		pos += sizeof(len) + len;
+	}
+	memmove(conn->in, conn->in + pos, conn->inLen - pos);
+	conn->inLen -= pos;
+	if(count > 0){
+		pthread_mutex_lock(&server.lock);
+		conn->refs += count;
+		if(server.tail != NULL)
+			server.tail->next = first;
+		else
+			server.head = first;
+		server.tail = last;
+		if(count > 1)
+			pthread_cond_broadcast(&server.hasWork);
+		else
+			pthread_cond_signal(&server.hasWork);
+		pthread_mutex_unlock(&server.lock);
+	}
+	return ok;
+}
+
+static void readClient(Connection *conn){
+	ssize_t r;
+	for(;;){
+		if(!reserve(&conn->in, &conn->inSize, conn->inLen, READ_CHUNK)){
+			closeConnection(conn);
+			return;
+		}
+		r = read(conn->fd, conn->in + conn->inLen, conn->inSize - conn->inLen);
+		if(r > 0){
+			conn->inLen += r;
+			if(!parseRequests(conn)){
+				closeConnection(conn);
+				return;
+			}
+		}
+		else if(r < 0 && errno == EINTR)
+			continue;
+		else if(r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		else{/* the client closed the connection or it failed */
+			closeConnection(conn);
+			return;
+		}
+	}
+}
+
+static void acceptClients(int listenFd){
+	int fd;
+	Connection *conn;
+	struct epoll_event event;
+	for(;;){
+		fd = accept(listenFd, NULL, NULL);
+		if(fd < 0){
+			if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				perror("Error: accept failed");
+			if(errno == EINTR)
+				continue;
+			return;
+		}
+		conn = (Connection*) calloc(1, sizeof(Connection));
+		if(conn == NULL || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0){
+			free(conn);
+			close(fd);
+			continue;
+		}
+		conn->fd = fd;
+		conn->refs = 1;
+		pthread_mutex_init(&conn->lock, NULL);
+		event.events = EPOLLIN;
+		event.data.ptr = conn;
+		if(epoll_ctl(server.epollFd, EPOLL_CTL_ADD, fd, &event) < 0){
+			pthread_mutex_destroy(&conn->lock);
+			free(conn);
+			close(fd);
+			continue;
+		}
+		conn->next = server.open;
+		if(server.open != NULL)
+			server.open->prev = conn;
+		server.open = conn;
+	}
+}
+
+/* release the connections closed in the last round of events */
+static void releaseClosed(){
+	Connection *conn;
+	while(server.closing != NULL){
+		conn = server.closing;
+		server.closing = conn->nextClosed;
+		releaseConnection(conn);
+	}
+}
+
+/* the listening socket at socketPath, or -1 */
+static int openListener(const char *socketPath){
+	int fd;
+	struct sockaddr_un address;
+	if(strlen(socketPath) >= sizeof(address.sun_path)){
+		printf("Error: socket path is too long\n");
+		return -1;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0){
+		perror("Error: socket failed");
+		return -1;
+	}
+	unlink(socketPath);/* a socket left by a daemon that didn't shut down cleanly */
+	if(bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0
+			|| fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0){
+		perror("Error: could not listen on the socket");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int watch(int fd, void *tag){
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = tag;
+	return epoll_ctl(server.epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+int serve(const char *socketPath){
+	int listenFd, signalFd, i, count, running = 1;
+	long processors;
+	sigset_t signals;
+	struct signalfd_siginfo received;
+	struct epoll_event events[MAX_EVENTS];
+	Connection *conn;
+	Request *request;
+	Rng root;
+	memset(&server, 0, sizeof(server));
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_cond_init(&server.hasWork, NULL);
+	/* SIGINT and SIGTERM are read from a signalfd, the workers inherit the blocked mask */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	listenFd = openListener(socketPath);
+	if(listenFd < 0)
+		return 1;
+	signalFd = signalfd(-1, &signals, 0);
+	server.wakeFd = eventfd(0, EFD_NONBLOCK);
+	server.epollFd = epoll_create1(0);
+	if(signalFd < 0 || server.wakeFd < 0 || server.epollFd < 0 || watch(listenFd, &listenTag) < 0
+			|| watch(server.wakeFd, &wakeTag) < 0 || watch(signalFd, &signalTag) < 0){
+		perror("Error: could not set up the server");
+		close(listenFd);
+		unlink(socketPath);
+		return 1;
+	}
+	processors = sysconf(_SC_NPROCESSORS_ONLN);
+	server.numWorkers = processors < 1 ? 1 : (processors > SERVE_MAX_WORKERS ? SERVE_MAX_WORKERS : (int)processors);
+	server.workers = (Worker*) calloc(server.numWorkers, sizeof(Worker));
+	if(server.workers == NULL){
+		printf("Error: calloc has failed\n");
+		close(listenFd);
+		unlink(socketPath);
+		return 1;
+	}
+	/* every worker gets its own stream, so generate requests on different workers don't share one */
+	rngSeed(&root, sessionSeed());
+	for(i = 0; i < server.numWorkers; i++){
+		rngSplit(&root, &server.workers[i].rng);
+		if(pthread_create(&server.workers[i].thread, NULL, workerThread, &server.workers[i]) != 0){
+			printf("Error: could not start a worker thread\n");
+			server.numWorkers = i;
+			break;
+		}
+	}
+	printf("Serving on %s with %d workers\n", socketPath, server.numWorkers);
+	while(running && server.numWorkers > 0){
+		count = epoll_wait(server.epollFd, events, MAX_EVENTS, -1);
+		if(count < 0 && errno != EINTR){
+			perror("Error: epoll_wait failed");
+			break;
+		}
+		for(i = 0; i < count; i++){
+			if(events[i].data.ptr == &listenTag)
+				acceptClients(listenFd);
+			else if(events[i].data.ptr == &wakeTag)
+				flushDirty();
+			else if(events[i].data.ptr == &signalTag){
+				if(read(signalFd, &received, sizeof(received)) < 0)
+					perror("Error: could not read the signal");
+				running = 0;
+			}
+			else{
+				conn = (Connection*)events[i].data.ptr;
+				if(!conn->closed && (events[i].events & EPOLLOUT))
+					writeClient(conn);
+				if(!conn->closed && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+					readClient(conn);
+			}
+		}
+		releaseClosed();
+	}
+	/* stop the workers, cancelling the requests they run */
+	pthread_mutex_lock(&server.lock);
+	server.stopping = 1;
+	for(i = 0; i < server.numWorkers; i++)
+		server.workers[i].control.cancelled = 1;
+	pthread_cond_broadcast(&server.hasWork);
+	pthread_mutex_unlock(&server.lock);
+	for(i = 0; i < server.numWorkers; i++)
+		pthread_join(server.workers[i].thread, NULL);
+	while(server.head != NULL){
+		request = server.head;
+		server.head = request->next;
+		releaseConnection(request->conn);
+		free(request->grid);
+		free(request);
+	}
+	server.tail = NULL;
+	/* the last responses are written best effort before the connections close */
+	flushDirty();
+	while(server.open != NULL)
+		closeConnection(server.open);
+	releaseClosed();
+	close(listenFd);
+	close(signalFd);
+	close(server.wakeFd);
+	close(server.epollFd);
+	unlink(socketPath);
+	free(server.workers);
+	pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+	printf("Server stopped\n");
+	return 0;
+}
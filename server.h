@@ -0,0 +1,19 @@
+/* Header file of the server module. With --serve <socket> the program runs as a local solver daemon instead of the
+ * interactive game: it listens on a Unix domain socket and answers solve, validate, hint, count and generate requests
+ * in the framed protocol of protocol.h, so callers pay the process startup and board allocation only once.
+ * A pool of worker threads (one per processor) takes the queued requests in batches of the same geometry, and every
+ * worker keeps its boards of the last geometries it served. Solutions are shared through the results module.*/
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#define SERVE_BATCH 16 /* most requests a worker takes from the queue at once */
+#define SERVE_WARM_GAMES 8 /* boards (of different geometries) every worker keeps */
+#define SERVE_DEFAULT_TIMEOUT 10.0 /* seconds a request may run when it asks for no time budget */
+#define SERVE_MAX_WORKERS 64
+
+/* serve requests on the socket at socketPath until SIGINT or SIGTERM, then remove the socket.
+ * returns 0 after a clean shutdown and 1 if the socket couldn't be set up */
+int serve(const char *socketPath);
+
+#endif /* SERVER_H_ */
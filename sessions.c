@@ -0,0 +1,477 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include "sessions.h"
+#include "game.h"
+#include "worker.h"
+#include "pool.h"
+#include "rng.h"
+#include "control.h"
+
+/* Sessions Module
+ * the sessions are in a hash table by id, chained, that doubles when it holds more sessions than buckets. the live
+ * sessions are also on a list from the least to the most recently used, eviction takes them from its head.
+ * the sessions themselves come from a pool of the host, like the boards and the moves of their games.
+ * a snapshot is, numbers in little endian:
+ * version, n, m, mode, markErrors and engine (a byte each), searchOptions (4 bytes), timeout in milliseconds (4),
+ * the random stream (4 times 8), the moves of the history and the moves of it applied (4 each), flags (a byte),
+ * a byte per cell row by row: the value, or'ed with SNAPSHOT_FIXED if the cell is fixed,
+ * with SNAPSHOT_SAVED_VALUES a byte per cell with its saved value,
+ * 4 bytes per move of the history from the first: row (or'ed with SNAPSHOT_CHAINED), col, value and prevValue.
+ * the history is kept whole, the undone moves too, so redo works after an eviction.
+ */
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_BYTES 55
+#define SNAPSHOT_SAVED_VALUES 1 /* flag: the cells have saved values */
+#define SNAPSHOT_FIXED 0x80
+#define SNAPSHOT_CHAINED 0x80
+#define SESSION_FIRST_BUCKETS 64
+
+typedef struct Session{
+	uint64_t id;
+	Game *game; /* NULL while the session is evicted */
+	unsigned char *snapshot; /* the packed game while the session is evicted */
+	size_t snapshotLength;
+	double lastUsed;
+	Job job;
+	struct Session *next; /* the next session of the bucket */
+	struct Session *older; /* the list of the live sessions */
+	struct Session *newer;
+}Session;
+
+struct SessionHost{
+	Session **buckets;
+	int numBuckets; /* a power of 2 */
+	int numSessions;
+	int numLive;
+	int maxLive;
+	double idleSeconds;
+	Session *oldest;
+	Session *newest;
+	Pool sessions;
+	GamePools pools;
+	size_t snapshotBytes;
+};
+
+static unsigned char* put32(unsigned char *p, uint32_t value){
+	int i;
+	for(i = 0; i < 4; i++)
+		*p++ = (unsigned char)(value >> 8*i);
+	return p;
+}
+
+static unsigned char* put64(unsigned char *p, uint64_t value){
+	int i;
+	for(i = 0; i < 8; i++)
+		*p++ = (unsigned char)(value >> 8*i);
+	return p;
+}
+
+static uint32_t get32(const unsigned char **p){
+	uint32_t value = 0;
+	int i;
+	for(i = 0; i < 4; i++)
+		value |= (uint32_t)*(*p)++ << 8*i;
+	return value;
+}
+
+static uint64_t get64(const unsigned char **p){
+	uint64_t value = 0;
+	int i;
+	for(i = 0; i < 8; i++)
+		value |= (uint64_t)*(*p)++ << 8*i;
+	return value;
+}
+
+/* packs the game into a new snapshot in *out. returns its length, or 0 if the game can't be packed */
+static size_t packGame(Game *game, unsigned char **out){
+	int N = game->n*game->m, cell, i, saved = 0;
+	uint32_t numMoves = 0, applied = 0;
+	Move *move;
+	unsigned char *snapshot, *p;
+	size_t length;
+	if(N <= 0 || N >= SNAPSHOT_FIXED)
+		return 0;
+	for(move = game->currentMove; move != NULL; move = move->lastMove)
+		applied++;
+	for(move = game->firstMove; move != NULL; move = move->nextMove)
+		numMoves++;
+	for(cell = 0; cell < N*N; cell++){
+		if(game->board[cell/N][cell%N].savedValue != 0)
+			saved = 1;
+	}
+	length = SNAPSHOT_HEADER_BYTES + (size_t)N*N*(saved ? 2 : 1) + 4*(size_t)numMoves;
+	snapshot = (unsigned char*)malloc(length);
+	if(snapshot == NULL)
+		return 0;
+	p = snapshot;
+	*p++ = SNAPSHOT_VERSION;
+	*p++ = (unsigned char)game->n;
+	*p++ = (unsigned char)game->m;
+	*p++ = (unsigned char)game->mode;
+	*p++ = (unsigned char)game->markErrors;
+	*p++ = (unsigned char)game->engine;
+	p = put32(p, (uint32_t)game->searchOptions);
+	p = put32(p, (uint32_t)(game->timeout*1000));
+	for(i = 0; i < 4; i++)
+		p = put64(p, game->rng.s[i]);
+	p = put32(p, numMoves);
+	p = put32(p, applied);
+	*p++ = saved ? SNAPSHOT_SAVED_VALUES : 0;
+	for(cell = 0; cell < N*N; cell++)
+		*p++ = (unsigned char)(game->board[cell/N][cell%N].value | (game->board[cell/N][cell%N].fixed ? SNAPSHOT_FIXED : 0));
+	for(cell = 0; saved && cell < N*N; cell++)
+		*p++ = (unsigned char)game->board[cell/N][cell%N].savedValue;
+	for(move = game->firstMove; move != NULL; move = move->nextMove){
+		*p++ = (unsigned char)(move->row | (move->chained ? SNAPSHOT_CHAINED : 0));
+		*p++ = (unsigned char)move->col;
+		*p++ = (unsigned char)move->value;
+		*p++ = (unsigned char)move->prevValue;
+	}
+	*out = snapshot;
+	return length;
+}
+
+/* frees a game that unpackGame was making, the moves from last back */
+static void discardGame(Game *game, Move *last){
+	Move *move;
+	while(last != NULL){
+		move = last->lastMove;
+		releaseMove(game->pools, last);
+		last = move;
+	}
+	if(game->board != NULL)
+		releaseBoard(game->pools, game->board, game->n, game->m);
+	free(game);
+}
+
+/* a game with the board and the moves from the pools of the host, unpacked from the snapshot. NULL if the snapshot
+ * is damaged or on a memory error */
+static Game* unpackGame(SessionHost *host, const unsigned char *snapshot, size_t length){
+	const unsigned char *p = snapshot;
+	Game *game;
+	Move *move, *last = NULL;
+	uint32_t numMoves, applied, i;
+	int N, cell, flags;
+	if(length < SNAPSHOT_HEADER_BYTES || p[0] != SNAPSHOT_VERSION)
+		return NULL;
+	game = (Game*)calloc(1, sizeof(Game));
+	if(game == NULL)
+		return NULL;
+	p++;
+	game->pools = &host->pools;
+	game->n = *p++;
+	game->m = *p++;
+	game->mode = *p++;
+	game->markErrors = *p++;
+	game->engine = *p++;
+	game->searchOptions = (int)get32(&p);
+	game->timeout = get32(&p)/1000.0;
+	for(i = 0; i < 4; i++)
+		game->rng.s[i] = get64(&p);
+	numMoves = get32(&p);
+	applied = get32(&p);
+	flags = *p++;
+	N = game->n*game->m;
+	if(N <= 0 || N >= SNAPSHOT_FIXED || applied > numMoves
+			|| length != SNAPSHOT_HEADER_BYTES + (size_t)N*N*((flags & SNAPSHOT_SAVED_VALUES) ? 2 : 1) + 4*(size_t)numMoves){
+		free(game);
+		return NULL;
+	}
+	game->board = allocBoard(game->pools, game->n, game->m);
+	if(game->board == NULL){
+		free(game);
+		return NULL;
+	}
+	for(cell = 0; cell < N*N; cell++, p++){
+		game->board[cell/N][cell%N].value = *p & ~SNAPSHOT_FIXED;
+		game->board[cell/N][cell%N].fixed = (*p & SNAPSHOT_FIXED) != 0;
+		if(game->board[cell/N][cell%N].value != 0)
+			game->numOfFilledCells++;
+	}
+	for(cell = 0; (flags & SNAPSHOT_SAVED_VALUES) && cell < N*N; cell++)
+		game->board[cell/N][cell%N].savedValue = *p++;
+	for(i = 0; i < numMoves; i++){
+		move = allocMove(game->pools);
+		if(move == NULL){
+			discardGame(game, last);
+			return NULL;
+		}
+		move->chained = (p[0] & SNAPSHOT_CHAINED) != 0;
+		move->row = p[0] & ~SNAPSHOT_CHAINED;
+		move->col = p[1];
+		move->value = p[2];
+		move->prevValue = p[3];
+		p += 4;
+		move->lastMove = last;
+		if(last != NULL)
+			last->nextMove = move;
+		else
+			game->firstMove = move;
+		last = move;
+		if(i+1 == applied)
+			game->currentMove = move;
+	}
+	return game;
+}
+
+static Session** bucketOf(SessionHost *host, uint64_t id){
+	/* Fibonacci hashing, the high half of the product picks the bucket */
+	uint64_t hash = id*0x9E3779B97F4A7C15ull;
+	return &host->buckets[(hash >> 32) & (uint64_t)(host->numBuckets-1)];
+}
+
+static Session* findSession(SessionHost *host, uint64_t id){
+	Session *session;
+	for(session = *bucketOf(host, id); session != NULL; session = session->next){
+		if(session->id == id)
+			return session;
+	}
+	return NULL;
+}
+
+/* doubles the buckets of the table, returns 0 on a memory error (the table stays as it was) */
+static int growTable(SessionHost *host){
+	Session **old = host->buckets, *session, *next, **bucket;
+	int numOld = host->numBuckets, i;
+	host->buckets = (Session**)calloc(2*numOld, sizeof(Session*));
+	if(host->buckets == NULL){
+		host->buckets = old;
+		return 0;
+	}
+	host->numBuckets = 2*numOld;
+	for(i = 0; i < numOld; i++){
+		for(session = old[i]; session != NULL; session = next){
+			next = session->next;
+			bucket = bucketOf(host, session->id);
+			session->next = *bucket;
+			*bucket = session;
+		}
+	}
+	free(old);
+	return 1;
+}
+
+static void unlinkLive(SessionHost *host, Session *session){
+	if(session->older != NULL)
+		session->older->newer = session->newer;
+	else
+		host->oldest = session->newer;
+	if(session->newer != NULL)
+		session->newer->older = session->older;
+	else
+		host->newest = session->older;
+	session->older = NULL;
+	session->newer = NULL;
+	host->numLive--;
+}
+
+static void linkNewest(SessionHost *host, Session *session){
+	session->older = host->newest;
+	session->newer = NULL;
+	if(host->newest != NULL)
+		host->newest->newer = session;
+	else
+		host->oldest = session;
+	host->newest = session;
+	host->numLive++;
+}
+
+/* packs the game of the session and frees it. returns 0 if the session can't be evicted now */
+static int evictSession(SessionHost *host, Session *session){
+	if(session->game == NULL || jobRunning(&session->job))
+		return 0;
+	waitJob(&session->job);
+	session->snapshotLength = packGame(session->game, &session->snapshot);
+	if(session->snapshotLength == 0)
+		return 0;
+	host->snapshotBytes += session->snapshotLength;
+	freeGame(session->game);
+	session->game = NULL;
+	unlinkLive(host, session);
+	return 1;
+}
+
+/* unpacks the game of an evicted session, returns 0 if it can't be */
+static int wakeSession(SessionHost *host, Session *session){
+	session->game = unpackGame(host, session->snapshot, session->snapshotLength);
+	if(session->game == NULL)
+		return 0;
+	host->snapshotBytes -= session->snapshotLength;
+	free(session->snapshot);
+	session->snapshot = NULL;
+	session->snapshotLength = 0;
+	linkNewest(host, session);
+	return 1;
+}
+
+/* a new session with an empty 9x9 game and no mode yet, like the interactive game starts with */
+static Session* addSession(SessionHost *host, uint64_t id){
+	Session *session, **bucket;
+	Game *game;
+	if(host->numSessions >= host->numBuckets && !growTable(host))
+		return NULL;
+	game = (Game*)calloc(1, sizeof(Game));
+	if(game == NULL)
+		return NULL;
+	game->pools = &host->pools;
+	game->n = 3;
+	game->m = 3;
+	game->markErrors = 1;
+	game->board = allocBoard(game->pools, game->n, game->m);
+	session = (Session*)poolAlloc(&host->sessions);
+	if(game->board == NULL || session == NULL){
+		discardGame(game, NULL);
+		poolFree(&host->sessions, session);
+		return NULL;
+	}
+	/* every session has a stream of its own that only depends on the seed and its id */
+	rngSeed(&game->rng, sessionSeed() ^ id*0x9E3779B97F4A7C15ull);
+	session->id = id;
+	session->game = game;
+	initJob(&session->job);
+	bucket = bucketOf(host, id);
+	session->next = *bucket;
+	*bucket = session;
+	host->numSessions++;
+	linkNewest(host, session);
+	return session;
+}
+
+/* ends the session, waiting for its background command */
+static void endSession(SessionHost *host, Session *session){
+	Session **link = bucketOf(host, session->id);
+	if(jobRunning(&session->job))
+		cancelJob(&session->job);
+	waitJob(&session->job);
+	if(session->game != NULL){
+		freeGame(session->game);
+		unlinkLive(host, session);
+	}
+	else{
+		host->snapshotBytes -= session->snapshotLength;
+		free(session->snapshot);
+	}
+	while(*link != session)
+		link = &(*link)->next;
+	*link = session->next;
+	host->numSessions--;
+	pthread_mutex_destroy(&session->job.lock);
+	poolFree(&host->sessions, session);
+}
+
+SessionHost* createSessionHost(int maxLive, double idleSeconds){
+	SessionHost *host = (SessionHost*)calloc(1, sizeof(SessionHost));
+	if(host == NULL)
+		return NULL;
+	host->buckets = (Session**)calloc(SESSION_FIRST_BUCKETS, sizeof(Session*));
+	if(host->buckets == NULL){
+		free(host);
+		return NULL;
+	}
+	host->numBuckets = SESSION_FIRST_BUCKETS;
+	host->maxLive = maxLive > 0 ? maxLive : 1;
+	host->idleSeconds = idleSeconds;
+	initPool(&host->sessions, sizeof(Session));
+	initGamePools(&host->pools);
+	return host;
+}
+
+void freeSessionHost(SessionHost *host){
+	int i;
+	if(host == NULL)
+		return;
+	for(i = 0; i < host->numBuckets; i++){
+		while(host->buckets[i] != NULL)
+			endSession(host, host->buckets[i]);
+	}
+	destroyGamePools(&host->pools);
+	destroyPool(&host->sessions);
+	free(host->buckets);
+	free(host);
+}
+
+int sessionCommand(SessionHost *host, uint64_t id, char *input){
+	Session *session = findSession(host, id), *next;
+	if(session == NULL){
+		session = addSession(host, id);
+		if(session == NULL){
+			printf("Error: could not start session %llu\n", (unsigned long long)id);
+			return -1;
+		}
+	}
+	else if(session->game == NULL){
+		if(!wakeSession(host, session)){
+			printf("Error: could not restore session %llu\n", (unsigned long long)id);
+			return -1;
+		}
+	}
+	else{
+		unlinkLive(host, session);
+		linkNewest(host, session);
+	}
+	session->lastUsed = monotonicSeconds();
+	if(executeCommand(session->game, &session->job, input)){
+		endSession(host, session);
+		return 1;
+	}
+	/* make room for the next games, the session that just ran stays */
+	for(session = host->oldest; session != NULL && session != host->newest && host->numLive > host->maxLive; session = next){
+		next = session->newer;
+		evictSession(host, session);
+	}
+	return 0;
+}
+
+void evictIdleSessions(SessionHost *host){
+	Session *session, *next;
+	double now = monotonicSeconds();
+	/* the list goes from the least recently used, the first session that isn't idle ends the idle ones */
+	for(session = host->oldest; session != NULL && now - session->lastUsed > host->idleSeconds; session = next){
+		next = session->newer;
+		evictSession(host, session);
+	}
+}
+
+void printSessionStats(SessionHost *host){
+	size_t poolBytesTotal = poolBytes(&host->pools.moves);
+	int i;
+	for(i = 0; i < host->pools.numBoardPools; i++)
+		poolBytesTotal += poolBytes(&host->pools.boards[i]);
+	printf("Sessions: %d (%d live, %d evicted)\n", host->numSessions, host->numLive, host->numSessions - host->numLive);
+	printf("Pools: %lu bytes of boards and moves, %lu bytes of sessions. Snapshots: %lu bytes\n",
+			(unsigned long)poolBytesTotal, (unsigned long)poolBytes(&host->sessions), (unsigned long)host->snapshotBytes);
+}
+
+int hostSessions(){
+	SessionHost *host = createSessionHost(SESSION_MAX_LIVE, SESSION_IDLE_SECONDS);
+	char input[1024], *command;
+	unsigned long long id;
+	if(host == NULL){
+		printf("Error: could not start the session host\n");
+		return 1;
+	}
+	while(fgets(input, sizeof(input), stdin) != NULL){
+		evictIdleSessions(host);
+		command = input;
+		while(isspace((unsigned char)*command))
+			command++;
+		if(*command == '\0')
+			continue;
+		if(strncmp(command, "sessions", 8) == 0 && (command[8] == '\0' || isspace((unsigned char)command[8]))){
+			printSessionStats(host);
+			continue;
+		}
+		if(!isdigit((unsigned char)*command)){
+			printf("Error: a command must start with its session id\n");
+			continue;
+		}
+		id = strtoull(command, &command, 10);
+		sessionCommand(host, (uint64_t)id, command);
+	}
+	freeSessionHost(host);
+	return 0;
+}
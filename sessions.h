@@ -0,0 +1,43 @@
+/* Header file of the sessions module. With --sessions the program hosts many independent games in one process instead of
+ * the single interactive game. Every input line is a session id followed by a command, and the command runs on the game
+ * of that session exactly as it would in the interactive game. A session starts with the first command of its id and
+ * ends with its exit command.
+ * Every session has its own game - board, undo/redo history, mark_errors, timeout, engine, search options, random stream
+ * and the solver caches of the game - and its own background job. The boards and the moves of the histories come from
+ * pools of the host (see pool.h).
+ * A session idle for longer than the idle time, or the least recently used one when more games than the live limit are
+ * in memory, is evicted: its game is packed into a compact binary snapshot (about a byte per cell and four per move)
+ * and freed, caches included. Its next command unpacks it. A session whose background command runs isn't evicted.
+ * The journal follows the one interactive game, it can't be used together with --sessions.*/
+
+#ifndef SESSIONS_H_
+#define SESSIONS_H_
+#include <stdint.h>
+
+#define SESSION_MAX_LIVE 256 /* games kept unpacked, the least recently used one is evicted beyond it */
+#define SESSION_IDLE_SECONDS 60.0 /* a session idle for this long is evicted */
+
+typedef struct SessionHost SessionHost;
+
+/* an empty host that keeps at most maxLive games unpacked and evicts sessions idle for idleSeconds.
+ * NULL on a memory error */
+SessionHost* createSessionHost(int maxLive, double idleSeconds);
+
+/* end all the sessions, waiting for their background commands, and free the host */
+void freeSessionHost(SessionHost *host);
+
+/* run the command line input on the game of session id, starting the session or unpacking its game if needed.
+ * returns 1 if the command ended the session, 0 if it didn't and -1 if the game couldn't be made or unpacked */
+int sessionCommand(SessionHost *host, uint64_t id, char *input);
+
+/* evict the sessions idle for longer than the idle time of the host */
+void evictIdleSessions(SessionHost *host);
+
+/* print the number of live and evicted sessions and the memory they take */
+void printSessionStats(SessionHost *host);
+
+/* read "<session id> <command>" lines from the standard input until EOF and route them to their sessions.
+ * a "sessions" line prints the statistics of the host. returns 0 at EOF and 1 if the host couldn't be made */
+int hostSessions();
+
+#endif /* SESSIONS_H_ */
@@ -0,0 +1,632 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "solCache.h"
+
+/* Solution Cache Module
+ * files: <path> is the log, <path>.idx the index and <path>.lock the lock the writers take
+ * (a separate file, because compaction replaces the log and the index).
+ * the log starts with a header holding a random generation, the index is valid only for the log with the same generation.
+ * a record is a RecordHeader (magic, payload length, payload checksum) followed by the payload: a RecordFixed,
+ * the canonical grid (one byte per cell) and, if known, the canonical solution (one byte per cell).
+ * logIndex slots hold the hash, a second independent hash of the grid and the offset of the newest record (plus 1, 0 is a free slot).
+ * threads: appendLock lets one thread of the process write at a time (the writer lock is per process). only a thread
+ * holding it changes the open files and the index mapping, and it takes the write side of cacheLock just for the swap;
+ * lookups take the read side, so they never wait for a write, a sync or a scan of the log.
+ */
+
+#define LOG_MAGIC "SDKCLOG1"
+#define INDEX_MAGIC "SDKCIDX1"
+#define RECORD_MAGIC 0x5344524BU
+#define FLAG_SOLUTION 1
+#define FLAG_COUNT 2
+#define FLAG_EXACT 4
+#define MAX_N 64
+#define MIN_INDEX_CAPACITY 1024
+
+typedef struct LogHeader{
+	char magic[8];
+	uint32_t generation;
+	uint32_t reserved;
+}LogHeader;
+
+typedef struct RecordHeader{
+	uint32_t magic;
+	uint32_t length; /* of the payload */
+	uint32_t checksum; /* of the payload */
+	uint32_t reserved;
+}RecordHeader;
+
+typedef struct RecordFixed{
+	uint64_t hash;
+	int64_t count;
+	double seconds;
+	uint16_t n;
+	uint16_t m;
+	uint8_t flags;
+	uint8_t reserved[3];
+	char engine[CACHE_ENGINE_LEN];
+}RecordFixed;
+
+typedef struct IndexHeader{
+	char magic[8];
+	uint32_t generation; /* of the log this index belongs to */
+	uint32_t capacity; /* number of slots, a power of 2 */
+	uint64_t count; /* number of used slots */
+	uint64_t logSize; /* the log is indexed up to here */
+}IndexHeader;
+
+typedef struct IndexSlot{
+	uint64_t hash;
+	uint64_t check;
+	uint64_t offset; /* offset of the record in the log plus 1, 0 for a free slot */
+}IndexSlot;
+
+#define MAX_PAYLOAD (sizeof(RecordFixed) + 2*MAX_N*MAX_N)
+
+static int cacheIsOpen = 0;
+static char logPath[1024];
+static char indexPath[1100];
+static char lockPath[1100];
+static long maxLogBytes;
+static int logFd = -1;
+static int indexFd = -1;
+static int lockFd = -1;
+static ino_t logInode;
+static ino_t indexInode; /* of the mapped index, a writer that grows the index replaces the file */
+static uint32_t logGeneration;
+static IndexHeader *logIndex = NULL; /* NULL while there is no index for the current log */
+static size_t indexBytes = 0;
+static pthread_mutex_t appendLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t cacheLock = PTHREAD_RWLOCK_INITIALIZER; /* the open files and the index mapping */
+
+static uint32_t payloadChecksum(const unsigned char *data, size_t length){
+	uint32_t sum = 2166136261U;
+	size_t i;
+	for(i = 0; i < length; i++)
+		sum = (sum ^ data[i]) * 16777619U;
+	return sum;
+}
+
+/* a second hash of the grid, independent of canonicalHash, so two boards in the same slot chain are told apart without reading the log */
+static uint64_t gridCheck(int n, int m, const int *canonical){
+	uint64_t check = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)n << 8) ^ (uint64_t)m;
+	int i, N = n*m;
+	for(i = 0; i < N*N; i++){
+		check ^= (uint64_t)canonical[i] + 0x9E3779B97F4A7C15ULL + (check << 6) + (check >> 2);
+	}
+	return check;
+}
+
+static IndexSlot* indexSlots(IndexHeader *header){
+	return (IndexSlot*)(header + 1);
+}
+
+static size_t indexFileSize(uint32_t capacity){
+	return sizeof(IndexHeader) + (size_t)capacity*sizeof(IndexSlot);
+}
+
+/* reads the record at offset into payload (MAX_PAYLOAD bytes). returns its total size in the log, or 0 if there is no valid record there */
+static size_t readRecord(int fd, uint64_t offset, unsigned char *payload){
+	RecordHeader header;
+	RecordFixed *fixed;
+	size_t cells;
+	if(pread(fd, &header, sizeof(header), (off_t)offset) != (ssize_t)sizeof(header))
+		return 0;
+	if(header.magic != RECORD_MAGIC || header.length < sizeof(RecordFixed) || header.length > MAX_PAYLOAD)
+		return 0;
+	if(pread(fd, payload, header.length, (off_t)(offset + sizeof(header))) != (ssize_t)header.length)
+		return 0;
+	if(payloadChecksum(payload, header.length) != header.checksum)
+		return 0;
+	fixed = (RecordFixed*)payload;
+	cells = (size_t)fixed->n*fixed->m*fixed->n*fixed->m;
+	if(fixed->n == 0 || fixed->m == 0 || (size_t)fixed->n*fixed->m > MAX_N
+			|| header.length != sizeof(RecordFixed) + cells*((fixed->flags & FLAG_SOLUTION) ? 2 : 1))
+		return 0;
+	return sizeof(header) + header.length;
+}
+
+/* points the slot of the board at offset. returns 1 if a new slot was taken, 0 if the board had one and -1 if the index
+ * is full (the board isn't indexed then) */
+static int indexInsert(IndexHeader *header, uint64_t hash, uint64_t check, uint64_t offset){
+	IndexSlot *slots = indexSlots(header);
+	uint32_t mask = header->capacity - 1, i, probes;
+	for(i = (uint32_t)hash & mask, probes = 0; probes < header->capacity; i = (i+1) & mask, probes++){
+		if(slots[i].offset == 0){
+			slots[i].hash = hash;
+			slots[i].check = check;
+			slots[i].offset = offset + 1;
+			header->count++;
+			return 1;
+		}
+		if(slots[i].hash == hash && slots[i].check == check){
+			slots[i].offset = offset + 1;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static uint64_t recordCheck(const unsigned char *payload){
+	const RecordFixed *fixed = (const RecordFixed*)payload;
+	int grid[MAX_N*MAX_N];
+	int i, cells = fixed->n*fixed->m*fixed->n*fixed->m;
+	for(i = 0; i < cells; i++)
+		grid[i] = payload[sizeof(RecordFixed) + i];
+	return gridCheck(fixed->n, fixed->m, grid);
+}
+
+static void unmapIndex(){
+	if(logIndex != NULL)
+		munmap(logIndex, indexBytes);
+	logIndex = NULL;
+	indexBytes = 0;
+}
+
+/* maps the index file, keeps it only if it belongs to the current log */
+static void mapIndex(){
+	struct stat st;
+	void *map;
+	unmapIndex();
+	if(fstat(indexFd, &st) != 0 || (size_t)st.st_size < sizeof(IndexHeader))
+		return;
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+	if(map == MAP_FAILED)
+		return;
+	logIndex = (IndexHeader*)map;
+	indexBytes = (size_t)st.st_size;
+	indexInode = st.st_ino;
+	if(memcmp(logIndex->magic, INDEX_MAGIC, 8) != 0 || logIndex->generation != logGeneration
+			|| indexFileSize(logIndex->capacity) != indexBytes || (logIndex->capacity & (logIndex->capacity-1)) != 0)
+		unmapIndex();
+}
+
+/* writes a new index of the log open as fd, with the given generation, to the file tmpPath (cutting a torn tail off the log).
+ * the index gets at least minCapacity slots and at least twice as many as the log has records, so it is at most half full.
+ * the caller holds the writer lock. returns the descriptor of the new index, or -1 */
+static int buildIndex(int logFile, uint32_t generation, uint32_t minCapacity, char *tmpPath){
+	unsigned char payload[MAX_PAYLOAD];
+	IndexHeader *header;
+	struct stat st;
+	uint64_t offset, numRecords = 0;
+	uint32_t capacity;
+	size_t size;
+	int fd, ok = 1;
+	/* every board has a record, so the records bound the boards the index will hold */
+	fstat(logFile, &st);
+	offset = sizeof(LogHeader);
+	while(offset < (uint64_t)st.st_size && (size = readRecord(logFile, offset, payload)) > 0){
+		numRecords++;
+		offset += size;
+	}
+	for(capacity = MIN_INDEX_CAPACITY; capacity < minCapacity || capacity < 2*numRecords; capacity *= 2){
+		if(capacity >= 0x80000000U)
+			return -1;
+	}
+	sprintf(tmpPath, "%s.%ld.tmp", indexPath, (long)getpid());
+	fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return -1;
+	if(ftruncate(fd, (off_t)indexFileSize(capacity)) != 0){
+		close(fd);
+		unlink(tmpPath);
+		return -1;
+	}
+	header = (IndexHeader*)mmap(NULL, indexFileSize(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if((void*)header == MAP_FAILED){
+		close(fd);
+		unlink(tmpPath);
+		return -1;
+	}
+	memcpy(header->magic, INDEX_MAGIC, 8);
+	header->generation = generation;
+	header->capacity = capacity;
+	header->count = 0;
+	fstat(logFile, &st);
+	offset = sizeof(LogHeader);
+	while(ok && offset < (uint64_t)st.st_size && (size = readRecord(logFile, offset, payload)) > 0){
+		ok = indexInsert(header, ((RecordFixed*)payload)->hash, recordCheck(payload), offset) >= 0;
+		offset += size;
+	}
+	/* whatever follows the last valid record was torn by a crash */
+	if(offset < (uint64_t)st.st_size && ftruncate(logFile, (off_t)offset) != 0)
+		offset = (uint64_t)st.st_size;
+	header->logSize = offset;
+	msync(header, indexFileSize(capacity), MS_SYNC);
+	munmap(header, indexFileSize(capacity));
+	if(!ok){
+		close(fd);
+		unlink(tmpPath);
+		return -1;
+	}
+	return fd;
+}
+
+/* puts the index built by buildIndex in place and maps it. the caller holds the write side of cacheLock */
+static int installIndex(int fd, const char *tmpPath){
+	if(rename(tmpPath, indexPath) != 0){
+		close(fd);
+		unlink(tmpPath);
+		return 0;
+	}
+	unmapIndex();
+	close(indexFd);
+	indexFd = fd;
+	mapIndex();
+	return logIndex != NULL;
+}
+
+/* writes a new index of the whole log and puts it in place. the caller holds appendLock and the writer lock, the log is
+ * read without cacheLock and only the swap of the index takes its write side */
+static int rebuildIndex(uint32_t minCapacity){
+	char tmpPath[1200];
+	int fd, ok;
+	fd = buildIndex(logFd, logGeneration, minCapacity, tmpPath);
+	if(fd < 0)
+		return 0;
+	pthread_rwlock_wrlock(&cacheLock);
+	ok = installIndex(fd, tmpPath);
+	pthread_rwlock_unlock(&cacheLock);
+	return ok;
+}
+
+/* indexes the records that were appended after the index was last updated (by a writer that crashed before it updated
+ * the index) and cuts the torn tail such a writer may have left. the caller holds appendLock and the writer lock.
+ * returns 0 if the index is full */
+static int indexNewRecords(){
+	unsigned char payload[MAX_PAYLOAD];
+	struct stat st;
+	uint64_t offset = logIndex->logSize;
+	size_t size;
+	fstat(logFd, &st);
+	while(offset < (uint64_t)st.st_size && (size = readRecord(logFd, offset, payload)) > 0){
+		if(indexInsert(logIndex, ((RecordFixed*)payload)->hash, recordCheck(payload), offset) < 0)
+			return 0;
+		offset += size;
+		logIndex->logSize = offset;
+	}
+	if(offset < (uint64_t)st.st_size && ftruncate(logFd, (off_t)offset) != 0)
+		offset = (uint64_t)st.st_size;
+	logIndex->logSize = offset;
+	return 1;
+}
+
+static void closeFiles(){
+	unmapIndex();
+	if(logFd >= 0)
+		close(logFd);
+	if(indexFd >= 0)
+		close(indexFd);
+	logFd = -1;
+	indexFd = -1;
+}
+
+/* opens the log (creating it with a fresh generation if it is empty) and maps its index. the caller holds appendLock
+ * and the write side of cacheLock. returns 1 on success */
+static int openFiles(){
+	char tmpPath[1200];
+	LogHeader header;
+	struct stat st;
+	int fd;
+	logFd = open(logPath, O_RDWR | O_CREAT, 0644);
+	indexFd = open(indexPath, O_RDWR | O_CREAT, 0644);
+	if(logFd < 0 || indexFd < 0){
+		closeFiles();
+		return 0;
+	}
+	if(fstat(logFd, &st) != 0){
+		closeFiles();
+		return 0;
+	}
+	if(st.st_size == 0){
+		flock(lockFd, LOCK_EX);
+		fstat(logFd, &st);
+		if(st.st_size == 0){
+			memcpy(header.magic, LOG_MAGIC, 8);
+			header.generation = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+			header.reserved = 0;
+			if(pwrite(logFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+				st.st_size = -1;
+			fdatasync(logFd);
+		}
+		flock(lockFd, LOCK_UN);
+	}
+	if(pread(logFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || memcmp(header.magic, LOG_MAGIC, 8) != 0){
+		printf("Error: %s is not a solution cache\n", logPath);
+		closeFiles();
+		return 0;
+	}
+	fstat(logFd, &st);
+	logInode = st.st_ino;
+	logGeneration = header.generation;
+	mapIndex();
+	if(logIndex == NULL){
+		flock(lockFd, LOCK_EX);
+		mapIndex();
+		if(logIndex == NULL && (fd = buildIndex(logFd, logGeneration, MIN_INDEX_CAPACITY, tmpPath)) >= 0)
+			installIndex(fd, tmpPath);
+		flock(lockFd, LOCK_UN);
+	}
+	return 1;
+}
+
+/* returns 1 if the open files are the ones of the cache. another process may have compacted it or rebuilt the index,
+ * which replaces them */
+static int filesCurrent(){
+	struct stat st;
+	if(stat(logPath, &st) != 0 || st.st_ino != logInode || logIndex == NULL || logIndex->generation != logGeneration)
+		return 0;
+	return stat(indexPath, &st) == 0 && st.st_ino == indexInode;
+}
+
+/* opens the new files if the cache was replaced. the caller holds appendLock and not the writer lock, which openFiles
+ * may take */
+static int reopenIfReplaced(){
+	int ok;
+	if(filesCurrent())
+		return 1;
+	pthread_rwlock_wrlock(&cacheLock);
+	closeFiles();
+	ok = openFiles();
+	pthread_rwlock_unlock(&cacheLock);
+	return ok;
+}
+
+int openSolutionCache(const char *path, long maxBytes){
+	int ok;
+	if(strlen(path) >= sizeof(logPath)){
+		printf("Error: cache path is too long\n");
+		return 0;
+	}
+	pthread_mutex_lock(&appendLock);
+	pthread_rwlock_wrlock(&cacheLock);
+	strcpy(logPath, path);
+	sprintf(indexPath, "%s.idx", path);
+	sprintf(lockPath, "%s.lock", path);
+	maxLogBytes = maxBytes > 0 ? maxBytes : CACHE_DEFAULT_MAX_BYTES;
+	lockFd = open(lockPath, O_RDWR | O_CREAT, 0644);
+	ok = lockFd >= 0 && openFiles();
+	if(!ok){
+		printf("Error: could not open the solution cache %s\n", path);
+		if(lockFd >= 0)
+			close(lockFd);
+		lockFd = -1;
+	}
+	cacheIsOpen = ok;
+	pthread_rwlock_unlock(&cacheLock);
+	pthread_mutex_unlock(&appendLock);
+	return ok;
+}
+
+void closeSolutionCache(){
+	pthread_mutex_lock(&appendLock);
+	pthread_rwlock_wrlock(&cacheLock);
+	if(cacheIsOpen){
+		closeFiles();
+		close(lockFd);
+		lockFd = -1;
+		cacheIsOpen = 0;
+	}
+	pthread_rwlock_unlock(&cacheLock);
+	pthread_mutex_unlock(&appendLock);
+}
+
+int solutionCacheOpen(){
+	return cacheIsOpen;
+}
+
+int cacheLookup(uint64_t hash, int n, int m, const int *canonical, CacheRecord *record){
+	unsigned char payload[MAX_PAYLOAD];
+	RecordFixed *fixed = (RecordFixed*)payload;
+	IndexSlot *slots;
+	uint64_t check;
+	uint32_t mask, i, probes;
+	int found = 0, cell, cells = n*m*n*m;
+	if(!cacheIsOpen || n*m > MAX_N)
+		return 0;
+	check = gridCheck(n, m, canonical);
+	pthread_rwlock_rdlock(&cacheLock);
+	if(!filesCurrent()){
+		pthread_rwlock_unlock(&cacheLock);
+		pthread_mutex_lock(&appendLock);
+		reopenIfReplaced();
+		pthread_mutex_unlock(&appendLock);
+		pthread_rwlock_rdlock(&cacheLock);
+	}
+	if(logIndex != NULL){
+		slots = indexSlots(logIndex);
+		mask = logIndex->capacity - 1;
+		for(i = (uint32_t)hash & mask, probes = 0; slots[i].offset != 0 && !found && probes < logIndex->capacity; i = (i+1) & mask, probes++){
+			if(slots[i].hash != hash || slots[i].check != check)
+				continue;
+			if(readRecord(logFd, slots[i].offset - 1, payload) == 0 || fixed->n != n || fixed->m != m)
+				break;
+			for(cell = 0; cell < cells && payload[sizeof(RecordFixed) + cell] == canonical[cell]; cell++);
+			if(cell < cells)
+				break;
+			record->n = n;
+			record->m = m;
+			record->hasSolution = (fixed->flags & FLAG_SOLUTION) != 0;
+			record->solution = NULL;
+			if(record->hasSolution){
+				record->solution = (int*)malloc(cells*sizeof(int));
+				if(record->solution == NULL){
+					record->hasSolution = 0;
+				}
+				else{
+					for(cell = 0; cell < cells; cell++)
+						record->solution[cell] = payload[sizeof(RecordFixed) + cells + cell];
+				}
+			}
+			record->countKnown = (fixed->flags & FLAG_COUNT) != 0;
+			record->countExact = (fixed->flags & FLAG_EXACT) != 0;
+			record->count = (long)fixed->count;
+			record->seconds = fixed->seconds;
+			memcpy(record->engine, fixed->engine, CACHE_ENGINE_LEN);
+			record->engine[CACHE_ENGINE_LEN-1] = '\0';
+			found = 1;
+		}
+	}
+	pthread_rwlock_unlock(&cacheLock);
+	return found;
+}
+
+static int compareOffsets(const void *a, const void *b){
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* rewrites the log with only the newest record of every board, dropping the oldest boards until it fits in half the bound.
+ * the caller holds appendLock and the writer lock. the new log and its index are written and synced before cacheLock is
+ * taken to put them in place */
+static void compact(){
+	char tmpPath[1200], indexTmpPath[1200];
+	unsigned char payload[MAX_PAYLOAD];
+	IndexSlot *slots = indexSlots(logIndex);
+	LogHeader header;
+	uint64_t *offsets;
+	size_t *sizes;
+	uint64_t total = 0;
+	uint32_t i;
+	int numLive = 0, first, j, fd, newIndexFd, ok = 1;
+	offsets = (uint64_t*)malloc(logIndex->count*sizeof(uint64_t) + 1);
+	sizes = (size_t*)malloc(logIndex->count*sizeof(size_t) + 1);
+	if(offsets == NULL || sizes == NULL){
+		free(offsets);
+		free(sizes);
+		return;
+	}
+	for(i = 0; i < logIndex->capacity; i++){
+		if(slots[i].offset != 0)
+			offsets[numLive++] = slots[i].offset - 1;
+	}
+	/* keep the log order, so the oldest boards are the first to go */
+	qsort(offsets, numLive, sizeof(uint64_t), compareOffsets);
+	for(j = 0; j < numLive; j++){
+		sizes[j] = readRecord(logFd, offsets[j], payload);
+		total += sizes[j];
+	}
+	for(first = 0; first < numLive && total > (uint64_t)maxLogBytes/2; first++)
+		total -= sizes[first];
+	sprintf(tmpPath, "%s.%ld.tmp", logPath, (long)getpid());
+	fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0){
+		free(offsets);
+		free(sizes);
+		return;
+	}
+	memcpy(header.magic, LOG_MAGIC, 8);
+	header.generation = logGeneration + 1;
+	header.reserved = 0;
+	ok = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+	for(j = first; j < numLive && ok; j++){
+		if(sizes[j] == 0)
+			continue;
+		ok = pread(logFd, payload, sizeof(RecordHeader), (off_t)offsets[j]) == (ssize_t)sizeof(RecordHeader)
+				&& write(fd, payload, sizeof(RecordHeader)) == (ssize_t)sizeof(RecordHeader)
+				&& pread(logFd, payload, sizes[j] - sizeof(RecordHeader), (off_t)(offsets[j] + sizeof(RecordHeader)))
+						== (ssize_t)(sizes[j] - sizeof(RecordHeader))
+				&& write(fd, payload, sizes[j] - sizeof(RecordHeader)) == (ssize_t)(sizes[j] - sizeof(RecordHeader));
+	}
+	free(offsets);
+	free(sizes);
+	newIndexFd = -1;
+	if(ok && fsync(fd) == 0)
+		newIndexFd = buildIndex(fd, header.generation, MIN_INDEX_CAPACITY, indexTmpPath);
+	pthread_rwlock_wrlock(&cacheLock);
+	if(newIndexFd < 0 || rename(tmpPath, logPath) != 0){
+		pthread_rwlock_unlock(&cacheLock);
+		if(newIndexFd >= 0){
+			close(newIndexFd);
+			unlink(indexTmpPath);
+		}
+		close(fd);
+		unlink(tmpPath);
+		return;
+	}
+	/* readers of other processes that still hold the old files keep reading them consistently, new ones see a log
+	 * without an index (other generation) until the new index is in place */
+	close(logFd);
+	logFd = fd;
+	logGeneration = header.generation;
+	{
+		struct stat st;
+		fstat(logFd, &st);
+		logInode = st.st_ino;
+	}
+	installIndex(newIndexFd, indexTmpPath);
+	pthread_rwlock_unlock(&cacheLock);
+}
+
+int cacheAppend(uint64_t hash, int n, int m, const int *canonical, const CacheRecord *record){
+	unsigned char payload[MAX_PAYLOAD];
+	RecordHeader header;
+	RecordFixed *fixed = (RecordFixed*)payload;
+	uint64_t offset;
+	size_t engineLength;
+	int cell, cells = n*m*n*m, ok = 0, locked = 0, tries, full;
+	uint32_t capacity;
+	if(!cacheIsOpen || n*m > MAX_N)
+		return 0;
+	memset(payload, 0, sizeof(RecordFixed));
+	fixed->hash = hash;
+	fixed->count = record->count;
+	fixed->seconds = record->seconds;
+	fixed->n = (uint16_t)n;
+	fixed->m = (uint16_t)m;
+	fixed->flags = (record->hasSolution ? FLAG_SOLUTION : 0) | (record->countKnown ? FLAG_COUNT : 0) | (record->countExact ? FLAG_EXACT : 0);
+	/* the payload is zeroed, so the name stays terminated */
+	engineLength = strnlen(record->engine, CACHE_ENGINE_LEN-1);
+	memcpy(fixed->engine, record->engine, engineLength);
+	for(cell = 0; cell < cells; cell++)
+		payload[sizeof(RecordFixed) + cell] = (unsigned char)canonical[cell];
+	if(record->hasSolution){
+		for(cell = 0; cell < cells; cell++)
+			payload[sizeof(RecordFixed) + cells + cell] = (unsigned char)record->solution[cell];
+	}
+	header.magic = RECORD_MAGIC;
+	header.length = (uint32_t)(sizeof(RecordFixed) + cells*(record->hasSolution ? 2 : 1));
+	header.checksum = payloadChecksum(payload, header.length);
+	header.reserved = 0;
+	pthread_mutex_lock(&appendLock);
+	/* openFiles takes the writer lock itself, so the files are reopened before it is taken and checked again after */
+	for(tries = 0; tries < 2 && !locked && reopenIfReplaced(); tries++){
+		flock(lockFd, LOCK_EX);
+		locked = filesCurrent();
+		if(!locked)
+			flock(lockFd, LOCK_UN);
+	}
+	/* index only what was appended after the index was last updated, a full index is rebuilt */
+	if(locked && !indexNewRecords())
+		rebuildIndex(2*logIndex->capacity);
+	if(locked && logIndex != NULL){
+		offset = logIndex->logSize;
+		if(pwrite(logFd, &header, sizeof(header), (off_t)offset) == (ssize_t)sizeof(header)
+				&& pwrite(logFd, payload, header.length, (off_t)(offset + sizeof(header))) == (ssize_t)header.length
+				&& fdatasync(logFd) == 0){
+			/* only a record that is on disk may be pointed to */
+			full = indexInsert(logIndex, hash, gridCheck(n, m, canonical), offset) < 0;
+			logIndex->logSize = offset + sizeof(header) + header.length;
+			ok = 1;
+			capacity = logIndex->capacity;
+			/* a full index is rebuilt with the new record in it */
+			if(full || 2*logIndex->count > capacity)
+				rebuildIndex(2*capacity);
+			if(logIndex != NULL && logIndex->logSize > (uint64_t)maxLogBytes)
+				compact();
+		}
+	}
+	if(locked)
+		flock(lockFd, LOCK_UN);
+	pthread_mutex_unlock(&appendLock);
+	return ok;
+}
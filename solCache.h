@@ -0,0 +1,45 @@
+/* Header file of the solution cache module. A persistent cache of solutions and solution counts shared by all the runs on the machine,
+ * keyed by the canonical hash of the board (see canon.h), so a puzzle solved in one session is not solved again in the next one.
+ * The cache is an append-only log of records plus an mmap'd hash index from the hash to the newest record of the board.
+ * Any number of processes may read it without locks - every record carries a checksum, so a torn or stale read is just a miss.
+ * Appends take an exclusive lock on the log, so there is a single writer at a time. A record is synced to the log before the index
+ * points to it, and a torn tail left by a crash is cut off by the next writer. When the log grows past its size bound it is compacted:
+ * only the newest record of every board is kept (the oldest boards are dropped if that is still too large) and the new log and index
+ * replace the old ones by rename.*/
+
+#ifndef SOLCACHE_H_
+#define SOLCACHE_H_
+#include <stdint.h>
+
+#define CACHE_DEFAULT_MAX_BYTES (64L*1024*1024)
+#define CACHE_ENGINE_LEN 16
+
+/* what the cache knows about a board. all grids are in the canonical orientation */
+typedef struct CacheRecord{
+	int n;
+	int m;
+	int hasSolution;
+	int *solution; /* N*N values if hasSolution, allocated by cacheLookup (the caller frees it) */
+	int countKnown;
+	int countExact; /* 0 if count is only a lower bound */
+	long count;
+	double seconds; /* how long the solver that produced the record ran */
+	char engine[CACHE_ENGINE_LEN]; /* the name of that solver */
+}CacheRecord;
+
+/* opens (or creates) the cache at path, with the log bounded to about maxBytes.
+ * returns 1 on success, 0 on failure (a message is printed and the session runs without the cache) */
+int openSolutionCache(const char *path, long maxBytes);
+
+void closeSolutionCache();
+
+/* returns 1 if the cache is open */
+int solutionCacheOpen();
+
+/* finds the newest record of the board with the given canonical grid and hash. returns 1 if found, 0 otherwise */
+int cacheLookup(uint64_t hash, int n, int m, const int *canonical, CacheRecord *record);
+
+/* appends a record for the board (it replaces the older ones). returns 1 on success, 0 on failure */
+int cacheAppend(uint64_t hash, int n, int m, const int *canonical, const CacheRecord *record);
+
+#endif /* SOLCACHE_H_ */
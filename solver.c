@@ -3,7 +3,12 @@
 #include <stdlib.h>
 #include "game.h"
 #include "MainAux.h"
-#include "gurobi_c.h"
+#include "control.h"
+#include "movesList.h"
+#include "geometry.h"
+#include "search.h"
+#include "trace.h"
+#include "journal.h"
 
 /* This module implements the Backtrack algorithms.
  * it contains one deterministic and one non-deterministic implementation
@@ -14,239 +19,398 @@
 
 /* Takes a partially filled-in grid and attempts to assign values to
   all unassigned locations in a deterministic way (from 1 to 9), to meet the
-  requirements for Sudoku solution (non-duplication across rows, columns, and boxes) */
-int deterministicBackTracking(Cell** board, int row, int col){
-	int value = 0;
-	int nextIteration =0;
-
-	/* If there is no unassigned location, we are done */
-	if (row == C*R && col == 0){
-		return 1; /* success! */
+  requirements for Sudoku solution (non-duplication across rows, columns, and boxes).
+  the cells are tried row by row with the search module, which takes values back along its trail
+  instead of rebuilding the optional values of every cell. returns 1 and fills the board if solved,
+  0 if the board has no solution and -1 on a memory error */
+int deterministicBackTracking(Game *game){
+	int N = game->n*game->m, row, col, res;
+	long count;
+	int *solution = (int*)calloc(N*N, sizeof(int));
+	if(solution == NULL){
+		printf("Error: calloc has failed\n");
+		return -1;
 	}
-	/* if the cell is fixed or already filled, go to the next cell */
-	if(board[row][col].value != 0 || board[row][col].fixed == 1){
-		if(col<(C*R-1)){
-			nextIteration = deterministicBackTracking(board, row, col+1);
-		}
-		else if(col == C*R-1){
-			nextIteration = deterministicBackTracking(board, row+1, 0);
-		}
-		if (nextIteration == 1){
-			return 1;
-		}
-		else{
-			return 0;
+	res = searchBoard(game, NULL, SEARCH_ROW_ORDER, 1, &count, solution, NULL);
+	if(res == 1 && count > 0){
+		for(row = 0; row < N; row++)
+			for(col = 0; col < N; col++)
+				game->board[row][col].value = solution[row*N+col];
+	}
+	free(solution);
+	if(res == 1)
+		return count > 0;
+	return -1;
+}
+
+
+/* Counts the solutions of the board with an exhaustive back-tracking with the search options of the game, see search.h.
+ * Returns 1 if all the solutions were counted, 0 if the control stopped the search (then *count is a lower bound)
+ * and -1 on a memory error */
+int countSolutions(Game *game, SolveControl *control, long *count){
+	return searchBoard(game, control, game->searchOptions, 0, count, NULL, NULL);
+}
+
+/* Solves the board with the back-tracking of countSolutions, stopping at the first solution */
+int backtrackSolve(Game *game, SolveControl *control, int *solution){
+	long count;
+	int res = searchBoard(game, control, game->searchOptions, 1, &count, solution, NULL);
+	if(res == 1)
+		return count > 0;
+	return res == 0 ? 2 : -1;
+}
+
+/* Finds a random solution of the board with the randomized search of the search module, see solver.h */
+int nonDeterministicBackTracking(Game *game, SolveControl *control, int *solution){
+	return randomSearch(game, control, &game->rng, game->searchOptions, solution, NULL, NULL);
+}
+
+void autofill(Game *game){
+	int row, col, val, N = game->n*game ;
+	if(isErroneous(game)){
+		printf("ERROR: board is erroneous.\n");
+		return;
+	}
+	/* find the optional values for every cell of the board */
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			setOptionalValues(game, row, col);
 		}
 	}
-	else{
-		/* set all the possible assignments to the cell (row,col) */
-		setOptionalValues(board, row, col);
-		/* as long as there are optional values to the cell: */
-		while (board[row][col].numOfOptionalValues > 0){
-			/* try to assign number (by order) to the current cell */
-			value = board[row][col].optionalValues[0];
-			board[row][col].value = value;
-			fixOpptions(board, row, col, 0);
-
-			/* and go to the next cell */
-			if(col<(C*R-1)){
-				nextIteration = deterministicBackTracking(board, row, col+1);
-			}
-			else if(col == C*R-1){
-				nextIteration = deterministicBackTracking(board, row+1, 0);
-			}
-			/* if the next allocations worked and this one worked, return 1*/
-			if (nextIteration == 1){
-				return 1;
-			}
-			else{
-			/* failure, unmake and move to the next number */
-				board[row][col].value = 0;
+	/* for all the cells that has only one value possible, autofill this value */
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++){
+			if(game->board[row][col].numOfOptionalValues == 1){
+				set(game, row, col, game->board[row][col].optionalValues[0], 0);
+				printf("cell <%d,%d> was set to %d\n", row, col, game->board[row][col].optionalValues[0]);
 			}
 		}
-		return 0;
 	}
 }
 
+/* the state of autofillAll: the used values of every unit (row, column and box, see geometry.h) as bit masks (N <= 64),
+ * the places every value still has in every unit as bit masks too, a worklist of cells to re-examine for a single
+ * candidate and a worklist of units to re-examine for hidden singles.
+ * the places are the dual of the candidates of the cells: bit i of the places of (unit, v) is set if the i-th cell of the
+ * unit is empty and may still get v. every candidate a cell loses clears one bit in each of its three units, so a value
+ * with one place left in a unit is read off one mask instead of checking the candidates of every cell of the unit */
+typedef struct FillState{
+	const Geometry *geo;
+	int N;
+	int *grid;
+	unsigned long *used; /* 3N masks, bit v-1 is set if value v is in the unit */
+	unsigned long *places; /* 3N*N masks, the places of value v in unit u are places[u*N + v-1] */
+	int *cellQueue;
+	char *cellQueued;
+	int cellHead;
+	int cellTail;
+	int *unitQueue;
+	char *unitQueued;
+	int unitHead;
+	int unitTail;
+	int *fills; /* the filled cells in the order they were filled */
+	int numFills;
+}FillState;
 
-int ilpSolver(Game game){
-
-	int dim = game.n*game.m;
-	GRBenv *env = NULL;
-	GRBmodel *model = NULL;
-	int ind = (int*)calloc(dim, sizeof(int));
-	double val = (double*)calloc(dim, sizeof(double));
-	double lb = (double*)calloc(dim*dim*dim, sizeof(double));
-	char vtype = (char*)calloc(dim*dim*dim, sizeof(char));
-	char *names = (char**)calloc(dim*dim*dim, sizeof(char));
-	char namestorage = (char*)malloc((dim+1)*dim*dim*dim, sizeof(char));
-	char *cursor;
-	int optimstatus;
-	double objval;
-	int i, j, v, ig, jg, count;
-	int error = 0;
-
-	/* create an empty model */
-	cursor = namestorage;
-	for(i = 0; i < dim; i++){
-		for(j = 0; j < dim; j++){
-			for(v = 1; v < dim+1; v++){
-				if(game.board[i][j].value == v){
-					lb[i*dim*dim+j*dim*dim+v] = 1;
-				}
-				else{
-					lb[i*dim*dim+j*dim*dim+v] = 0;
-				}
-				vtype[i*dim*dim+j*dim*dim+v] = GRB_BINARY;
-				names[i*dim*dim+j*dim*dim+v] = cursor;
-				sprintf(names[i*dim*dim+j*dim*dim+v], "x_%d,%d,%d", i, j, v+1);
-				cursor += strlen(names[i*dim*dim+j*dim*dim+v]+1);
-			}
-		}
+/* the values cell may still get, as a bit mask */
+static unsigned long candidates(FillState *state, int cell){
+	const Geometry *geo = state->geo;
+	unsigned long all = state->N == 64 ? ~0UL : (1UL << state->N) - 1;
+	return all & ~(state->used[geo->rowOf[cell]] | state->used[state->N + geo->colOf[cell]] | state->used[2*state->N + geo->boxOf[cell]]);
+}
+
+/* the value of every bit, by the top 6 bits of the bit times a de Bruijn sequence */
+static const int debruijnValue[64] = {
+	1, 2, 49, 3, 58, 50, 29, 4, 62, 59, 51, 43, 39, 30, 18, 5,
+	63, 56, 60, 37, 54, 52, 44, 23, 46, 40, 34, 31, 25, 19, 13, 6,
+	64, 48, 57, 28, 61, 42, 38, 17, 55, 36, 53, 22, 45, 33, 24, 12,
+	47, 27, 41, 16, 35, 21, 32, 11, 26, 15, 20, 10, 14, 9, 8, 7
+};
+
+/* the value of a mask with exactly one bit set */
+static int maskValue(unsigned long mask){
+	return debruijnValue[(int)(((unsigned long long)mask * 0x03f79d71b4cb0a89ULL) >> 58)];
+}
+
+/* the index of the cell among the cells of its box, the order of geometry.h */
+static int boxPosition(const Geometry *geo, int cell){
+	return (geo->rowOf[cell] % geo->n)*geo->m + geo->colOf[cell] % geo->m;
+}
+
+/* val has no place in the cell any more, in any of its units */
+static void dropPlace(FillState *state, int cell, int val){
+	const Geometry *geo = state->geo;
+	int N = state->N;
+	state->places[geo->rowOf[cell]*N + val-1] &= ~(1UL << geo->colOf[cell]);
+	state->places[(N + geo->colOf[cell])*N + val-1] &= ~(1UL << geo->rowOf[cell]);
+	state->places[(2*N + geo->boxOf[cell])*N + val-1] &= ~(1UL << boxPosition(geo, cell));
+}
+
+/* the k low bits */
+static unsigned long lowBits(int k){
+	return k >= 64 ? ~0UL : (1UL << k) - 1;
+}
+
+/* set the places of every value in every unit from the used masks. a place of a row is an empty cell whose column and
+ * box don't have the value, so the places of a value in all the units come from the rows, columns and boxes that
+ * don't have it, as masks, without a pass over the candidates of every cell */
+static void initPlaces(FillState *state){
+	const Geometry *geo = state->geo;
+	int N = state->N, n = geo->n, m = geo->m, val, cell, unit, band, stack, i;
+	unsigned long bit, rowsFree, colsFree, boxesFree, across, blockRows, blockCols;
+	unsigned long emptyRow[GEOMETRY_MAX_N], emptyCol[GEOMETRY_MAX_N], emptyBox[GEOMETRY_MAX_N];
+	memset(emptyRow, 0, sizeof(emptyRow));
+	memset(emptyCol, 0, sizeof(emptyCol));
+	memset(emptyBox, 0, sizeof(emptyBox));
+	for(cell = 0; cell < N*N; cell++){
+		if(state->grid[cell] != 0)
+			continue;
+		emptyRow[geo->rowOf[cell]] |= 1UL << geo->colOf[cell];
+		emptyCol[geo->colOf[cell]] |= 1UL << geo->rowOf[cell];
+		emptyBox[geo->boxOf[cell]] |= 1UL << boxPosition(geo, cell);
 	}
-	/* create environment */
-	error = GRBloadenv(&env, "sudoku.log");
-	if (error) goto QUIT;
-	/* create a new model */
-	error = GRBnewmodel(env, &model, "sudoku", dim*dim*dim, NULL, lb, NULL, vtype, names);
-	if (error) goto QUIT;
-	/* each cell gets a value */
-	for(i=0; i<dim; i++){
-		for(i=0; i<dim; i++){
-			for(i=0; i<dim; i++){
-				ind[v] = i*dim*dim+j*dim*dim+v;
-				val[v] = 1.0;
-			}
-			error = GRBaddconstr(model, dim, ind, val, GRB_EQUAL, 1.0, NULL);
-			if (error) goto QUIT;
+	for(val = 1; val <= N; val++){
+		bit = 1UL << (val-1);
+		rowsFree = colsFree = boxesFree = 0;
+		for(i = 0; i < N; i++){
+			if(!(state->used[i] & bit))
+				rowsFree |= 1UL << i;
+			if(!(state->used[N + i] & bit))
+				colsFree |= 1UL << i;
+			if(!(state->used[2*N + i] & bit))
+				boxesFree |= 1UL << i;
 		}
-	}
-	/* each value must appear once in each row */
-	for(i=0; i<dim; i++){
-		for(i=0; i<dim; i++){
-			for(i=0; i<dim; i++){
-				ind[i] = i*dim*dim+j*dim*dim+v;
-				val[i] = 1.0;
+		/* band b is the rows b*n .. b*n+n-1, crossed by the boxes b*n .. b*n+n-1 of m columns each */
+		for(band = 0; band < m; band++){
+			across = 0;
+			for(stack = 0; stack < n; stack++){
+				if(boxesFree & (1UL << (band*n + stack)))
+					across |= lowBits(m) << (stack*m);
+			}
+			for(i = 0; i < n; i++){
+				unit = band*n + i;
+				state->places[unit*N + val-1] = (rowsFree & (1UL << unit)) ? emptyRow[unit] & colsFree & across : 0;
 			}
-			error = GRBaddconstr(model, dim, ind, val, GRB_EQUAL, 1.0, NULL);
-			if (error) goto QUIT;
 		}
-	}
-	/* each value must appear once in each col */
-	for(i=0; i<dim; i++){
-		for(i=0; i<dim; i++){
-			for(i=0; i<dim; i++){
-				ind[j] = i*dim*dim+j*dim*dim+v;
-				val[j] = 1.0;
+		/* stack s is the columns s*m .. s*m+m-1, crossed by the boxes s, n+s, 2n+s ... of n rows each */
+		for(stack = 0; stack < n; stack++){
+			across = 0;
+			for(band = 0; band < m; band++){
+				if(boxesFree & (1UL << (band*n + stack)))
+					across |= lowBits(n) << (band*n);
+			}
+			for(i = 0; i < m; i++){
+				unit = stack*m + i;
+				state->places[(N + unit)*N + val-1] = (colsFree & (1UL << unit)) ? emptyCol[unit] & rowsFree & across : 0;
 			}
-			error = GRBaddconstr(model, dim, ind, val, GRB_EQUAL, 1.0, NULL);
-			if (error) goto QUIT;
 		}
-	}
-	/* each value must appear once in each subgrid */
-	for(v=0; v<dim; v++){
-		for(ig=0;  ig<game.n; ig++){
-			for(jg=0; jg<game.m; jg++){
-				count = 0;
-				for(i= ig*game.m; i<(ig+1)*game.m; i++){
-					for(j= jg*game.n; j<(jg+1)*game.n; i++){
-						ind[count] = i*dim*dim+j*dim*dim+v;
-						val[count] = 1.0;
-					}
+		/* place i of a box is in its row i/m and its column i%m */
+		for(unit = 0; unit < N; unit++){
+			blockRows = blockCols = 0;
+			if(boxesFree & (1UL << unit)){
+				for(i = 0; i < n; i++){
+					if(rowsFree & (1UL << ((unit/n)*n + i)))
+						blockRows |= lowBits(m) << (i*m);
+					blockCols |= ((colsFree >> ((unit%n)*m)) & lowBits(m)) << (i*m);
 				}
 			}
-			error = GRBaddconstr(model, dim, ind, val, GRB_EQUAL, 1.0, NULL);
-			if (error) goto QUIT;
+			state->places[(2*N + unit)*N + val-1] = emptyBox[unit] & blockRows & blockCols;
 		}
 	}
-	/* optimize model */
-	error = GRBoptimize(model);
-	if (error) goto QUIT;
-	/* Write model to 'sudoku.lp' */
-	error = GRBwrite(model, "sudoku.lp");
-	if (error) goto QUIT;
-	/* Capture solution information */
-	error = GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus);
-	if (error) goto QUIT;
-	error = GRBgetdblattr(model, GRB_DBL_ATTR_OBJVAL, &objval);
-	if (error){
-		exitILP();
-	}
-	/* if there is a solution to the game */
-	if (optimstatus == GRB_OPTIMAL){
-		/* free all calloc */
-		free(ind);
-		free(val);
-		free(lb);
-		free(vtype);
-		free(names);
-		free(namestorage);
-		return 1;
-	}
-	/* if there is no solution to the game */
-	else if (optimstatus == GRB_INF_OR_UNBD){
-		/* free all calloc */
-		free(ind);
-		free(val);
-		free(lb);
-		free(vtype);
-		free(names);
-		free(namestorage);
-		return 0;
-	}
-	/* if the optimization was stopped early and we didn't reach a solution*/
-	else{
-		/* free all calloc */
-		free(ind);
-		free(val);
-		free(lb);
-		free(vtype);
-		free(names);
-		free(namestorage);
-		return 2;
-	}
-	/* Error reporting */
-	QUIT:
-	if (error) {
-		printf("ERROR: %s\n", GRBgeterrormsg(env));
-	    exit(1);
-	}
-	/* Free model */
-	GRBfreemodel(model);
-	/* Free environment */
-	GRBfreeenv(env);
-	/* free all calloc */
-		free(ind);
-		free(val);
-		free(lb);
-		free(vtype);
-		free(names);
-		free(namestorage);
-	return 0;
 }
 
+static void queueCell(FillState *state, int cell){
+	int N = state->N;
+	if(state->grid[cell] != 0 || state->cellQueued[cell])
+		return;
+	state->cellQueued[cell] = 1;
+	state->cellQueue[state->cellTail] = cell;
+	state->cellTail = (state->cellTail + 1) % (N*N);
+}
 
-void autofill(Game *game){
-	int row, col, val, N = game->n*game ;
-	if(isErroneous(game)){
-		printf("ERROR: board is erroneous.\n");
+static void queueUnit(FillState *state, int unit){
+	if(state->unitQueued[unit])
 		return;
+	state->unitQueued[unit] = 1;
+	state->unitQueue[state->unitTail] = unit;
+	state->unitTail = (state->unitTail + 1) % (3*state->N);
+}
+
+/* put val in the cell, and queue the cells that lost a candidate and the units they are in */
+static void fillCell(FillState *state, int cell, int val){
+	const Geometry *geo = state->geo;
+	int N = state->N, i, peer, unit[3];
+	unsigned long mask;
+	unit[0] = geo->rowOf[cell];
+	unit[1] = N + geo->colOf[cell];
+	unit[2] = 2*N + geo->boxOf[cell];
+	/* the filled cell is no place for any value */
+	for(mask = candidates(state, cell); mask; mask &= mask - 1)
+		dropPlace(state, cell, maskValue(mask & (~mask + 1)));
+	state->grid[cell] = val;
+	state->fills[state->numFills++] = cell;
+	/* the peers that lose val are the places it has left in the units of the cell, the other peers don't change */
+	for(i = 0; i < 3; i++){
+		state->used[unit[i]] |= 1UL << (val-1);
+		queueUnit(state, unit[i]);
+		for(mask = state->places[unit[i]*N + val-1]; mask; mask &= mask - 1){
+			peer = geo->unitCells[unit[i]*N + maskValue(mask & (~mask + 1))-1];
+			dropPlace(state, peer, val);
+			queueCell(state, peer);
+			queueUnit(state, geo->rowOf[peer]);
+			queueUnit(state, N + geo->colOf[peer]);
+			queueUnit(state, 2*N + geo->boxOf[peer]);
+		}
 	}
-	/* find the optional values for every cell of the board */
-	for(row = 0; row < N; row++){
-		for(col = 0; col < N; col++){
-			setOptionalValues(game->board, row, col);
+}
+
+/* run the worklists until nothing changes. returns 0 if a cell or a value of a unit was left with no place, 1 otherwise */
+static int propagate(FillState *state){
+	int N = state->N, cell, unit, val;
+	unsigned long mask;
+	while(state->cellHead != state->cellTail || state->unitHead != state->unitTail){
+		/* naked singles first, they are cheaper */
+		if(state->cellHead != state->cellTail){
+			cell = state->cellQueue[state->cellHead];
+			state->cellHead = (state->cellHead + 1) % (N*N);
+			state->cellQueued[cell] = 0;
+			if(state->grid[cell] != 0)
+				continue;
+			mask = candidates(state, cell);
+			if(mask == 0)
+				return 0;
+			if((mask & (mask - 1)) == 0)
+				fillCell(state, cell, maskValue(mask));
+			continue;
+		}
+		/* hidden singles: a value that has one place left in the unit */
+		unit = state->unitQueue[state->unitHead];
+		state->unitHead = (state->unitHead + 1) % (3*N);
+		state->unitQueued[unit] = 0;
+		for(val = 1; val <= N; val++){
+			if(state->used[unit] & (1UL << (val-1)))
+				continue;
+			mask = state->places[unit*N + val-1];
+			if(mask == 0)
+				return 0;
+			if((mask & (mask - 1)) == 0)
+				fillCell(state, state->geo->unitCells[unit*N + maskValue(mask)-1], val);
 		}
 	}
-	/* for all the cells that has only one value possible, autofill this value */
+	return 1;
+}
+
+static void freeFillState(FillState *state){
+	free(state->grid);
+	free(state->used);
+	free(state->places);
+	free(state->cellQueue);
+	free(state->cellQueued);
+	free(state->unitQueue);
+	free(state->unitQueued);
+	free(state->fills);
+}
+
+/* set up the state of the board of the game, with every empty cell and every unit queued once.
+ * returns 1 on success, 0 if two given cells of a unit clash and -1 on an error */
+static int initFillState(FillState *state, Game *game){
+	int N = game->n*game->m, row, col, cell, val, i, clash = 0;
+	unsigned long bit;
+	memset(state, 0, sizeof(*state));
+	state->geo = getGeometry(game->n, game->m);
+	if(state->geo == NULL)
+		return -1;
+	state->N = N;
+	state->grid = (int*) calloc(N*N, sizeof(int));
+	state->used = (unsigned long*) calloc(3*N, sizeof(unsigned long));
+	state->places = (unsigned long*) malloc(3*N*N*sizeof(unsigned long)); /* all set by initPlaces */
+	state->cellQueue = (int*) calloc(N*N, sizeof(int));
+	state->cellQueued = (char*) calloc(N*N, sizeof(char));
+	state->unitQueue = (int*) calloc(3*N, sizeof(int));
+	state->unitQueued = (char*) calloc(3*N, sizeof(char));
+	state->fills = (int*) calloc(N*N, sizeof(int));
+	if(state->grid == NULL || state->used == NULL || state->places == NULL || state->cellQueue == NULL || state->cellQueued == NULL
+			|| state->unitQueue == NULL || state->unitQueued == NULL || state->fills == NULL){
+		printf("ERROR: memory allocation error.\n");
+		freeFillState(state);
+		return -1;
+	}
 	for(row = 0; row < N; row++){
 		for(col = 0; col < N; col++){
-			if(game->board[row][col].numOfOptionalValues == 1){
-				set(game, row, col, game->board[row][col].optionalValues[0], 0);
-				printf("cell <%d,%d> was set to %d\n", row, col, game->board[row][col].optionalValues[0]);
-			}
+			cell = row*N + col;
+			val = game->board[row][col].value;
+			state->grid[cell] = val;
+			if(val == 0)
+				continue;
+			bit = 1UL << (val-1);
+			if((state->used[row] | state->used[N + col] | state->used[2*N + state->geo->boxOf[cell]]) & bit)
+				clash = 1;
+			state->used[row] |= bit;
+			state->used[N + col] |= bit;
+			state->used[2*N + state->geo->boxOf[cell]] |= bit;
 		}
 	}
+	initPlaces(state);
+	for(cell = 0; cell < N*N; cell++)
+		queueCell(state, cell);
+	for(i = 0; i < 3*N; i++)
+		queueUnit(state, i);
+	return clash ? 0 : 1;
+}
+
+int propagateBoard(Game *game, int *grid, unsigned long *cellCandidates){
+	FillState state;
+	int N = game->n*game->m, cell, res;
+	res = initFillState(&state, game);
+	if(res < 0)
+		return -1;
+	if(res == 1){
+		TRACE_BEGIN("propagate");
+		res = propagate(&state);
+		TRACE_END("propagate");
+	}
+	memcpy(grid, state.grid, N*N*sizeof(int));
+	if(cellCandidates != NULL){
+		for(cell = 0; cell < N*N; cell++)
+			cellCandidates[cell] = state.grid[cell] == 0 ? candidates(&state, cell) : 0;
+	}
+	freeFillState(&state);
+	return res;
+}
+
+void autofillAll(Game *game){
+	FillState state;
+	int N = game->n*game->m, row, col, cell, i, consistent;
+	if(isErrorneous(game)){
+		printf("ERROR: board is erroneous.\n");
+		return;
+	}
+	if(initFillState(&state, game) < 0)
+		return;
+	TRACE_BEGIN("propagate");
+	consistent = propagate(&state);
+	TRACE_END("propagate");
+	/* the fills go in as one batch of moves, undo and redo take them all together */
+	if(state.numFills > 0)
+		clearNextMoves(game);
+	for(i = 0; i < state.numFills; i++){
+		cell = state.fills[i];
+		row = cell/N;
+		col = cell%N;
+		setMove(game, row+1, col+1, state.grid[cell], 0);
+		game->currentMove->chained = i > 0;
+		if(i > 0)
+			journalRecord(JOURNAL_CHAIN, 0, 0, 0, 0);
+		game->board[row][col].value = state.grid[cell];
+		game->numOfFilledCells++;
+		printf("cell <%d,%d> was set to %d\n", row+1, col+1, state.grid[cell]);
+	}
+	printf("autofill filled %d cells\n", state.numFills);
+	if(!consistent)
+		printf("Error: the board has no solution, a cell or a value was left with no option\n");
+	else if(game->numOfFilledCells == N*N)
+		printf("Puzzle solved successfully\n");
+	freeFillState(&state);
 }
 
 
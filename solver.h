@@ -1,20 +1,45 @@
 #ifndef SOLVER_H_
 #define SOLVER_H_
 #include "game.h"
+#include "control.h"
 
 
 
 /* Takes a partially filled-in grid and attempts to assign values to
   all unassigned locations in a deterministic way (from 1 to 9), to meet the
-  requirements for Sudoku solution (non-duplication across rows, columns, and boxes) */
-int deterministicBackTracking(Cell** board, int row, int col);
+  requirements for Sudoku solution (non-duplication across rows, columns, and boxes).
+  returns 1 and fills the board if solved, 0 if the board has no solution and -1 on a memory error */
+int deterministicBackTracking(Game *game);
 
 
 /* Takes a partially filled-in grid and attempts to assign values to
   all unassigned locations in a non-deterministic way (choosing between all the possible
-  options randomly), to meet the requirements for Sudoku solution
-  */
-int nonDeterministicBackTracking(Cell** board, int row, int col);
+  options randomly, from the random stream of the game), to meet the requirements for Sudoku solution.
+  The search restarts on a Luby schedule of node budgets (see randomSearch in search.h), the board isn't changed.
+  returns 1 if a solution was put in solution (N*N, row by row), 0 if the board has none, 2 if the control stopped it and -1 on an error */
+int nonDeterministicBackTracking(Game *game, SolveControl *control, int *solution);
+
+/* Counts the solutions of the board with exhaustive back-tracking (see search.h), without changing it.
+ * returns 1 when all the solutions were counted, 0 when the control stopped the count
+ * (then *count is only a lower bound) and -1 on a memory error */
+int countSolutions(Game *game, SolveControl *control, long *count);
+
+/* Solves the board with the same back-tracking, without changing it, and puts the value of every cell in solution
+ * (N*N, row by row) if it isn't NULL. returns 1 if solved, 0 if the board has no solution,
+ * 2 if the control stopped the search and -1 on a memory error */
+int backtrackSolve(Game *game, SolveControl *control, int *solution);
+
+/* Fills the cells that have one possible value in a single pass over the board */
+void autofill(Game *game);
+
+/* Fills forced cells until nothing changes: cells with one candidate and values with one place left in a row,
+ * column or box. Only the peers of newly filled cells are examined again. All the fills are one undoable move */
+void autofillAll(Game *game);
+
+/* Runs the propagation of autofillAll on a copy of the board. grid (N*N, row by row) gets the values after it, and
+ * cellCandidates (N*N masks, may be NULL) the values every cell that is still empty may get (0 for filled cells).
+ * returns 1 if the board is consistent after it, 0 if a contradiction was found and -1 on an error */
+int propagateBoard(Game *game, int *grid, unsigned long *cellCandidates);
 
 
 
@@ -0,0 +1,387 @@
+/* Benchmark Tool
+ * times the board primitives of MainAux.c (isSafe, setOptionalValues, instancesInRow/Col/Box, findUnassignedLocation,
+ * fixOpptions) in isolation, on fixed half filled boards of several geometries, and prints the results as JSON.
+ * usage: benchPrimitives [--reps k] [--ops k] [--out file]
+ * every primitive gets warmup batches and then k measured batches (repetitions) of the same number of calls. batches
+ * further than 3 median absolute deviations from the median are rejected as outliers (an interrupt, a migration), and
+ * the rest are averaged. cycles, instructions, cache misses and branch misses are read with perf_event_open where the
+ * kernel allows it (perf_event_paranoid), otherwise only the wall-clock time is reported and the counters are null.
+ * printBoard lives in game.c with the rest of the game; it is measured (with stdout sent to /dev/null) when the tool
+ * is built with -DBENCH_PRINT_BOARD and linked with the objects of the game.
+ * it is built on its own, e.g. gcc -O2 -I.. benchPrimitives.c ../MainAux.c ../geometry.c ../rng.c -lpthread -o benchPrimitives
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "game.h"
+#include "MainAux.h"
+#include "geometry.h"
+
+#define NUM_COUNTERS 4
+#define MAX_REPS 1001
+#define WARMUP_BATCHES 3
+#define DEFAULT_REPS 31
+#define DEFAULT_OPS 100000
+#define OUTLIER_MADS 3.0
+
+static const int geometries[][2] = {{2, 3}, {3, 3}, {3, 4}, {4, 4}, {5, 5}};
+#define NUM_GEOMETRIES ((int)(sizeof(geometries)/sizeof(geometries[0])))
+
+static const char *counterNames[NUM_COUNTERS] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+static const unsigned long long counterConfigs[NUM_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+/* the counters, opened as one group so they count over exactly the same instructions. fds[0] is the leader */
+typedef struct Counters{
+	int fds[NUM_COUNTERS];
+	int available;
+}Counters;
+
+/* one measured batch */
+typedef struct Sample{
+	double seconds;
+	double counts[NUM_COUNTERS];
+}Sample;
+
+typedef struct Bench{
+	Game game;
+	Cell saved[9]; /* for fixOpptions, the cells as setOptionalValues left them */
+	int numCells; /* N*N */
+	volatile long sink; /* the results of the primitives go here, so the calls aren't optimized away */
+}Bench;
+
+static double now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec/1e9;
+}
+
+static int openCounter(unsigned long long config, int group){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void openCounters(Counters *counters){
+	int i;
+	counters->available = 0;
+	for(i = 0; i < NUM_COUNTERS; i++){
+		counters->fds[i] = openCounter(counterConfigs[i], i == 0 ? -1 : counters->fds[0]);
+		if(counters->fds[i] < 0){
+			while(i-- > 0)
+				close(counters->fds[i]);
+			return;
+		}
+	}
+	counters->available = 1;
+}
+
+static void closeCounters(Counters *counters){
+	int i;
+	if(!counters->available)
+		return;
+	for(i = 0; i < NUM_COUNTERS; i++)
+		close(counters->fds[i]);
+}
+
+static void startCounters(Counters *counters){
+	if(!counters->available)
+		return;
+	ioctl(counters->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static void stopCounters(Counters *counters, Sample *sample){
+	unsigned long long values[1 + NUM_COUNTERS];
+	int i;
+	if(!counters->available)
+		return;
+	ioctl(counters->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	/* a group read gives the number of counters and then their values */
+	if(read(counters->fds[0], values, sizeof(values)) != (ssize_t)sizeof(values))
+		return;
+	for(i = 0; i < NUM_COUNTERS; i++)
+		sample->counts[i] = (double)values[1+i];
+}
+
+/* the solved board of the geometry by the shifted rows pattern, with a fixed pseudo-random half of its cells emptied */
+static int initBench(Bench *bench, int n, int m){
+	int N = n*m, row, col;
+	unsigned long state = 12345;
+	memset(&bench->game, 0, sizeof(Game));
+	bench->game.n = n;
+	bench->game.m = m;
+	bench->numCells = N*N;
+	bench->sink = 0;
+	bench->game.board = (Cell**)calloc(N, sizeof(Cell*));
+	if(bench->game.board == NULL)
+		return 0;
+	for(row = 0; row < N; row++){
+		bench->game.board[row] = (Cell*)calloc(N, sizeof(Cell));
+		if(bench->game.board[row] == NULL)
+			return 0;
+		for(col = 0; col < N; col++){
+			state = state*6364136223846793005UL + 1442695040888963407UL;
+			if((state >> 33) & 1)
+				bench->game.board[row][col].value = ((row % n)*m + row/n + col) % N + 1;
+		}
+	}
+	return getGeometry(n, m) != NULL;
+}
+
+static void freeBench(Bench *bench){
+	int row;
+	if(bench->game.board == NULL)
+		return;
+	for(row = 0; row < bench->game.n*bench->game.m; row++)
+		free(bench->game.board[row]);
+	free(bench->game.board);
+}
+
+/* the primitives, each runs ops calls spread over the cells, units and values of the board */
+static void runIsSafe(Bench *bench, long ops){
+	int N = bench->game.n*bench->game.m;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++)
+		sum += isSafe(&bench->game, (int)(i % bench->numCells)/N, (int)(i % bench->numCells)%N, (int)(i % N) + 1);
+	bench->sink += sum;
+}
+
+static void runSetOptionalValues(Bench *bench, long ops){
+	int N = bench->game.n*bench->game.m, cell;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++){
+		cell = (int)(i % bench->numCells);
+		setOptionalValues(&bench->game, cell/N, cell%N);
+		sum += bench->game.board[cell/N][cell%N].numOfOptionalValues;
+	}
+	bench->sink += sum;
+}
+
+static void runInstancesInRow(Bench *bench, long ops){
+	int N = bench->game.n*bench->game.m;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++)
+		sum += instancesInRow(&bench->game, (int)(i % N), (int)((i/N) % N) + 1);
+	bench->sink += sum;
+}
+
+static void runInstancesInCol(Bench *bench, long ops){
+	int N = bench->game.n*bench->game.m;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++)
+		sum += instancesInCol(&bench->game, (int)(i % N), (int)((i/N) % N) + 1);
+	bench->sink += sum;
+}
+
+static void runInstancesInBox(Bench *bench, long ops){
+	int N = bench->game.n*bench->game.m;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++)
+		sum += instancesInBox(&bench->game, (int)(i % N), (int)((i/N) % N) + 1);
+	bench->sink += sum;
+}
+
+static void runFindUnassignedLocation(Bench *bench, long ops){
+	long i, sum = 0;
+	for(i = 0; i < ops; i++)
+		sum += findUnassignedLocation(&bench->game);
+	bench->sink += sum;
+}
+
+/* fixOpptions takes the first option of the first empty cells until they run out of options, then they get back
+ * the options setOptionalValues gave them. a cell keeps 7 options at most, since fixOpptions reads one past the last */
+static void runFixOpptions(Bench *bench, long ops){
+	Cell **board = bench->game.board;
+	int N = bench->game.n*bench->game.m, k = 0;
+	long i, sum = 0;
+	for(i = 0; i < ops; i++){
+		if(board[0][k].numOfOptionalValues == 0)
+			board[0][k] = bench->saved[k];
+		fixOpptions(board, 0, k, 0);
+		sum += board[0][k].optionalValues[0];
+		k = (k+1) % (N < 9 ? N : 9);
+	}
+	bench->sink += sum;
+}
+
+static void prepareFixOpptions(Bench *bench){
+	int N = bench->game.n*bench->game.m, k;
+	for(k = 0; k < (N < 9 ? N : 9); k++){
+		setOptionalValues(&bench->game, 0, k);
+		if(bench->game.board[0][k].numOfOptionalValues > 7)
+			bench->game.board[0][k].numOfOptionalValues = 7;
+		if(bench->game.board[0][k].numOfOptionalValues == 0)
+			bench->game.board[0][k].numOfOptionalValues = 1;
+		bench->saved[k] = bench->game.board[0][k];
+	}
+}
+
+#ifdef BENCH_PRINT_BOARD
+static void runPrintBoard(Bench *bench, long ops){
+	long i;
+	for(i = 0; i < ops; i++)
+		printBoard(&bench->game);
+	fflush(stdout);
+}
+#endif
+
+typedef struct Primitive{
+	const char *name;
+	void (*run)(Bench *bench, long ops);
+	int minN; /* the smallest side the primitive handles */
+	long opsDivisor; /* printBoard is far slower than the rest, it runs fewer calls */
+}Primitive;
+
+static const Primitive primitives[] = {
+	{"isSafe", runIsSafe, 1, 1},
+	{"setOptionalValues", runSetOptionalValues, 1, 1},
+	{"instancesInRow", runInstancesInRow, 1, 1},
+	{"instancesInCol", runInstancesInCol, 1, 1},
+	{"instancesInBox", runInstancesInBox, 1, 1},
+	{"findUnassignedLocation", runFindUnassignedLocation, 1, 1},
+	{"fixOpptions", runFixOpptions, 1, 1},
+#ifdef BENCH_PRINT_BOARD
+	{"printBoard", runPrintBoard, 1, 1000},
+#endif
+};
+#define NUM_PRIMITIVES ((int)(sizeof(primitives)/sizeof(Primitive)))
+
+static int compareDoubles(const void *a, const void *b){
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+static double median(double *values, int count){
+	qsort(values, count, sizeof(double), compareDoubles);
+	return count % 2 ? values[count/2] : (values[count/2-1] + values[count/2])/2;
+}
+
+/* measure the primitive on the board and print its JSON object */
+static void measure(FILE *out, Bench *bench, const Primitive *primitive, Counters *counters, int reps, long ops, int first){
+	Sample samples[MAX_REPS];
+	double times[MAX_REPS], deviations[MAX_REPS], med, mad, total[NUM_COUNTERS], seconds = 0;
+	int i, c, kept = 0, saved = -1;
+	memset(samples, 0, sizeof(samples));
+	ops /= primitive->opsDivisor;
+	if(ops < 1)
+		ops = 1;
+#ifdef BENCH_PRINT_BOARD
+	/* printBoard writes to stdout, which is sent to /dev/null while it runs */
+	if(primitive->run == runPrintBoard){
+		fflush(stdout);
+		saved = dup(STDOUT_FILENO);
+		i = open("/dev/null", O_WRONLY);
+		dup2(i, STDOUT_FILENO);
+		close(i);
+	}
+#endif
+	for(i = 0; i < WARMUP_BATCHES; i++)
+		primitive->run(bench, ops);
+	for(i = 0; i < reps; i++){
+		startCounters(counters);
+		samples[i].seconds = now();
+		primitive->run(bench, ops);
+		samples[i].seconds = now() - samples[i].seconds;
+		stopCounters(counters, &samples[i]);
+		times[i] = samples[i].seconds;
+	}
+	if(saved >= 0){
+		fflush(stdout);
+		dup2(saved, STDOUT_FILENO);
+		close(saved);
+	}
+	/* reject the batches whose time is more than OUTLIER_MADS median absolute deviations from the median */
+	med = median(times, reps);
+	for(i = 0; i < reps; i++)
+		deviations[i] = samples[i].seconds > med ? samples[i].seconds - med : med - samples[i].seconds;
+	mad = median(deviations, reps);
+	memset(total, 0, sizeof(total));
+	for(i = 0; i < reps; i++){
+		if(mad > 0 && (samples[i].seconds > med ? samples[i].seconds - med : med - samples[i].seconds) > OUTLIER_MADS*mad)
+			continue;
+		kept++;
+		seconds += samples[i].seconds;
+		for(c = 0; c < NUM_COUNTERS; c++)
+			total[c] += samples[i].counts[c];
+	}
+	fprintf(out, "%s\n    {\"primitive\": \"%s\", \"n\": %d, \"m\": %d, \"ops\": %ld, \"reps\": %d, \"kept\": %d, \"ns_per_op\": %.3f",
+			first ? "" : ",", primitive->name, bench->game.n, bench->game.m, ops, reps, kept, seconds*1e9/((double)kept*ops));
+	for(c = 0; c < NUM_COUNTERS; c++){
+		if(counters->available)
+			fprintf(out, ", \"%s_per_op\": %.3f", counterNames[c], total[c]/((double)kept*ops));
+		else
+			fprintf(out, ", \"%s_per_op\": null", counterNames[c]);
+	}
+	if(counters->available && total[0] > 0)
+		fprintf(out, ", \"ipc\": %.3f}", total[1]/total[0]);
+	else
+		fprintf(out, ", \"ipc\": null}");
+}
+
+int main(int argc, char *argv[]){
+	Counters counters;
+	Bench bench;
+	FILE *out = stdout;
+	int reps = DEFAULT_REPS, g, p, i, first = 1;
+	long ops = DEFAULT_OPS;
+	for(i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--reps") == 0 && i+1 < argc)
+			reps = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--ops") == 0 && i+1 < argc)
+			ops = atol(argv[++i]);
+		else if(strcmp(argv[i], "--out") == 0 && i+1 < argc){
+			out = fopen(argv[++i], "w");
+			if(out == NULL){
+				printf("Error: can't open %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else{
+			printf("usage: benchPrimitives [--reps k] [--ops k] [--out file]\n");
+			return 1;
+		}
+	}
+	if(reps < 1 || reps > MAX_REPS || ops < 1){
+		printf("Error: --reps must be 1 to %d and --ops positive\n", MAX_REPS);
+		return 1;
+	}
+	openCounters(&counters);
+	fprintf(out, "{\n  \"counters\": %s,\n  \"results\": [", counters.available ? "true" : "false");
+	for(g = 0; g < NUM_GEOMETRIES; g++){
+		if(!initBench(&bench, geometries[g][0], geometries[g][1])){
+			printf("Error: calloc has failed\n");
+			freeBench(&bench);
+			return 1;
+		}
+		prepareFixOpptions(&bench);
+		for(p = 0; p < NUM_PRIMITIVES; p++){
+			if(bench.game.n*bench.game.m < primitives[p].minN)
+				continue;
+			measure(out, &bench, &primitives[p], &counters, reps, ops, first);
+			first = 0;
+		}
+		freeBench(&bench);
+	}
+	fprintf(out, "\n  ]\n}\n");
+	closeCounters(&counters);
+	freeGeometries();
+	if(out != stdout)
+		fclose(out);
+	return 0;
+}
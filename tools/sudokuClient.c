@@ -0,0 +1,173 @@
+/* Client Tool
+ * a small client of the solver daemon (main.c --serve <socket>), for testing and timing it.
+ * usage: sudokuClient <socket> <solve|validate|hint|count|generate> [--args a b] [--timeout ms] [--repeat k] [board file]
+ * the board is read from the file (or stdin) in the format of the save command: "n m" and then N*N values
+ * (a '.' after a value is ignored). a file with only "n m" is an empty board.
+ * with --repeat the request is sent k times without waiting for the responses, and the time per request is printed.
+ * it is built on its own, e.g. gcc -I.. sudokuClient.c -o sudokuClient
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "protocol.h"
+
+static const char *opNames[] = {"", "solve", "validate", "hint", "count", "generate"};
+static const char *statusNames[] = {"ok", "unsolvable", "erroneous", "bad request", "error", "stopped"};
+
+/* read the board, returns 0 on a format error */
+static int readBoard(FILE *file, int *n, int *m, unsigned char *grid){
+	char value[20];
+	int N, i = 0, v;
+	if(fscanf(file, "%d %d", n, m) != 2 || *n <= 0 || *m <= 0 || (*n)*(*m) > PROTOCOL_MAX_N)
+		return 0;
+	N = (*n)*(*m);
+	memset(grid, 0, N*N);
+	while(i < N*N && fscanf(file, "%19s", value) == 1){
+		v = atoi(value);
+		if(v < 0 || v > N)
+			return 0;
+		grid[i++] = (unsigned char)v;
+	}
+	return i == 0 || i == N*N;
+}
+
+static void printBoardGrid(int n, int m, unsigned char *grid){
+	int row, col, N = n*m;
+	printf("%d %d\n", n, m);
+	for(row = 0; row < N; row++){
+		for(col = 0; col < N; col++)
+			printf(col < N-1 ? "%d " : "%d\n", grid[row*N + col]);
+	}
+}
+
+static int readFully(int fd, void *buf, size_t len){
+	ssize_t r;
+	size_t done = 0;
+	while(done < len){
+		r = read(fd, (char*)buf + done, len - done);
+		if(r <= 0)
+			return 0;
+		done += r;
+	}
+	return 1;
+}
+
+static int writeFully(int fd, const void *buf, size_t len){
+	ssize_t w;
+	size_t done = 0;
+	while(done < len){
+		w = write(fd, (const char*)buf + done, len - done);
+		if(w <= 0)
+			return 0;
+		done += w;
+	}
+	return 1;
+}
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+int main(int argc, char *argv[]){
+	RequestHeader header;
+	ResponseHeader response;
+	struct sockaddr_un address;
+	unsigned char grid[PROTOCOL_MAX_N*PROTOCOL_MAX_N], frame[PROTOCOL_MAX_FRAME + 4];
+	unsigned char answer[PROTOCOL_MAX_N*PROTOCOL_MAX_N];
+	uint32_t len;
+	int fd, n, m, N, i, op = 0, repeat = 1, failed = 0;
+	char *boardPath = NULL;
+	FILE *file = stdin;
+	double start;
+	if(argc < 3){
+		printf("usage: %s <socket> <solve|validate|hint|count|generate> [--args a b] [--timeout ms] [--repeat k] [board file]\n", argv[0]);
+		return 1;
+	}
+	memset(&header, 0, sizeof(header));
+	for(i = 1; i <= OP_GENERATE; i++){
+		if(strcmp(argv[2], opNames[i]) == 0)
+			op = i;
+	}
+	if(op == 0){
+		printf("Error: unknown operation %s\n", argv[2]);
+		return 1;
+	}
+	for(i = 3; i < argc; i++){
+		if(strcmp(argv[i], "--args") == 0 && i+2 < argc){
+			header.args[0] = atoi(argv[++i]);
+			header.args[1] = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--timeout") == 0 && i+1 < argc)
+			header.timeoutMs = (uint32_t)atol(argv[++i]);
+		else if(strcmp(argv[i], "--repeat") == 0 && i+1 < argc)
+			repeat = atoi(argv[++i]);
+		else
+			boardPath = argv[i];
+	}
+	if(boardPath != NULL && (file = fopen(boardPath, "r")) == NULL){
+		printf("Error: could not open %s\n", boardPath);
+		return 1;
+	}
+	if(!readBoard(file, &n, &m, grid)){
+		printf("Error: the board is not in the right format\n");
+		return 1;
+	}
+	if(file != stdin)
+		fclose(file);
+	N = n*m;
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+	if(fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0){
+		perror("Error: could not connect to the server");
+		return 1;
+	}
+	header.op = (uint8_t)op;
+	header.n = (uint8_t)n;
+	header.m = (uint8_t)m;
+	len = sizeof(header) + N*N;
+	start = now();
+	/* the requests go out from a child process so a long pipeline can't fill both socket buffers and stall */
+	if(fork() == 0){
+		for(i = 0; i < repeat; i++){
+			header.id = (uint32_t)i;
+			memcpy(frame, &len, sizeof(len));
+			memcpy(frame + sizeof(len), &header, sizeof(header));
+			memcpy(frame + sizeof(len) + sizeof(header), grid, N*N);
+			if(!writeFully(fd, frame, sizeof(len) + len))
+				_exit(1);
+		}
+		_exit(0);
+	}
+	for(i = 0; i < repeat; i++){
+		if(!readFully(fd, &len, sizeof(len)) || len < sizeof(response) || len > sizeof(response) + sizeof(answer)
+				|| !readFully(fd, &response, sizeof(response)) || !readFully(fd, answer, len - sizeof(response))){
+			printf("Error: the server closed the connection\n");
+			return 1;
+		}
+		if(response.status != 0)
+			failed++;
+		if(i == 0){
+			printf("%s: %s", opNames[op], response.status <= 5 ? statusNames[response.status] : "unknown");
+			if(op == OP_VALIDATE || op == OP_HINT || op == OP_COUNT)
+				printf(", value %lld", (long long)response.value);
+			printf("\n");
+			if(response.hasGrid)
+				printBoardGrid(response.n, response.m, answer);
+		}
+	}
+	if(repeat > 1)
+		printf("%d requests (%d not ok) in %.3f seconds, %.1f microseconds per request\n", repeat, failed,
+				now() - start, (now() - start)*1e6/repeat);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "trace.h"
+#include "control.h"
+
+/* Trace Module
+ * every thread finds its ring through a thread key and is the only one writing to it: an event is written to the slot
+ * of head and only then head moves on, so recording takes no lock. the rings are linked in a list (the lock is taken
+ * only when a thread records its first event) and a ring whose thread has exited is handed to the next new thread, so
+ * the short lived threads of the portfolio and the estimator don't take a ring each. such threads share a row of the
+ * timeline, one after the other.
+ */
+
+typedef struct TraceRecord{
+	const char *name;
+	double time; /* seconds of the monotonic clock */
+	char phase;
+}TraceRecord;
+
+typedef struct TraceRing{
+	int tid;
+	int owned; /* 1 while a living thread records into the ring */
+	volatile unsigned long head; /* the number of events ever recorded, the newest is at head-1 */
+	TraceRecord records[TRACE_RING_EVENTS];
+	struct TraceRing *next;
+}TraceRing;
+
+volatile int traceEnabled = 0;
+static FILE *traceFile = NULL;
+static double traceStart;
+static TraceRing *rings = NULL;
+static int numRings = 0;
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ringKey;
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+
+/* called when a thread that recorded events exits, its events stay for closeTrace */
+static void releaseRing(void *arg){
+	TraceRing *ring = (TraceRing*)arg;
+	pthread_mutex_lock(&ringLock);
+	ring->owned = 0;
+	pthread_mutex_unlock(&ringLock);
+}
+
+static void createKey(){
+	pthread_key_create(&ringKey, releaseRing);
+}
+
+/* the ring of the calling thread, taking a free ring or allocating one the first time. NULL on a memory error */
+static TraceRing* threadRing(){
+	TraceRing *ring;
+	pthread_once(&keyOnce, createKey);
+	ring = (TraceRing*)pthread_getspecific(ringKey);
+	if(ring != NULL)
+		return ring;
+	pthread_mutex_lock(&ringLock);
+	for(ring = rings; ring != NULL && ring->owned; ring = ring->next);
+	if(ring == NULL){
+		ring = (TraceRing*)malloc(sizeof(TraceRing));
+		if(ring != NULL){
+			ring->tid = ++numRings;
+			ring->head = 0;
+			ring->next = rings;
+			rings = ring;
+		}
+	}
+	if(ring != NULL)
+		ring->owned = 1;
+	pthread_mutex_unlock(&ringLock);
+	if(ring != NULL)
+		pthread_setspecific(ringKey, ring);
+	return ring;
+}
+
+int openTrace(const char *path){
+	traceFile = fopen(path, "w");
+	if(traceFile == NULL){
+		printf("Error: can't open the trace file %s\n", path);
+		return 0;
+	}
+	traceStart = monotonicSeconds();
+	traceEnabled = 1;
+	return 1;
+}
+
+void traceEvent(const char *name, char phase){
+	TraceRing *ring = threadRing();
+	TraceRecord *record;
+	if(ring == NULL)
+		return;
+	record = &ring->records[ring->head & (TRACE_RING_EVENTS-1)];
+	record->name = name;
+	record->phase = phase;
+	record->time = monotonicSeconds();
+	ring->head++;
+}
+
+/* the events of one ring, oldest first. the end events of scopes whose begin was overwritten are left out,
+ * since a viewer would close the wrong scope with them */
+static int writeRing(TraceRing *ring, int first){
+	unsigned long head = ring->head, i, start;
+	int depth = 0;
+	TraceRecord *record;
+	start = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+	for(i = start; i < head; i++){
+		record = &ring->records[i & (TRACE_RING_EVENTS-1)];
+		if(record->phase == 'E' && depth == 0 && start > 0)
+			continue;
+		depth += record->phase == 'B' ? 1 : (depth > 0 ? -1 : 0);
+		fprintf(traceFile, "%s\n{\"name\":\"%s\",\"cat\":\"sudoku\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+				first ? "" : ",", record->name, record->phase, (record->time - traceStart)*1e6, ring->tid);
+		first = 0;
+	}
+	return first;
+}
+
+void closeTrace(){
+	TraceRing *ring, *next, *kept = NULL;
+	int first = 1;
+	if(traceFile == NULL)
+		return;
+	traceEnabled = 0;
+	fprintf(traceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	pthread_mutex_lock(&ringLock);
+	for(ring = rings; ring != NULL; ring = next){
+		next = ring->next;
+		first = writeRing(ring, first);
+		if(ring->owned){
+			/* the ring of a living thread stays its, empty */
+			ring->head = 0;
+			ring->next = kept;
+			kept = ring;
+		}
+		else
+			free(ring);
+	}
+	rings = kept;
+	pthread_mutex_unlock(&ringLock);
+	fprintf(traceFile, "\n]}\n");
+	fclose(traceFile);
+	traceFile = NULL;
+}
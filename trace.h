@@ -0,0 +1,34 @@
+/* Header file of the trace module. Records where the time of a session goes - the commands, the parsing, the solvers,
+ * the model building and optimization of gurobi.c and the board files - as begin and end events of named scopes.
+ * Every thread records into a ring buffer of its own, without locks, and when the ring is full the oldest events are
+ * overwritten. closeTrace writes all the rings to the file given to openTrace in the Chrome trace-event JSON format,
+ * which trace viewers (chrome://tracing, Perfetto) open as a timeline per thread.
+ * Names are kept by pointer, so they have to be string literals (or otherwise live until closeTrace).
+ * The macros do nothing until openTrace is called, and compile to nothing with -DSUDOKU_NO_TRACE.*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#define TRACE_RING_EVENTS 65536 /* the events every thread keeps, a power of 2 */
+
+#ifndef SUDOKU_NO_TRACE
+#define TRACE_BEGIN(name) do{ if(traceEnabled) traceEvent((name), 'B'); }while(0)
+#define TRACE_END(name) do{ if(traceEnabled) traceEvent((name), 'E'); }while(0)
+#else
+#define TRACE_BEGIN(name) do{ }while(0)
+#define TRACE_END(name) do{ }while(0)
+#endif
+
+/* 1 while a trace is open, read by the macros before anything else */
+extern volatile int traceEnabled;
+
+/* start tracing into the file at path, which is written by closeTrace. returns 1 on success and 0 if it can't be opened */
+int openTrace(const char *path);
+
+/* stop tracing and write the events of all the threads to the file, does nothing if no trace is open */
+void closeTrace();
+
+/* record the begin ('B') or the end ('E') of the scope name on the ring of the calling thread */
+void traceEvent(const char *name, char phase);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,115 @@
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include "worker.h"
+#include "trace.h"
+#include "metrics.h"
+
+/* Worker Module
+ * runs one solver command at a time on a background thread.
+ * the command loop only starts, queries, cancels and joins the job - the board itself
+ * belongs to the job until it finishes (the command loop rejects board commands meanwhile).
+ */
+
+/* the job SIGINT cancels */
+static Job *interruptibleJob = NULL;
+
+void initJob(Job *job){
+	memset(job, 0, sizeof(Job));
+	pthread_mutex_init(&job->lock, NULL);
+}
+
+/* the body of the worker thread */
+static void* jobThread(void *arg){
+	Job *job = (Job*)arg;
+	TRACE_BEGIN(job->name);
+	job->run(job);
+	TRACE_END(job->name);
+	recordLatency(job->name, monotonicSeconds() - job->startTime);
+	pthread_mutex_lock(&job->lock);
+	job->running = 0;
+	pthread_mutex_unlock(&job->lock);
+	return NULL;
+}
+
+int startJob(Job *job, Game *game, const char *name, const char *progressName, int *args, double timeout, void (*run)(Job *job)){
+	if(jobRunning(job))
+		return 0;
+	waitJob(job);
+	job->name = name;
+	job->progressName = progressName;
+	memcpy(job->args, args, sizeof(job->args));
+	job->game = game;
+	job->run = run;
+	initControl(&job->control, timeout);
+	job->startTime = monotonicSeconds();
+	job->running = 1;
+	if(pthread_create(&job->thread, NULL, jobThread, job) != 0){
+		job->running = 0;
+		printf("Error: could not start a worker thread\n");
+		return 0;
+	}
+	job->joinable = 1;
+	return 1;
+}
+
+int jobRunning(Job *job){
+	int running;
+	pthread_mutex_lock(&job->lock);
+	running = job->running;
+	pthread_mutex_unlock(&job->lock);
+	return running;
+}
+
+void cancelJob(Job *job){
+	if(!jobRunning(job)){
+		printf("Error: no command is running\n");
+		return;
+	}
+	job->control.cancelled = 1;
+	printf("Cancelling %s...\n", job->name);
+}
+
+void waitJob(Job *job){
+	if(job->joinable){
+		pthread_join(job->thread, NULL);
+		job->joinable = 0;
+	}
+}
+
+void printJobStatus(Job *job){
+	if(!jobRunning(job)){
+		printf("No command is running\n");
+		return;
+	}
+	printf("%s is running for %.1f seconds", job->name, monotonicSeconds() - job->startTime);
+	if(job->progressName != NULL)
+		printf(", %ld %s so far", job->control.progress, job->progressName);
+	if(job->control.deadline > 0)
+		printf(", %.1f seconds left", remainingTime(&job->control));
+	printf("\n");
+}
+
+/* SIGINT handler - only touches the cancel flag, which is safe from a signal handler */
+static void onInterrupt(int sig){
+	if(interruptibleJob != NULL && interruptibleJob->running){
+		interruptibleJob->control.cancelled = 1;
+		return;
+	}
+	/* nothing to cancel - behave as if there was no handler */
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+void installInterruptHandler(Job *job){
+	struct sigaction action;
+	interruptibleJob = job;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onInterrupt;
+	sigemptyset(&action.sa_mask);
+	/* don't let the signal break the fgets of the command loop */
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGINT, &action, NULL);
+}
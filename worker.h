@@ -0,0 +1,48 @@
+/* Header file of the worker module. Long solver commands (validate, hint, generate, num_solutions) run on a worker thread,
+ * so the command loop keeps reading input while they run and the user can query them with status or stop them with cancel.
+ * At most one job runs at a time. The job prints its own result when it finishes.*/
+
+#ifndef WORKER_H_
+#define WORKER_H_
+#include <pthread.h>
+#include "game.h"
+#include "control.h"
+
+typedef struct Job{
+	pthread_t thread;
+	pthread_mutex_t lock; /* protects running */
+	int running; /* 1 while the worker thread runs the job */
+	int joinable; /* 1 if a finished thread wasn't joined yet */
+	const char *name; /* the name of the command, for status */
+	const char *progressName; /* what control.progress counts, NULL if the command reports no progress */
+	int args[3]; /* the arguments of the command, as parsed */
+	Game *game;
+	SolveControl control;
+	double startTime;
+	void (*run)(struct Job *job);
+}Job;
+
+/* initialize an idle job */
+void initJob(Job *job);
+
+/* run the command on a worker thread with a time budget of timeout seconds (0 for none).
+ * returns 1 if the job was started, 0 if another job is still running or the thread couldn't be created */
+int startJob(Job *job, Game *game, const char *name, const char *progressName, int *args, double timeout, void (*run)(Job *job));
+
+/* returns 1 if the job is still running, 0 otherwise */
+int jobRunning(Job *job);
+
+/* ask the running job to stop, it reports its partial result when it does */
+void cancelJob(Job *job);
+
+/* wait until the job finishes */
+void waitJob(Job *job);
+
+/* print what runs in the background, for how long, and its progress */
+void printJobStatus(Job *job);
+
+/* make SIGINT cancel the running job of the command loop instead of killing the process.
+ * when no job runs, SIGINT keeps its default behavior */
+void installInterruptHandler(Job *job);
+
+#endif /* WORKER_H_ */